@@ -0,0 +1,91 @@
+#include "async_executor.h"
+
+#include <thread>
+
+constexpr std::size_t AsyncExecutor::default_max_idle_threads;
+constexpr std::chrono::milliseconds AsyncExecutor::default_idle_timeout;
+
+AsyncExecutor::AsyncExecutor(std::size_t max_idle_threads_, std::chrono::milliseconds idle_timeout_)
+    : max_idle_threads(max_idle_threads_)
+    , idle_timeout(idle_timeout_)
+{
+}
+
+AsyncExecutor::~AsyncExecutor() {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopping = true;
+    jobs_cv.notify_all();
+    threads_cv.wait(lock, [this] { return num_threads == 0; });
+}
+
+AsyncExecutor & AsyncExecutor::getInstance() {
+    // Never destroyed: at exit, or when the library is unloaded, the worker threads may still be blocked on the server,
+    // or, on Windows, already be terminated without ever reporting their exit, so waiting for them could hang forever.
+    static auto * executor = new AsyncExecutor;
+    return *executor;
+}
+
+std::future<SQLRETURN> AsyncExecutor::submit(Task && task, CompletionHandler && on_complete) {
+    Job job{std::packaged_task<SQLRETURN ()>(std::move(task)), std::move(on_complete)};
+    auto result = job.task.get_future();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Every idle thread takes one of the queued jobs, the rest of them need new threads.
+    if (jobs.size() + 1 > num_idle_threads) {
+        std::thread([this] { workerLoop(); }).detach();
+        ++num_threads;
+    }
+
+    jobs.push_back(std::move(job));
+    jobs_cv.notify_one();
+
+    return result;
+}
+
+std::size_t AsyncExecutor::getNumThreads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_threads;
+}
+
+std::size_t AsyncExecutor::getNumIdleThreads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_idle_threads;
+}
+
+void AsyncExecutor::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        if (jobs.empty()) {
+            if (stopping || num_idle_threads >= max_idle_threads)
+                break;
+
+            ++num_idle_threads;
+            const bool has_work = jobs_cv.wait_for(lock, idle_timeout, [this] { return stopping || !jobs.empty(); });
+            --num_idle_threads;
+
+            if (!has_work)
+                break;
+
+            continue;
+        }
+
+        {
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+
+            job.task();
+
+            // Only now, so that the notified application finds the result ready.
+            if (job.on_complete)
+                job.on_complete();
+        }
+
+        lock.lock();
+    }
+
+    --num_threads;
+    threads_cv.notify_all();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "platform.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+
+/// Process-wide pool of worker threads that run the asynchronously executed statement functions.
+/// A function blocks its thread while it waits for the server, so a thread is started whenever there is no idle one,
+/// and the number of threads follows the number of functions in progress, not the number of statements. Threads are
+/// reused by the following functions, and exit after staying idle for a while.
+/// This is not an I/O reactor: the HTTP client blocks, so each function in progress still takes a thread of its own.
+class AsyncExecutor {
+public:
+    using Task = std::function<SQLRETURN ()>;
+    using CompletionHandler = std::function<void ()>;
+
+    /// Idle threads kept waiting for work, the rest exit right away.
+    static constexpr std::size_t default_max_idle_threads = 8;
+
+    static constexpr std::chrono::milliseconds default_idle_timeout{10000};
+
+    explicit AsyncExecutor(
+        std::size_t max_idle_threads_ = default_max_idle_threads,
+        std::chrono::milliseconds idle_timeout_ = default_idle_timeout
+    );
+
+    /// Waits for the tasks in progress to finish.
+    ~AsyncExecutor();
+
+    AsyncExecutor(const AsyncExecutor &) = delete;
+    AsyncExecutor & operator= (const AsyncExecutor &) = delete;
+
+    /// The executor shared by all statements, which is never destroyed, so nothing waits for its threads at exit.
+    static AsyncExecutor & getInstance();
+
+    /// Run 'task' in a worker thread. 'on_complete', if any, is called in the same thread once the result of the task
+    /// has been made available through the returned future, and must not throw.
+    std::future<SQLRETURN> submit(Task && task, CompletionHandler && on_complete = CompletionHandler{});
+
+    std::size_t getNumThreads() const;
+    std::size_t getNumIdleThreads() const;
+
+private:
+    struct Job {
+        std::packaged_task<SQLRETURN ()> task;
+        CompletionHandler on_complete;
+    };
+
+    void workerLoop();
+
+private:
+    const std::size_t max_idle_threads;
+    const std::chrono::milliseconds idle_timeout;
+
+    mutable std::mutex mutex;
+    std::condition_variable jobs_cv;
+    std::condition_variable threads_cv; // Signalled when a thread exits.
+    std::deque<Job> jobs;
+    std::size_t num_threads = 0;
+    std::size_t num_idle_threads = 0;
+    bool stopping = false;
+};
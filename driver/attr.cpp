@@ -88,11 +88,7 @@ SQLRETURN SetConnectAttr(
             case SQL_ATTR_CONNECTION_TIMEOUT: {
                 auto connection_timeout = static_cast<SQLUSMALLINT>(reinterpret_cast<intptr_t>(value));
                 LOG("Set connection timeout: " << connection_timeout);
-                connection.connection_timeout = connection.timeout;
-                if (connection.session)
-                    connection.session->setTimeout(Poco::Timespan(connection.connection_timeout, 0),
-                        Poco::Timespan(connection.timeout, 0),
-                        Poco::Timespan(connection.timeout, 0));
+                connection.connection_timeout = connection.timeout; // Applied to sessions as they are leased by statements.
                 return SQL_SUCCESS;
             }
 
@@ -136,8 +132,11 @@ SQLRETURN SetConnectAttr(
                 connection.setAttr(SQL_ATTR_METADATA_ID, value);
                 return SQL_SUCCESS;
 
+            case SQL_ATTR_ASYNC_ENABLE: // The default for the statements allocated afterwards.
+                connection.setAttr(SQL_ATTR_ASYNC_ENABLE, reinterpret_cast<SQLULEN>(value));
+                return SQL_SUCCESS;
+
             case SQL_ATTR_ACCESS_MODE:
-            case SQL_ATTR_ASYNC_ENABLE:
             case SQL_ATTR_AUTO_IPD:
             case SQL_ATTR_AUTOCOMMIT:
             case SQL_ATTR_CONNECTION_DEAD:
@@ -176,7 +175,7 @@ SQLRETURN GetConnectAttr(
             CASE_NUM(SQL_ATTR_CONNECTION_DEAD, SQLUINTEGER, SQL_CD_FALSE);
             CASE_FALLTHROUGH(SQL_ATTR_CONNECTION_TIMEOUT);
             CASE_NUM(
-                SQL_ATTR_LOGIN_TIMEOUT, SQLUSMALLINT, connection.session ? connection.session->getTimeout().seconds() : connection.timeout);
+                SQL_ATTR_LOGIN_TIMEOUT, SQLUSMALLINT, connection.timeout);
             CASE_NUM(SQL_ATTR_TXN_ISOLATION, SQLINTEGER, SQL_TXN_SERIALIZABLE); // mssql linked server
             CASE_NUM(SQL_ATTR_AUTOCOMMIT, SQLINTEGER, SQL_AUTOCOMMIT_ON);
             CASE_NUM(SQL_ATTR_TRACE, SQLINTEGER, (connection.getDriver().isLoggingEnabled() ? SQL_OPT_TRACE_ON : SQL_OPT_TRACE_OFF));
@@ -200,8 +199,13 @@ SQLRETURN GetConnectAttr(
                     out_value, SQLINTEGER{0}/* out_value_max_length */, out_value_length
                 );
 
-            case SQL_ATTR_ACCESS_MODE:
             case SQL_ATTR_ASYNC_ENABLE:
+                return fillOutputNumber<SQLULEN>(
+                    connection.getAttrAs<SQLULEN>(SQL_ATTR_ASYNC_ENABLE, SQL_ASYNC_ENABLE_OFF),
+                    out_value, SQLINTEGER{0}/* out_value_max_length */, out_value_length
+                );
+
+            case SQL_ATTR_ACCESS_MODE:
             case SQL_ATTR_AUTO_IPD:
             case SQL_ATTR_ODBC_CURSORS:
             case SQL_ATTR_PACKET_SIZE:
@@ -311,23 +315,67 @@ SQLRETURN SetStmtAttr(
                 statement.setAttr(SQL_ATTR_METADATA_ID, value);
                 return SQL_SUCCESS;
 
+            case SQL_ROWSET_SIZE:
+                if (reinterpret_cast<SQLULEN>(value) == 0)
+                    throw SqlException("Invalid attribute value", "HY024");
+                statement.setAttr(SQL_ROWSET_SIZE, reinterpret_cast<SQLULEN>(value));
+                return SQL_SUCCESS;
+
+            case SQL_ATTR_CH_READ_AHEAD_SIZE:
+                if (reinterpret_cast<SQLULEN>(value) == 0)
+                    throw SqlException("Invalid attribute value", "HY024");
+                statement.setAttr(SQL_ATTR_CH_READ_AHEAD_SIZE, reinterpret_cast<SQLULEN>(value));
+                return SQL_SUCCESS;
+
             case SQL_ATTR_APP_ROW_DESC:
             case SQL_ATTR_APP_PARAM_DESC:
             case SQL_ATTR_IMP_ROW_DESC:
             case SQL_ATTR_IMP_PARAM_DESC:
                 return setDescriptorHandle(statement, attribute, reinterpret_cast<SQLHANDLE>(value));
 
+            case SQL_ATTR_CURSOR_TYPE: { /// Libreoffice Base
+                const auto cursor_type = reinterpret_cast<SQLULEN>(value);
+                if (cursor_type == SQL_CURSOR_FORWARD_ONLY || cursor_type == SQL_CURSOR_STATIC) {
+                    statement.setAttr(SQL_ATTR_CURSOR_TYPE, cursor_type);
+                    return SQL_SUCCESS;
+                }
+
+                // Keyset-driven and dynamic cursors are substituted with static ones.
+                statement.setAttr(SQL_ATTR_CURSOR_TYPE, static_cast<SQLULEN>(SQL_CURSOR_STATIC));
+                statement.fillDiag("01S02", "Option value changed");
+                return SQL_SUCCESS_WITH_INFO;
+            }
+
             case SQL_ATTR_CURSOR_SCROLLABLE:
-            case SQL_ATTR_CURSOR_SENSITIVITY:
+                statement.setAttr(SQL_ATTR_CURSOR_TYPE, static_cast<SQLULEN>(
+                    reinterpret_cast<SQLULEN>(value) == SQL_SCROLLABLE ? SQL_CURSOR_STATIC : SQL_CURSOR_FORWARD_ONLY));
+                return SQL_SUCCESS;
+
+            case SQL_ATTR_MAX_ROWS:
+                statement.setAttr(SQL_ATTR_MAX_ROWS, reinterpret_cast<SQLULEN>(value));
+                return SQL_SUCCESS;
+
+            case SQL_ATTR_QUERY_TIMEOUT: // In seconds, 0 for no timeout.
+                statement.setAttr(SQL_ATTR_QUERY_TIMEOUT, reinterpret_cast<SQLULEN>(value));
+                return SQL_SUCCESS;
+
             case SQL_ATTR_ASYNC_ENABLE:
+                statement.setAttr(SQL_ATTR_ASYNC_ENABLE, reinterpret_cast<SQLULEN>(value));
+                return SQL_SUCCESS;
+
+#if defined(SQL_ATTR_ASYNC_STMT_PCALLBACK)
+            case SQL_ATTR_ASYNC_STMT_PCALLBACK:
+            case SQL_ATTR_ASYNC_STMT_PCONTEXT:
+                statement.setAttr(attribute, value);
+                return SQL_SUCCESS;
+#endif
+
+            case SQL_ATTR_CURSOR_SENSITIVITY:
             case SQL_ATTR_CONCURRENCY:
-            case SQL_ATTR_CURSOR_TYPE: /// Libreoffice Base
             case SQL_ATTR_ENABLE_AUTO_IPD:
             case SQL_ATTR_FETCH_BOOKMARK_PTR:
             case SQL_ATTR_KEYSET_SIZE:
             case SQL_ATTR_MAX_LENGTH:
-            case SQL_ATTR_MAX_ROWS:
-            case SQL_ATTR_QUERY_TIMEOUT:
             case SQL_ATTR_RETRIEVE_DATA:
             case SQL_ATTR_ROW_NUMBER:
             case SQL_ATTR_SIMULATE_CURSOR:
@@ -384,14 +432,23 @@ SQLRETURN GetStmtAttr(
 				return fillOutputNumber<SQLHANDLE>(statement.getEffectiveDescriptor(attribute).getHandle(),
                     out_value, SQLINTEGER{0}/* out_value_max_length */, out_value_length);
 
-            CASE_NUM(SQL_ATTR_CURSOR_SCROLLABLE, SQLULEN, SQL_NONSCROLLABLE);
+            CASE_NUM(SQL_ATTR_CURSOR_SCROLLABLE, SQLULEN,
+                (statement.getAttrAs<SQLULEN>(SQL_ATTR_CURSOR_TYPE, SQL_CURSOR_FORWARD_ONLY) == SQL_CURSOR_FORWARD_ONLY ? SQL_NONSCROLLABLE : SQL_SCROLLABLE));
             CASE_NUM(SQL_ATTR_CURSOR_SENSITIVITY, SQLULEN, SQL_INSENSITIVE);
-            CASE_NUM(SQL_ATTR_ASYNC_ENABLE, SQLULEN, SQL_ASYNC_ENABLE_OFF);
+            CASE_NUM(SQL_ATTR_ASYNC_ENABLE, SQLULEN, (statement.isAsyncEnabled() ? SQL_ASYNC_ENABLE_ON : SQL_ASYNC_ENABLE_OFF));
+
+#if defined(SQL_ATTR_ASYNC_STMT_PCALLBACK)
+            CASE_FALLTHROUGH(SQL_ATTR_ASYNC_STMT_PCALLBACK)
+            CASE_FALLTHROUGH(SQL_ATTR_ASYNC_STMT_PCONTEXT)
+                return fillOutputNumber<SQLPOINTER>(statement.getAttrAs<SQLPOINTER>(attribute, nullptr),
+                    out_value, SQLINTEGER{0}/* out_value_max_length */, out_value_length);
+#endif
+
             CASE_NUM(SQL_ATTR_CONCURRENCY, SQLULEN, SQL_CONCUR_READ_ONLY);
-            CASE_NUM(SQL_ATTR_CURSOR_TYPE, SQLULEN, SQL_CURSOR_FORWARD_ONLY);
+            CASE_NUM(SQL_ATTR_CURSOR_TYPE, SQLULEN, statement.getAttrAs<SQLULEN>(SQL_ATTR_CURSOR_TYPE, SQL_CURSOR_FORWARD_ONLY));
             CASE_NUM(SQL_ATTR_ENABLE_AUTO_IPD, SQLULEN, SQL_FALSE);
             CASE_NUM(SQL_ATTR_MAX_LENGTH, SQLULEN, 0);
-            CASE_NUM(SQL_ATTR_MAX_ROWS, SQLULEN, 0);
+            CASE_NUM(SQL_ATTR_MAX_ROWS, SQLULEN, statement.getAttrAs<SQLULEN>(SQL_ATTR_MAX_ROWS, 0));
 
             CASE_FALLTHROUGH(SQL_ATTR_METADATA_ID)
                 return fillOutputNumber<SQLULEN>(
@@ -408,7 +465,19 @@ SQLRETURN GetStmtAttr(
                     out_value, SQLINTEGER{0}/* out_value_max_length */, out_value_length
                 );
 
-            CASE_NUM(SQL_ATTR_QUERY_TIMEOUT, SQLULEN, 0);
+            CASE_FALLTHROUGH(SQL_ROWSET_SIZE)
+                return fillOutputNumber<SQLULEN>(
+                    statement.getAttrAs<SQLULEN>(SQL_ROWSET_SIZE, 1),
+                    out_value, SQLINTEGER{0}/* out_value_max_length */, out_value_length
+                );
+
+            CASE_FALLTHROUGH(SQL_ATTR_CH_READ_AHEAD_SIZE)
+                return fillOutputNumber<SQLULEN>(
+                    statement.getAttrAs<SQLULEN>(SQL_ATTR_CH_READ_AHEAD_SIZE, statement.getParent().read_ahead_size),
+                    out_value, SQLINTEGER{0}/* out_value_max_length */, out_value_length
+                );
+
+            CASE_NUM(SQL_ATTR_QUERY_TIMEOUT, SQLULEN, statement.getAttrAs<SQLULEN>(SQL_ATTR_QUERY_TIMEOUT, 0));
             CASE_NUM(SQL_ATTR_RETRIEVE_DATA, SQLULEN, SQL_RD_ON);
             CASE_NUM(SQL_ATTR_ROW_NUMBER, SQLULEN, statement.getCurrentRowNum());
             CASE_NUM(SQL_ATTR_USE_BOOKMARKS, SQLULEN, SQL_UB_OFF);
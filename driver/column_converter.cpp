@@ -0,0 +1,307 @@
+#include "column_converter.h"
+
+#include "driver.h"
+#include "utils.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+template <ValueEncoding Encoding> struct StoredType;
+template <> struct StoredType<ValueEncoding::Int8>    { using Type = int8_t; };
+template <> struct StoredType<ValueEncoding::Int16>   { using Type = int16_t; };
+template <> struct StoredType<ValueEncoding::Int32>   { using Type = int32_t; };
+template <> struct StoredType<ValueEncoding::Int64>   { using Type = int64_t; };
+template <> struct StoredType<ValueEncoding::UInt8>   { using Type = uint8_t; };
+template <> struct StoredType<ValueEncoding::UInt16>  { using Type = uint16_t; };
+template <> struct StoredType<ValueEncoding::UInt32>  { using Type = uint32_t; };
+template <> struct StoredType<ValueEncoding::UInt64>  { using Type = uint64_t; };
+template <> struct StoredType<ValueEncoding::Float32> { using Type = float; };
+template <> struct StoredType<ValueEncoding::Float64> { using Type = double; };
+
+/// Values of binary numeric encodings are copied as they are if the C type lays them out the same way, otherwise
+/// converted if the C type can hold them. Values it can not hold are reported by returning SQL_ERROR.
+template <ValueEncoding Encoding, typename T>
+RETCODE convertBinaryNumber(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    if (std::is_same<typename StoredType<Encoding>::Type, T>::value) {
+        if (out_value_size_or_indicator)
+            *out_value_size_or_indicator = sizeof(T);
+        if (out_value)
+            memcpy(out_value, field.data(), sizeof(T));
+        return SQL_SUCCESS;
+    }
+
+    T value = 0;
+    if (narrowNumber(field.getBinary<typename StoredType<Encoding>::Type>(), value) != ParseStatus::Ok)
+        return SQL_ERROR;
+
+    return fillOutputNumber<T>(value, out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+/// Integers are parsed as 64-bit ones first.
+template <typename T>
+struct ParsedType {
+    using Type = typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type;
+};
+
+template <> struct ParsedType<float>  { using Type = float; };
+template <> struct ParsedType<double> { using Type = double; };
+
+/// The value as the C type T, unless it is not a number, or the C type can not hold it.
+template <typename T>
+ParseStatus tryGetNumberAs(const Field & field, T & res) {
+    typename ParsedType<T>::Type value = 0;
+    const auto status = field.tryGetNumber(value);
+    if (status != ParseStatus::Ok)
+        return status;
+
+    return narrowNumber(value, res);
+}
+
+/// Text, and anything else that has to be interpreted by Field.
+/// Values that are not numbers, or do not fit into T, are reported by returning SQL_ERROR, without throwing.
+template <typename T>
+RETCODE convertNumber(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    T value = 0;
+    if (tryGetNumberAs(field, value) != ParseStatus::Ok)
+        return SQL_ERROR;
+
+    return fillOutputNumber<T>(value, out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+/// Why a converter to the numeric C type T returned SQL_ERROR for the value.
+template <typename T>
+ParseStatus getNumberConversionStatus(const Field & field) {
+    T value = 0;
+    return tryGetNumberAs(field, value);
+}
+
+template <typename T>
+ColumnConverter getNumberConverter(ValueEncoding encoding) {
+    switch (encoding) {
+        case ValueEncoding::Int8:    return &convertBinaryNumber<ValueEncoding::Int8, T>;
+        case ValueEncoding::Int16:   return &convertBinaryNumber<ValueEncoding::Int16, T>;
+        case ValueEncoding::Int32:   return &convertBinaryNumber<ValueEncoding::Int32, T>;
+        case ValueEncoding::Int64:   return &convertBinaryNumber<ValueEncoding::Int64, T>;
+        case ValueEncoding::UInt8:   return &convertBinaryNumber<ValueEncoding::UInt8, T>;
+        case ValueEncoding::UInt16:  return &convertBinaryNumber<ValueEncoding::UInt16, T>;
+        case ValueEncoding::UInt32:  return &convertBinaryNumber<ValueEncoding::UInt32, T>;
+        case ValueEncoding::UInt64:  return &convertBinaryNumber<ValueEncoding::UInt64, T>;
+        case ValueEncoding::Float32: return &convertBinaryNumber<ValueEncoding::Float32, T>;
+        case ValueEncoding::Float64: return &convertBinaryNumber<ValueEncoding::Float64, T>;
+        default:                     return &convertNumber<T>;
+    }
+}
+
+RETCODE convertBinaryDate(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    return fillOutputNumber<SQL_DATE_STRUCT>(
+        dateFromDays(field.getBinary<uint16_t>()), out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+RETCODE convertDate(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    SQL_DATE_STRUCT value;
+    if (field.tryGetDate(value) != ParseStatus::Ok)
+        return SQL_ERROR;
+
+    return fillOutputNumber<SQL_DATE_STRUCT>(value, out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+RETCODE convertBinaryDateTime(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    return fillOutputNumber<SQL_TIMESTAMP_STRUCT>(
+        dateTimeFromSeconds(field.getBinary<int64_t>()), out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+RETCODE convertDateTime(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    SQL_TIMESTAMP_STRUCT value;
+    if (field.tryGetDateTime(value) != ParseStatus::Ok)
+        return SQL_ERROR;
+
+    return fillOutputNumber<SQL_TIMESTAMP_STRUCT>(value, out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+RETCODE convertTextToString(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    return fillOutputRawString(field, out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+RETCODE convertToString(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    return fillOutputRawString(field.toString(), out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+RETCODE convertTextToWString(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    return fillOutputUSC2String(field, out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+RETCODE convertToWString(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    return fillOutputUSC2String(field.toString(), out_value, out_value_max_size, out_value_size_or_indicator);
+}
+
+} // namespace
+
+ColumnConverter getColumnConverter(ValueEncoding encoding, SQLSMALLINT target_type) {
+    const bool is_text = (encoding == ValueEncoding::Text);
+
+    switch (target_type) {
+        case SQL_C_CHAR:
+        case SQL_C_BINARY:
+            return (is_text ? &convertTextToString : &convertToString);
+
+        case SQL_C_WCHAR:
+            return (is_text ? &convertTextToWString : &convertToWString);
+
+        case SQL_C_TINYINT:
+        case SQL_C_STINYINT:
+            return getNumberConverter<int8_t>(encoding);
+
+        case SQL_C_UTINYINT:
+        case SQL_C_BIT:
+            return getNumberConverter<uint8_t>(encoding);
+
+        case SQL_C_SHORT:
+        case SQL_C_SSHORT:
+            return getNumberConverter<int16_t>(encoding);
+
+        case SQL_C_USHORT:
+            return getNumberConverter<uint16_t>(encoding);
+
+        case SQL_C_LONG:
+        case SQL_C_SLONG:
+            return getNumberConverter<int32_t>(encoding);
+
+        case SQL_C_ULONG:
+            return getNumberConverter<uint32_t>(encoding);
+
+        case SQL_C_SBIGINT:
+            return getNumberConverter<int64_t>(encoding);
+
+        case SQL_C_UBIGINT:
+            return getNumberConverter<uint64_t>(encoding);
+
+        case SQL_C_FLOAT:
+            return getNumberConverter<float>(encoding);
+
+        case SQL_C_DOUBLE:
+            return getNumberConverter<double>(encoding);
+
+        case SQL_C_DATE:
+        case SQL_C_TYPE_DATE:
+            return (encoding == ValueEncoding::Date ? &convertBinaryDate : &convertDate);
+
+        case SQL_C_TIMESTAMP:
+        case SQL_C_TYPE_TIMESTAMP:
+            return (encoding == ValueEncoding::DateTime ? &convertBinaryDateTime : &convertDateTime);
+
+        case SQL_ARD_TYPE:
+        case SQL_C_DEFAULT:
+            LOG(__FUNCTION__ << ": Unsupported type requested (throw)." << target_type);
+            throw std::runtime_error("Unsupported type requested.");
+
+        default:
+            LOG(__FUNCTION__ << ": Unknown type requested (throw)." << target_type);
+            throw std::runtime_error("Unknown type requested.");
+    }
+}
+
+SQLLEN getBoundElementSize(SQLSMALLINT target_type, SQLLEN buffer_length) {
+    switch (target_type) {
+        case SQL_C_TINYINT:
+        case SQL_C_STINYINT:
+        case SQL_C_UTINYINT:
+        case SQL_C_BIT:
+            return sizeof(SQLCHAR);
+
+        case SQL_C_SHORT:
+        case SQL_C_SSHORT:
+        case SQL_C_USHORT:
+            return sizeof(SQLSMALLINT);
+
+        case SQL_C_LONG:
+        case SQL_C_SLONG:
+        case SQL_C_ULONG:
+            return sizeof(SQLINTEGER);
+
+        case SQL_C_SBIGINT:
+        case SQL_C_UBIGINT:
+            return sizeof(SQLBIGINT);
+
+        case SQL_C_FLOAT:
+            return sizeof(SQLREAL);
+
+        case SQL_C_DOUBLE:
+            return sizeof(SQLDOUBLE);
+
+        case SQL_C_DATE:
+        case SQL_C_TYPE_DATE:
+            return sizeof(SQL_DATE_STRUCT);
+
+        case SQL_C_TIME:
+        case SQL_C_TYPE_TIME:
+            return sizeof(SQL_TIME_STRUCT);
+
+        case SQL_C_TIMESTAMP:
+        case SQL_C_TYPE_TIMESTAMP:
+            return sizeof(SQL_TIMESTAMP_STRUCT);
+
+        case SQL_C_GUID:
+            return sizeof(SQLGUID);
+
+        default:
+            return buffer_length;
+    }
+}
+
+ParseStatus getConversionStatus(const Field & field, SQLSMALLINT target_type) {
+    switch (target_type) {
+        case SQL_C_TINYINT:
+        case SQL_C_STINYINT:
+            return getNumberConversionStatus<int8_t>(field);
+
+        case SQL_C_UTINYINT:
+        case SQL_C_BIT:
+            return getNumberConversionStatus<uint8_t>(field);
+
+        case SQL_C_SHORT:
+        case SQL_C_SSHORT:
+            return getNumberConversionStatus<int16_t>(field);
+
+        case SQL_C_USHORT:
+            return getNumberConversionStatus<uint16_t>(field);
+
+        case SQL_C_LONG:
+        case SQL_C_SLONG:
+            return getNumberConversionStatus<int32_t>(field);
+
+        case SQL_C_ULONG:
+            return getNumberConversionStatus<uint32_t>(field);
+
+        case SQL_C_SBIGINT:
+            return getNumberConversionStatus<int64_t>(field);
+
+        case SQL_C_UBIGINT:
+            return getNumberConversionStatus<uint64_t>(field);
+
+        case SQL_C_FLOAT:
+            return getNumberConversionStatus<float>(field);
+
+        case SQL_C_DOUBLE:
+            return getNumberConversionStatus<double>(field);
+
+        default:
+            return ParseStatus::Invalid;
+    }
+}
+
+RETCODE fillConversionError(DiagnosticsContainer & diagnostics, const Field & field, SQLSMALLINT target_type) {
+    // Errors are rare, so it is only here that the value is looked at again to tell why it could not be converted.
+    if (getConversionStatus(field, target_type) == ParseStatus::OutOfRange) {
+        diagnostics.fillDiag(SQL_ERROR, "22003", "Numeric value out of range: '" + field.toString() +
+            "' does not fit into C type " + std::to_string(target_type), 1);
+    }
+    else {
+        diagnostics.fillDiag(SQL_ERROR, "22018", "Invalid character value for cast specification: '" + field.toString() +
+            "' can not be converted to C type " + std::to_string(target_type), 1);
+    }
+
+    return SQL_ERROR;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "platform.h"
+#include "diagnostics.h"
+#include "result_set.h"
+
+/// Writes a non-null value to an application buffer as a particular C type, with the same semantics as SQLGetData.
+/// Returns SQL_ERROR, instead of throwing, if the value can not be converted to the C type, or does not fit into it.
+using ColumnConverter = RETCODE (*)(const Field & field, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator);
+
+/// Pick the converter of values stored in the encoding to the C type, so that a column can be converted
+/// without dispatching on the types for every value. Throws if the C type is not supported.
+ColumnConverter getColumnConverter(ValueEncoding encoding, SQLSMALLINT target_type);
+
+/// Size of an element of a column-wise bound array of the C type: the size of the type if it is fixed, otherwise 'buffer_length'.
+SQLLEN getBoundElementSize(SQLSMALLINT target_type, SQLLEN buffer_length);
+
+/// Why a converter to the C type returned SQL_ERROR for the value: ParseStatus::OutOfRange if it does not fit into the type.
+ParseStatus getConversionStatus(const Field & field, SQLSMALLINT target_type);
+
+/// Report a value that a converter returned SQL_ERROR for, with SQLSTATE 22003 if it is out of range of the C type,
+/// 22018 otherwise, and return SQL_ERROR.
+RETCODE fillConversionError(DiagnosticsContainer & diagnostics, const Field & field, SQLSMALLINT target_type);
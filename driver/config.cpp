@@ -38,6 +38,13 @@ void getDSNinfo(ConnInfo * ci, bool overwrite) {
     GET_CONFIG(database,        INI_DATABASE,        INI_DATABASE_DEFAULT);
     GET_CONFIG(onlyread,        INI_READONLY,        INI_READONLY_DEFAULT);
     GET_CONFIG(stringmaxlength, INI_STRINGMAXLENGTH, INI_STRINGMAXLENGTH_DEFAULT);
+    GET_CONFIG(readbuffersize,  INI_READBUFFERSIZE,  INI_READBUFFERSIZE_DEFAULT);
+    GET_CONFIG(format,          INI_FORMAT,          INI_FORMAT_DEFAULT);
+    GET_CONFIG(prefetch,        INI_PREFETCH,        INI_PREFETCH_DEFAULT);
+    GET_CONFIG(readaheadsize,   INI_READAHEADSIZE,   INI_READAHEADSIZE_DEFAULT);
+    GET_CONFIG(compression,     INI_COMPRESSION,     INI_COMPRESSION_DEFAULT);
+    GET_CONFIG(compressionthreshold, INI_COMPRESSIONTHRESHOLD, INI_COMPRESSIONTHRESHOLD_DEFAULT);
+    GET_CONFIG(cursormemorylimit, INI_CURSORMEMORYLIMIT, INI_CURSORMEMORYLIMIT_DEFAULT);
     GET_CONFIG(trace,           INI_TRACE,           INI_TRACE_DEFAULT);
     GET_CONFIG(tracefile,       INI_TRACEFILE,       INI_TRACEFILE_DEFAULT);
 
@@ -74,6 +81,13 @@ void writeDSNinfo(const ConnInfo * ci) {
     WRITE_CONFIG(database,        INI_DATABASE);
     WRITE_CONFIG(onlyread,        INI_READONLY);
     WRITE_CONFIG(stringmaxlength, INI_STRINGMAXLENGTH);
+    WRITE_CONFIG(readbuffersize,  INI_READBUFFERSIZE);
+    WRITE_CONFIG(format,          INI_FORMAT);
+    WRITE_CONFIG(prefetch,        INI_PREFETCH);
+    WRITE_CONFIG(readaheadsize,   INI_READAHEADSIZE);
+    WRITE_CONFIG(compression,     INI_COMPRESSION);
+    WRITE_CONFIG(compressionthreshold, INI_COMPRESSIONTHRESHOLD);
+    WRITE_CONFIG(cursormemorylimit, INI_CURSORMEMORYLIMIT);
     WRITE_CONFIG(trace,           INI_TRACE);
     WRITE_CONFIG(tracefile,       INI_TRACEFILE);
 
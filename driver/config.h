@@ -21,6 +21,13 @@ struct ConnInfo {
     MYTCHAR onlyread[SMALL_REGISTRY_LEN] = {};
     MYTCHAR timeout[SMALL_REGISTRY_LEN] = {};
     MYTCHAR stringmaxlength[SMALL_REGISTRY_LEN] = {};
+    MYTCHAR readbuffersize[SMALL_REGISTRY_LEN] = {};
+    MYTCHAR format[MEDIUM_REGISTRY_LEN] = {};
+    MYTCHAR prefetch[SMALL_REGISTRY_LEN] = {};
+    MYTCHAR readaheadsize[SMALL_REGISTRY_LEN] = {};
+    MYTCHAR compression[SMALL_REGISTRY_LEN] = {};
+    MYTCHAR compressionthreshold[SMALL_REGISTRY_LEN] = {};
+    MYTCHAR cursormemorylimit[SMALL_REGISTRY_LEN] = {};
     MYTCHAR show_system_tables[SMALL_REGISTRY_LEN] = {};
     MYTCHAR translation_dll[MEDIUM_REGISTRY_LEN] = {};
     MYTCHAR translation_option[SMALL_REGISTRY_LEN] = {};
@@ -4,12 +4,20 @@
 #include "config.h"
 #include "descriptor.h"
 #include "statement.h"
+#include "response_stream.h"
+#include "time_zone.h"
 
 #include <Poco/Base64Encoder.h>
 #include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/NullStream.h>
 #include <Poco/NumberParser.h> // TODO: switch to std
+#include <Poco/StreamCopier.h>
 #include <Poco/URI.h>
 
+#include <algorithm>
+
 #if USE_SSL
 #    include <Poco/Net/AcceptCertificateHandler.h>
 #    include <Poco/Net/RejectCertificateHandler.h>
@@ -84,7 +92,20 @@ void Connection::init() {
     if (user.find(':') != std::string::npos)
         throw std::runtime_error("Username couldn't contain ':' (colon) symbol.");
 
-    LOG("Creating session with " << proto << "://" << server << ":" << port);
+    if (!isSupportedResultFormat(format))
+        throw std::runtime_error("Unsupported format: " + format);
+
+    // Binary formats leave it to the driver to show DateTime values in their time zones, which takes the tz database.
+    // Without one, e.g., on Windows, the server does that instead, in the text format.
+    if (format != "ODBCDriver2" && !TimeZone::isDatabaseAvailable()) {
+        LOG("No time zone database, using the ODBCDriver2 format instead of " << format);
+        format = "ODBCDriver2";
+    }
+
+    if (!isSupportedCompression(compression))
+        throw std::runtime_error("Unsupported compression: " + compression);
+
+    LOG("Connecting to " << proto << "://" << server << ":" << port);
 
 #if USE_SSL
     bool is_ssl = proto == "https";
@@ -93,17 +114,175 @@ void Connection::init() {
         std::call_once(ssl_init_once, SSLInit, ssl_strict, privateKeyFile, certificateFile, caLocation);
 #endif
 
-    session = std::unique_ptr<Poco::Net::HTTPClientSession>(
+    // Sessions are created, or taken from the pool, by the statements as they send their requests.
+    connected = true;
+}
+
+std::unique_ptr<Poco::Net::HTTPClientSession> Connection::createSession() const {
+    std::unique_ptr<Poco::Net::HTTPClientSession> new_session(
 #if USE_SSL
-        is_ssl ? new Poco::Net::HTTPSClientSession :
+        proto == "https" ? new Poco::Net::HTTPSClientSession :
 #endif
-               new Poco::Net::HTTPClientSession);
+                           new Poco::Net::HTTPClientSession);
+
+    new_session->setHost(server);
+    new_session->setPort(port);
+    new_session->setKeepAlive(true);
+    new_session->setTimeout(Poco::Timespan(connection_timeout, 0), Poco::Timespan(timeout, 0), Poco::Timespan(timeout, 0));
+    new_session->setKeepAliveTimeout(Poco::Timespan(86400, 0));
+
+    return new_session;
+}
+
+std::string Connection::getSessionPoolKey() const {
+    std::string key = proto + "://" + server + ":" + std::to_string(port);
+
+    if (proto == "https")
+        key += "|" + std::to_string(ssl_strict) + "|" + privateKeyFile + "|" + certificateFile + "|" + caLocation;
+
+    return key;
+}
+
+bool Connection::isConnected() const {
+    return connected;
+}
+
+std::unique_ptr<Poco::Net::HTTPClientSession> Connection::acquireSession(int query_timeout) {
+    std::unique_ptr<Poco::Net::HTTPClientSession> session;
+
+    while (!session) {
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            if (idle_sessions.empty())
+                break;
+
+            session = std::move(idle_sessions.back());
+            idle_sessions.pop_back();
+        }
+
+        // Checked, and closed, without holding the lock, since that involves system calls.
+        if (!is_session_healthy(*session)) {
+            LOG("Closing an idle session that is not usable anymore");
+            session.reset();
+        }
+    }
+
+    if (!session) {
+        session = SessionPool::getInstance().acquire(getSessionPoolKey());
+        if (session)
+            LOG("Reusing a pooled session");
+    }
 
-    session->setHost(server);
-    session->setPort(port);
-    session->setKeepAlive(true);
-    session->setTimeout(Poco::Timespan(connection_timeout, 0), Poco::Timespan(timeout, 0), Poco::Timespan(timeout, 0));
-    session->setKeepAliveTimeout(Poco::Timespan(86400, 0));
+    if (!session)
+        session = createSession();
+
+    applyTimeouts(*session, getReadTimeout(query_timeout, timeout));
+    return session;
+}
+
+int Connection::getReadTimeout(int query_timeout, int connection_timeout) {
+    if (query_timeout <= 0)
+        return std::max(connection_timeout, 0);
+
+    if (connection_timeout <= 0)
+        return query_timeout;
+
+    return std::min(query_timeout, connection_timeout);
+}
+
+std::string Connection::getTimeoutSQLState(int query_timeout, int connection_timeout) {
+    if (query_timeout > 0 && getReadTimeout(query_timeout, connection_timeout) == query_timeout)
+        return "HYT00";
+
+    return "HYT01";
+}
+
+void Connection::releaseSession(std::unique_ptr<Poco::Net::HTTPClientSession> && session) {
+    if (!session)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        if (connected && idle_sessions.size() < max_idle_sessions) {
+            idle_sessions.push_back(std::move(session));
+            return;
+        }
+    }
+
+    SessionPool::getInstance().release(getSessionPoolKey(), std::move(session));
+}
+
+void Connection::disconnect() {
+    // The responses of the statements must be finished, or their sessions reset, before the sessions can be used by other connections.
+    std::vector<std::shared_ptr<Statement>> active_statements;
+
+    {
+        std::lock_guard<std::mutex> lock(children_mutex);
+        for (auto & statement : statements)
+            active_statements.push_back(statement.second);
+    }
+
+    for (auto & statement : active_statements)
+        statement->closeCursor();
+
+    std::vector<std::unique_ptr<Poco::Net::HTTPClientSession>> sessions;
+
+    {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+        sessions.swap(idle_sessions);
+        connected = false;
+    }
+
+    for (auto & session : sessions)
+        SessionPool::getInstance().release(getSessionPoolKey(), std::move(session));
+}
+
+void Connection::applyTimeouts(Poco::Net::HTTPClientSession & session, int receive_timeout) const {
+    session.setTimeout(Poco::Timespan(connection_timeout, 0), Poco::Timespan(timeout, 0), Poco::Timespan(receive_timeout, 0));
+
+    // An already connected socket, e.g., of a pooled session, needs them set directly.
+    if (session.connected()) {
+        session.socket().setSendTimeout(Poco::Timespan(timeout, 0));
+        session.socket().setReceiveTimeout(Poco::Timespan(receive_timeout, 0));
+    }
+}
+
+void Connection::killQuery(const std::string & query_id) {
+    if (query_id.empty())
+        return;
+
+    LOG("Killing query " << query_id);
+
+    try {
+        Poco::URI uri(url);
+        uri.addQueryParameter("query", "KILL QUERY WHERE query_id = '" + query_id + "' ASYNC");
+
+        Poco::Net::HTTPRequest request;
+        request.setMethod(Poco::Net::HTTPRequest::HTTP_POST);
+        request.setVersion(Poco::Net::HTTPRequest::HTTP_1_1);
+        request.setKeepAlive(true);
+        request.setContentLength(0);
+        request.setCredentials("Basic", buildCredentialsString());
+        request.setURI(uri.toString());
+        request.set("User-Agent", buildUserAgentString());
+
+        // Leased like those of the statements, so that cancelling does not open, and tear down, a connection every time.
+        auto kill_session = acquireSession();
+        kill_session->sendRequest(request);
+
+        Poco::Net::HTTPResponse response;
+        auto & in = kill_session->receiveResponse(response);
+        Poco::NullOutputStream discard;
+        Poco::StreamCopier::copyStream(in, discard);
+
+        // The response has been read to the end, so the session can be reused; on failures it is dropped instead.
+        releaseSession(std::move(kill_session));
+
+        if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK)
+            LOG("Killing query " << query_id << " failed, HTTP status code: " << response.getStatus());
+    } catch (const std::exception & e) {
+        LOG("Killing query " << query_id << " failed: " << e.what());
+    }
 }
 
 void Connection::init(const std::string & dsn_,
@@ -111,7 +290,7 @@ void Connection::init(const std::string & dsn_,
     const std::string & user_,
     const std::string & password_,
     const std::string & database_) {
-    if (session && session->connected())
+    if (isConnected())
         throw std::runtime_error("Already connected.");
 
     data_source = dsn_;
@@ -178,6 +357,45 @@ void Connection::init(const std::string & connection_string) {
             else {
                 throw std::runtime_error("Cannot parse stringmaxlength.");
             }
+        } else if (key_lower == "readbuffersize") {
+            int int_val = 0;
+            if (Poco::NumberParser::tryParse(current_value.toString(), int_val) && int_val > 0)
+                read_buffer_size = int_val;
+            else {
+                throw std::runtime_error("Cannot parse readbuffersize.");
+            }
+        } else if (key_lower == "format") {
+            format = current_value.toString();
+        } else if (key_lower == "prefetch") {
+            int int_val = 0;
+            if (Poco::NumberParser::tryParse(current_value.toString(), int_val) && int_val >= 0)
+                prefetch = int_val;
+            else {
+                throw std::runtime_error("Cannot parse prefetch.");
+            }
+        } else if (key_lower == "readaheadsize") {
+            int int_val = 0;
+            if (Poco::NumberParser::tryParse(current_value.toString(), int_val) && int_val > 0)
+                read_ahead_size = int_val;
+            else {
+                throw std::runtime_error("Cannot parse readaheadsize.");
+            }
+        } else if (key_lower == "compression") {
+            compression = current_value.toString();
+        } else if (key_lower == "compressionthreshold") {
+            int int_val = 0;
+            if (Poco::NumberParser::tryParse(current_value.toString(), int_val) && int_val >= 0)
+                compression_threshold = int_val;
+            else {
+                throw std::runtime_error("Cannot parse compressionthreshold.");
+            }
+        } else if (key_lower == "cursormemorylimit") {
+            Poco::Int64 int_val = 0;
+            if (Poco::NumberParser::tryParse64(current_value.toString(), int_val) && int_val >= 0)
+                cursor_memory_limit = int_val;
+            else {
+                throw std::runtime_error("Cannot parse cursormemorylimit.");
+            }
         } else if (key_lower == "dsn")
             data_source = current_value.toString();
         else if (key_lower == "privatekeyfile")
@@ -237,6 +455,48 @@ void Connection::loadConfiguration() {
                 throw std::runtime_error("Cannot parse stringmaxlength value [" + string + "].");
         }
     }
+    if (read_buffer_size == 0) {
+        const std::string string = stringFromMYTCHAR(ci.readbuffersize);
+        if (!string.empty()) {
+            if (!Poco::NumberParser::tryParse(string, this->read_buffer_size) || this->read_buffer_size < 0)
+                throw std::runtime_error("Cannot parse readbuffersize value [" + string + "].");
+        }
+    }
+
+    if (format.empty())
+        format = stringFromMYTCHAR(ci.format);
+    if (prefetch < 0) {
+        const std::string string = stringFromMYTCHAR(ci.prefetch);
+        if (!string.empty()) {
+            if (!Poco::NumberParser::tryParse(string, this->prefetch) || this->prefetch < 0)
+                throw std::runtime_error("Cannot parse prefetch value [" + string + "].");
+        }
+    }
+    if (read_ahead_size == 0) {
+        const std::string string = stringFromMYTCHAR(ci.readaheadsize);
+        if (!string.empty()) {
+            if (!Poco::NumberParser::tryParse(string, this->read_ahead_size) || this->read_ahead_size < 0)
+                throw std::runtime_error("Cannot parse readaheadsize value [" + string + "].");
+        }
+    }
+    if (compression.empty())
+        compression = stringFromMYTCHAR(ci.compression);
+    if (compression_threshold < 0) {
+        const std::string string = stringFromMYTCHAR(ci.compressionthreshold);
+        if (!string.empty()) {
+            if (!Poco::NumberParser::tryParse(string, this->compression_threshold) || this->compression_threshold < 0)
+                throw std::runtime_error("Cannot parse compressionthreshold value [" + string + "].");
+        }
+    }
+    if (cursor_memory_limit < 0) {
+        const std::string string = stringFromMYTCHAR(ci.cursormemorylimit);
+        if (!string.empty()) {
+            Poco::Int64 int_val = 0;
+            if (!Poco::NumberParser::tryParse64(string, int_val) || int_val < 0)
+                throw std::runtime_error("Cannot parse cursormemorylimit value [" + string + "].");
+            cursor_memory_limit = int_val;
+        }
+    }
 
     if (server.empty())
         server = stringFromMYTCHAR(ci.server);
@@ -299,6 +559,20 @@ void Connection::setDefaults() {
         path = "/" + path;
     if (stringmaxlength == 0)
         stringmaxlength = Environment::string_max_size;
+    if (read_buffer_size == 0)
+        read_buffer_size = BufferedReader::default_chunk_size;
+    if (format.empty())
+        format = INI_FORMAT_DEFAULT;
+    if (prefetch < 0)
+        prefetch = 0;
+    if (read_ahead_size == 0)
+        read_ahead_size = ResultSet::default_read_ahead_size;
+    if (compression.empty())
+        compression = INI_COMPRESSION_DEFAULT;
+    if (compression_threshold < 0)
+        compression_threshold = 65536;
+    if (cursor_memory_limit < 0)
+        cursor_memory_limit = 64 << 20;
     if (user.empty())
         user = "default";
     if (database.empty())
@@ -404,13 +678,24 @@ Descriptor& Connection::allocateChild<Descriptor>() {
     auto child_sptr = std::make_shared<Descriptor>(*this);
     auto& child = *child_sptr;
     auto handle = child.getHandle();
+    std::lock_guard<std::mutex> lock(children_mutex);
     descriptors.emplace(handle, std::move(child_sptr));
     return child;
 }
 
 template <>
 void Connection::deallocateChild<Descriptor>(SQLHANDLE handle) noexcept {
-    descriptors.erase(handle);
+    std::shared_ptr<Descriptor> child; // Destroyed after unlocking, since that may take a while.
+
+    {
+        std::lock_guard<std::mutex> lock(children_mutex);
+        auto it = descriptors.find(handle);
+        if (it == descriptors.end())
+            return;
+
+        child = std::move(it->second);
+        descriptors.erase(it);
+    }
 }
 
 template <>
@@ -418,11 +703,22 @@ Statement& Connection::allocateChild<Statement>() {
     auto child_sptr = std::make_shared<Statement>(*this);
     auto& child = *child_sptr;
     auto handle = child.getHandle();
+    std::lock_guard<std::mutex> lock(children_mutex);
     statements.emplace(handle, std::move(child_sptr));
     return child;
 }
 
 template <>
 void Connection::deallocateChild<Statement>(SQLHANDLE handle) noexcept {
-    statements.erase(handle);
+    std::shared_ptr<Statement> child; // Destroyed after unlocking, since that may take a while.
+
+    {
+        std::lock_guard<std::mutex> lock(children_mutex);
+        auto it = statements.find(handle);
+        if (it == statements.end())
+            return;
+
+        child = std::move(it->second);
+        statements.erase(it);
+    }
 }
@@ -2,6 +2,7 @@
 
 #include "driver.h"
 #include "environment.h"
+#include "session_pool.h"
 
 #include <memory>
 #include <mutex>
@@ -30,6 +31,13 @@ public:
     int timeout = 0;
     int connection_timeout = 0;
     int32_t stringmaxlength = 0;
+    int32_t read_buffer_size = 0;
+    std::string format;
+    int32_t prefetch = -1; // 0 disables prefetching.
+    int32_t read_ahead_size = 0;
+    std::string compression;
+    int32_t compression_threshold = -1; // Request bodies smaller than this are sent uncompressed.
+    int64_t cursor_memory_limit = -1; // Rows of static cursors past this size are spilled to a file.
     bool ssl_strict = false;
 
     std::string privateKeyFile;
@@ -38,9 +46,11 @@ public:
 
     std::string useragent;
 
-    std::unique_ptr<Poco::Net::HTTPClientSession> session;
     int retry_count = 3;
 
+    /// Whether an idle session of the connection can be reused, i.e., has not been closed by the server in the meantime.
+    SessionPool::HealthCheck is_session_healthy = SessionPool::isSessionHealthy;
+
 public:
     explicit Connection(Environment & environment);
 
@@ -69,6 +79,39 @@ public:
     // Return a crafted User-Agent string.
     std::string buildUserAgentString() const;
 
+    /// Create a new HTTP session to the server, configured like the main one.
+    std::unique_ptr<Poco::Net::HTTPClientSession> createSession() const;
+
+    /// Identifies the server and the transport settings, sessions of connections with the same key are interchangeable.
+    std::string getSessionPoolKey() const;
+
+    bool isConnected() const;
+
+    /// Lease a session for the requests of a statement, so that statements can read their responses concurrently.
+    /// Idle sessions of the connection are reused first, then those of the process-wide pool, before creating a new one.
+    /// Idle sessions that is_session_healthy rejects are closed instead of being reused.
+    /// Reads time out as getReadTimeout() tells for 'query_timeout' and the timeout of the connection.
+    std::unique_ptr<Poco::Net::HTTPClientSession> acquireSession(int query_timeout = 0);
+
+    /// Seconds the reads of a request time out after: the shorter of the timeouts that are set (positive),
+    /// or 0, which is no timeout, if neither is.
+    static int getReadTimeout(int query_timeout, int connection_timeout);
+
+    /// The SQLSTATE of a request whose reads have timed out: HYT00 if it was the query timeout that expired,
+    /// i.e., the shorter one of those set, HYT01 if it was the timeout of the connection.
+    static std::string getTimeoutSQLState(int query_timeout, int connection_timeout);
+
+    /// Return a session leased by acquireSession(), once the response to the last request sent over it has been finished.
+    void releaseSession(std::unique_ptr<Poco::Net::HTTPClientSession> && session);
+
+    /// Close the cursors of the statements and return the sessions to the process-wide pool, if they are still usable.
+    void disconnect();
+
+    /// Ask the server to cancel a query, over a session leased with acquireSession(), since the one of the query is busy
+    /// with its response. The session is released once the response to the kill request has been read.
+    /// Best effort: failures are only logged.
+    void killQuery(const std::string & query_id);
+
     // Reset the descriptor and initialize it with default attributes.
     void initAsAD(Descriptor & desc, bool user = false); // as Application Descriptor
     void initAsID(Descriptor & desc); // as Implementation Descriptor
@@ -94,8 +137,19 @@ private:
     /// Sets uninitialized fields to their default values.
     void setDefaults();
 
+    void applyTimeouts(Poco::Net::HTTPClientSession & session, int receive_timeout) const;
+
 private:
+    /// Sessions kept by the connection between the requests of its statements, the rest go to the process-wide pool.
+    static constexpr std::size_t max_idle_sessions = 4;
+
+    bool connected = false;
+    std::mutex sessions_mutex;
+    std::vector<std::unique_ptr<Poco::Net::HTTPClientSession>> idle_sessions; // The most recently used one last.
+
     std::string database;
+
+    std::mutex children_mutex;
     std::unordered_map<SQLHANDLE, std::shared_ptr<Descriptor>> descriptors;
     std::unordered_map<SQLHANDLE, std::shared_ptr<Statement>> statements;
 };
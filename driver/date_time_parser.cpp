@@ -0,0 +1,170 @@
+#include "date_time_parser.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+inline uint64_t loadLittleEndian(const char * p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    uint64_t res = 0;
+    for (std::size_t i = 0; i < 8; ++i)
+        res |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return res;
+#else
+    uint64_t res;
+    std::memcpy(&res, p, sizeof(res));
+    return res;
+#endif
+}
+
+/// Checks 8 characters at once against a pattern of digits and separators. 'pattern' has '0' for digits and the separators as they are,
+/// 'digit_mask' has 0xFF for digits. On success, 'digits' gets the values of the digits, and 0 for the separators.
+inline bool matchPattern(uint64_t chunk, uint64_t pattern, uint64_t digit_mask, uint64_t & digits) {
+    const uint64_t diff = chunk ^ pattern;
+
+    // Separators must match exactly.
+    if (diff & ~digit_mask)
+        return false;
+
+    // '0'..'9' xor '0' are exactly the bytes below 10. A byte of 0x80 or more sets its own high bit,
+    // so the carry it may produce into the next byte can not hide an error.
+    const uint64_t values = diff & digit_mask;
+    if (((values + 0x7676767676767676) | values) & 0x8080808080808080 & digit_mask)
+        return false;
+
+    digits = values;
+    return true;
+}
+
+/// Combines every digit with the following one: byte 'idx' of the result is the two-digit number starting at 'idx'.
+inline uint64_t digitPairs(uint64_t digits) {
+    return digits * 10 + (digits >> 8);
+}
+
+inline unsigned byteAt(uint64_t word, std::size_t idx) {
+    return static_cast<unsigned>((word >> (8 * idx)) & 0xFF);
+}
+
+inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// "YYYY-MM-" and "DD hh:mm", little-endian.
+constexpr uint64_t date_pattern = 0x2D30302D30303030;    // "0000-00-"
+constexpr uint64_t date_digit_mask = 0x00FFFF00FFFFFFFF;
+constexpr uint64_t time_pattern = 0x30303A3030203030;    // "00 00:00"
+constexpr uint64_t time_digit_mask = 0xFFFF00FFFF00FFFF;
+
+inline bool isLeapYear(unsigned year) {
+    return (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
+}
+
+inline unsigned daysInMonth(unsigned year, unsigned month) {
+    static const unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (month == 2 && isLeapYear(year) ? 29 : days[month - 1]);
+}
+
+struct DateTimeParts {
+    unsigned year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    unsigned hour = 0;
+    unsigned minute = 0;
+    unsigned second = 0;
+    uint32_t fraction = 0;
+};
+
+ParseStatus parseParts(const char * data, std::size_t size, DateTimeParts & parts) {
+    // Only whole 8-byte words within the value are loaded below.
+    if (size != 10 && (size < 19 || size == 20 || size > 29))
+        return ParseStatus::Invalid;
+
+    uint64_t date_digits = 0;
+    if (!matchPattern(loadLittleEndian(data), date_pattern, date_digit_mask, date_digits))
+        return ParseStatus::Invalid;
+
+    const auto date_pairs = digitPairs(date_digits);
+    parts.year = byteAt(date_pairs, 0) * 100 + byteAt(date_pairs, 2);
+    parts.month = byteAt(date_pairs, 5);
+
+    if (size == 10) {
+        if (!isDigit(data[8]) || !isDigit(data[9]))
+            return ParseStatus::Invalid;
+        parts.day = (data[8] - '0') * 10 + (data[9] - '0');
+    } else {
+        uint64_t time_digits = 0;
+        if (!matchPattern(loadLittleEndian(data + 8), time_pattern, time_digit_mask, time_digits))
+            return ParseStatus::Invalid;
+
+        const auto time_pairs = digitPairs(time_digits);
+        parts.day = byteAt(time_pairs, 0);
+        parts.hour = byteAt(time_pairs, 3);
+        parts.minute = byteAt(time_pairs, 6);
+
+        if (data[16] != ':' || !isDigit(data[17]) || !isDigit(data[18]))
+            return ParseStatus::Invalid;
+        parts.second = (data[17] - '0') * 10 + (data[18] - '0');
+
+        if (size > 19) {
+            if (data[19] != '.')
+                return ParseStatus::Invalid;
+
+            // Scale to nanoseconds.
+            uint32_t fraction = 0;
+            std::size_t i = 20;
+            for (; i < size; ++i) {
+                if (!isDigit(data[i]))
+                    return ParseStatus::Invalid;
+                fraction = fraction * 10 + (data[i] - '0');
+            }
+            for (; i < 29; ++i)
+                fraction *= 10;
+            parts.fraction = fraction;
+        }
+    }
+
+    // The zero date.
+    if (parts.year == 0 && parts.month == 0 && parts.day == 0) {
+        parts.year = 1970;
+        parts.month = 1;
+        parts.day = 1;
+    }
+
+    if (parts.year == 0 || parts.month < 1 || parts.month > 12 || parts.day < 1 || parts.day > daysInMonth(parts.year, parts.month) ||
+        parts.hour > 23 || parts.minute > 59 || parts.second > 59
+    )
+        return ParseStatus::OutOfRange;
+
+    return ParseStatus::Ok;
+}
+
+} // namespace
+
+ParseStatus parseDate(const char * data, std::size_t size, SQL_DATE_STRUCT & res) {
+    DateTimeParts parts;
+    const auto status = parseParts(data, size, parts);
+    if (status != ParseStatus::Ok)
+        return status;
+
+    res.year = static_cast<SQLSMALLINT>(parts.year);
+    res.month = static_cast<SQLUSMALLINT>(parts.month);
+    res.day = static_cast<SQLUSMALLINT>(parts.day);
+    return ParseStatus::Ok;
+}
+
+ParseStatus parseDateTime(const char * data, std::size_t size, SQL_TIMESTAMP_STRUCT & res) {
+    DateTimeParts parts;
+    const auto status = parseParts(data, size, parts);
+    if (status != ParseStatus::Ok)
+        return status;
+
+    res.year = static_cast<SQLSMALLINT>(parts.year);
+    res.month = static_cast<SQLUSMALLINT>(parts.month);
+    res.day = static_cast<SQLUSMALLINT>(parts.day);
+    res.hour = static_cast<SQLUSMALLINT>(parts.hour);
+    res.minute = static_cast<SQLUSMALLINT>(parts.minute);
+    res.second = static_cast<SQLUSMALLINT>(parts.second);
+    res.fraction = static_cast<SQLUINTEGER>(parts.fraction);
+    return ParseStatus::Ok;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "platform.h"
+#include "number_parser.h"
+
+#include <cstddef>
+
+/// Parsers of the text representations of Date, Date32, DateTime and DateTime64 values the server uses:
+/// "YYYY-MM-DD", "YYYY-MM-DD hh:mm:ss" and "YYYY-MM-DD hh:mm:ss.f" with 1 to 9 fractional digits.
+/// They work on pointer+length and never throw: ParseStatus::Invalid is returned for anything else,
+/// and ParseStatus::OutOfRange for well-formed values with fields out of their ranges (like a month 13).
+/// The zero date of the server, "0000-00-00", is read as 1970-01-01.
+/// 'res' is left unchanged unless ParseStatus::Ok is returned.
+
+/// The time, if any, is validated, but dropped.
+ParseStatus parseDate(const char * data, std::size_t size, SQL_DATE_STRUCT & res);
+
+/// The fraction is in nanoseconds, as ODBC wants it.
+ParseStatus parseDateTime(const char * data, std::size_t size, SQL_TIMESTAMP_STRUCT & res);
@@ -93,6 +93,10 @@ void DiagnosticsContainer::insertDiagStatus(DiagnosticsRecord && rec) {
     new_rec = std::move(rec);
 }
 
+bool isTimeoutError(const std::string & server_error) {
+    return (server_error.find("Code: 159.") != std::string::npos || server_error.find("Code: 159,") != std::string::npos);
+}
+
 void DiagnosticsContainer::resetDiag() {
     auto & header = getDiagHeader();
     header.setAttr(SQL_DIAG_NUMBER, 0);
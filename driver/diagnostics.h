@@ -19,6 +19,10 @@ private:
     const std::string sql_state;
 };
 
+/// Whether an error message of the server is of TIMEOUT_EXCEEDED, which a query fails with when it runs for longer
+/// than max_execution_time.
+bool isTimeoutError(const std::string & server_error);
+
 class DiagnosticsRecord
     : public AttributeContainer
 {
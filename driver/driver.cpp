@@ -35,42 +35,73 @@ Environment & Driver::allocateChild<Environment>() {
     auto child_sptr = std::make_shared<Environment>(*this);
     auto & child = *child_sptr;
     auto handle = child.getHandle();
+    std::lock_guard<std::mutex> lock(environments_mutex);
     environments.emplace(handle, std::move(child_sptr));
     return child;
 }
 
 template <>
 void Driver::deallocateChild<Environment>(SQLHANDLE handle) noexcept {
-    environments.erase(handle);
+    std::shared_ptr<Environment> child; // Destroyed after unlocking, since that may take a while.
+
+    {
+        std::lock_guard<std::mutex> lock(environments_mutex);
+        auto it = environments.find(handle);
+        if (it == environments.end())
+            return;
+
+        child = std::move(it->second);
+        environments.erase(it);
+    }
 }
 
 void Driver::registerDescendant(Object & descendant) {
-    descendants.erase(descendant.getHandle());
-    descendants.emplace(descendant.getHandle(), std::ref(descendant));
+    descendants.add(descendant.getHandle(), descendant);
 }
 
 void Driver::unregisterDescendant(Object & descendant) noexcept {
-    descendants.erase(descendant.getHandle());
+    descendants.remove(descendant.getHandle());
 }
 
 template <>
-Environment * Driver::dynamicCastTo<Environment>(Object * obj) {
+Environment * Driver::castTo<Environment>(Object * obj) {
+#if defined(NDEBUG)
+    return static_cast<Environment *>(obj);
+#else
     return dynamic_cast<Environment *>(obj);
+#endif
 }
 
 template <>
-Connection * Driver::dynamicCastTo<Connection>(Object * obj) {
+Connection * Driver::castTo<Connection>(Object * obj) {
+#if defined(NDEBUG)
+    return static_cast<Connection *>(obj);
+#else
     return dynamic_cast<Connection *>(obj);
+#endif
 }
 
 template <>
-Descriptor * Driver::dynamicCastTo<Descriptor>(Object * obj) {
+Descriptor * Driver::castTo<Descriptor>(Object * obj) {
+#if defined(NDEBUG)
+    return static_cast<Descriptor *>(obj);
+#else
     return dynamic_cast<Descriptor *>(obj);
+#endif
 }
 
 template <>
-Statement * Driver::dynamicCastTo<Statement>(Object * obj) {
+Statement * Driver::castTo<Statement>(Object * obj) {
+#if defined(NDEBUG)
+    return static_cast<Statement *>(obj);
+#else
     return dynamic_cast<Statement *>(obj);
+#endif
+}
+
+template <>
+bool Driver::isExecutingAsynchronously<Statement>(Statement & statement) {
+    return statement.isExecutingAsynchronously();
 }
 
 void Driver::onAttrChange(int attr) {
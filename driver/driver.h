@@ -4,6 +4,7 @@
 #include "utils.h"
 #include "attributes.h"
 #include "diagnostics.h"
+#include "handle_registry.h"
 #include "object.h"
 
 #include <Poco/Exception.h>
@@ -12,6 +13,7 @@
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -89,12 +91,16 @@ public:
     void writeLogSessionStart(std::ostream & stream);
     void writeLogSessionEnd(std::ostream & stream);
 
+    // Whether another thread executes a function on the object asynchronously, see Statement::isExecutingAsynchronously().
+    template <typename T> static bool isExecutingAsynchronously(T &) { return false; }
+
 protected:
     virtual void onAttrChange(int attr) final override;
 
 private:
     // Leave unimplemented for general case.
-    template <typename T> T * dynamicCastTo(Object *);
+    // The type of the object is known from its handle type already, so this is a static cast, checked in debug builds.
+    template <typename T> T * castTo(Object *);
 
     template <typename Callable>
     static inline SQLRETURN doCall(Callable & callable,
@@ -180,7 +186,9 @@ private:
     std::ofstream log_file_stream;
 
     // TODO: consider upgrading from common Object type to std::variant of C++17 (or Boost), when available.
-    std::unordered_map<SQLHANDLE, std::reference_wrapper<Object>> descendants;
+    HandleRegistry descendants;
+
+    std::mutex environments_mutex;
     std::unordered_map<SQLHANDLE, std::shared_ptr<Environment>> environments;
 };
 
@@ -188,10 +196,12 @@ template <> Environment & Driver::allocateChild<Environment>();
 template <> void Driver::deallocateChild<Environment>(SQLHANDLE handle) noexcept;
 
 // Move this to cpp to avoid the need of fully specifying these types here.
-template <> Environment * Driver::dynamicCastTo<Environment>(Object * obj);
-template <> Connection * Driver::dynamicCastTo<Connection>(Object * obj);
-template <> Descriptor * Driver::dynamicCastTo<Descriptor>(Object * obj);
-template <> Statement * Driver::dynamicCastTo<Statement>(Object * obj);
+template <> Environment * Driver::castTo<Environment>(Object * obj);
+template <> Connection * Driver::castTo<Connection>(Object * obj);
+template <> Descriptor * Driver::castTo<Descriptor>(Object * obj);
+template <> Statement * Driver::castTo<Statement>(Object * obj);
+
+template <> bool Driver::isExecutingAsynchronously<Statement>(Statement & statement);
 
 template <typename Callable>
 SQLRETURN Driver::call(Callable && callable, SQLHANDLE handle, SQLSMALLINT handle_type, bool skip_diag) noexcept {
@@ -203,11 +213,15 @@ SQLRETURN Driver::call(Callable && callable, SQLHANDLE handle, SQLSMALLINT handl
                 return SQL_INVALID_HANDLE;
         }
         else {
-            auto it = descendants.find(handle);
-            if (it == descendants.end())
+#if defined(NDEBUG)
+            // Handles point straight at their objects, which are validated by their tags.
+            obj_ptr = Object::fromHandle(handle);
+#else
+            // Debug builds look the handle up, so that even a pointer that never was a handle is rejected safely.
+            obj_ptr = descendants.find(handle);
+#endif
+            if (obj_ptr == nullptr)
                 return SQL_INVALID_HANDLE;
-
-            obj_ptr = &it->second.get();
         }
 
         if (obj_ptr == nullptr) {
@@ -235,19 +249,30 @@ SQLRETURN Driver::call(Callable && callable, SQLHANDLE handle, SQLSMALLINT handl
             try {
 
 #define TRY_DISPATCH_AS(ObjectType) \
-    if ( \
-        handle_type == 0 || \
-        handle_type == getObjectHandleType<ObjectType>() \
-    ) { \
-        auto * obj = dynamicCastTo<ObjectType>(obj_ptr); \
-        if (obj) \
-            return doCall(callable, *obj, skip_diag); \
-    }
-
-                TRY_DISPATCH_AS(Statement);
-                TRY_DISPATCH_AS(Descriptor);
-                TRY_DISPATCH_AS(Connection);
-                TRY_DISPATCH_AS(Environment);
+    case getObjectHandleType<ObjectType>(): \
+        if ( \
+            handle_type == 0 || \
+            handle_type == getObjectHandleType<ObjectType>() \
+        ) { \
+            auto * obj = castTo<ObjectType>(obj_ptr); \
+            if (obj) { \
+                /* Only the functions that leave the diagnostics intact may be called while another one executes */ \
+                /* asynchronously; the diagnostics belong to that one, and are filled by its worker thread. */ \
+                if (!skip_diag && isExecutingAsynchronously(*obj)) { \
+                    LOG("HY010 (Function sequence error: a function is executing asynchronously on the handle)"); \
+                    return SQL_ERROR; \
+                } \
+                return doCall(callable, *obj, skip_diag); \
+            } \
+        } \
+        break;
+
+                switch (obj_ptr->getHandleType()) {
+                    TRY_DISPATCH_AS(Statement);
+                    TRY_DISPATCH_AS(Descriptor);
+                    TRY_DISPATCH_AS(Connection);
+                    TRY_DISPATCH_AS(Environment);
+                }
 
 #undef TRY_DISPATCH_AS
 
@@ -62,11 +62,22 @@ Connection& Environment::allocateChild<Connection>() {
     auto child_sptr = std::make_shared<Connection>(*this);
     auto& child = *child_sptr;
     auto handle = child.getHandle();
+    std::lock_guard<std::mutex> lock(connections_mutex);
     connections.emplace(handle, std::move(child_sptr));
     return child;
 }
 
 template <>
 void Environment::deallocateChild<Connection>(SQLHANDLE handle) noexcept {
-    connections.erase(handle);
+    std::shared_ptr<Connection> child; // Destroyed after unlocking, since that may take a while.
+
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        auto it = connections.find(handle);
+        if (it == connections.end())
+            return;
+
+        child = std::move(it->second);
+        connections.erase(it);
+    }
 }
@@ -4,6 +4,7 @@
 #include "diagnostics.h"
 
 #include <map>
+#include <mutex>
 #include <stdexcept>
 
 struct TypeInfo {
@@ -48,6 +49,7 @@ public:
 #endif
 
 private:
+    std::mutex connections_mutex;
     std::unordered_map<SQLHANDLE, std::shared_ptr<Connection>> connections;
 };
 
@@ -0,0 +1,106 @@
+#include "batched_insert.h"
+#include "lexer.h"
+
+#include <cstddef>
+
+namespace {
+
+/// A token of the query, with the depth of the parentheses around it, a parenthesis is outside of those it opens or closes.
+struct QueryToken {
+    Token token;
+    int depth;
+};
+
+/// Split the query into tokens, skipping spaces and comments.
+/// Returns false if a quote or a comment is not closed, or a parenthesis is not closed or is never opened.
+bool tokenize(const std::string & query, std::vector<QueryToken> & tokens) {
+    Lexer lex(query);
+    int depth = 0;
+
+    while (true) {
+        const auto token = lex.Consume();
+
+        if (token.type == Token::EOS)
+            break;
+
+        if (token.isInvalid())
+            return false;
+
+        if (token.type == Token::RPARENT && --depth < 0)
+            return false;
+
+        tokens.push_back({token, depth});
+
+        if (token.type == Token::LPARENT)
+            ++depth;
+    }
+
+    return (depth == 0);
+}
+
+/// Keywords are tokens of their own types, so words are compared by their text. Quoted identifiers never match.
+bool isWord(const Token & token, const std::string & word) {
+    return (token.literal.size() == word.size() && to_upper(token.literal) == word);
+}
+
+} // namespace
+
+bool splitBatchableInsert(const std::string & query, const std::vector<std::string> & placeholders, std::string & insert_head) {
+    std::vector<QueryToken> tokens;
+    if (placeholders.empty() || !tokenize(query, tokens) || tokens.empty() || !isWord(tokens[0].token, "INSERT"))
+        return false;
+
+    // The last VALUES outside of parentheses, since only a semicolon may follow its row. A VALUES before it may be a name.
+    std::size_t values_idx = 0;
+    for (std::size_t i = 1; i < tokens.size(); ++i) {
+        if (tokens[i].depth == 0 && isWord(tokens[i].token, "VALUES"))
+            values_idx = i;
+    }
+
+    if (values_idx == 0)
+        return false;
+
+    // INSERT ... SELECT, INSERT ... FROM INFILE, and INSERT ... FORMAT Values, with the data in the query, are not batchable.
+    for (std::size_t i = 1; i < values_idx; ++i) {
+        if (tokens[i].depth == 0 && (
+            isWord(tokens[i].token, "SELECT") ||
+            isWord(tokens[i].token, "FROM") ||
+            isWord(tokens[i].token, "FORMAT")
+        )) {
+            return false;
+        }
+    }
+
+    std::size_t idx = values_idx + 1;
+    const auto expect = [&] (Token::Type type) {
+        return (idx < tokens.size() && tokens[idx++].token.type == type);
+    };
+
+    if (!expect(Token::LPARENT))
+        return false;
+
+    for (std::size_t param_idx = 0; param_idx < placeholders.size(); ++param_idx) {
+        if (param_idx > 0 && !expect(Token::COMMA))
+            return false;
+
+        if (idx >= tokens.size())
+            return false;
+
+        const auto & token = tokens[idx++].token;
+        if (token.type != Token::IDENT || token.literal.to_string() != placeholders[param_idx])
+            return false;
+    }
+
+    if (!expect(Token::RPARENT))
+        return false;
+
+    for (; idx < tokens.size(); ++idx) {
+        if (tokens[idx].token.type != Token::SEMICOLON)
+            return false;
+    }
+
+    const auto head_begin = static_cast<std::size_t>(tokens[0].token.literal.data() - query.data());
+    const auto head_end = static_cast<std::size_t>(tokens[values_idx].token.literal.data() - query.data());
+    insert_head = query.substr(head_begin, head_end - head_begin);
+    return true;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/// Whether 'query' is an INSERT ... VALUES (...) with a single row in VALUES, made of nothing but all the 'placeholders'
+/// in their order, and with nothing after it but semicolons. Quoted text and comments are skipped, and so are
+/// parentheses, so VALUES of a subquery or of a table function does not count. If the query is such an INSERT,
+/// 'insert_head' is set to the part of the query before VALUES, which the rows can be sent in a format after.
+bool splitBatchableInsert(const std::string & query, const std::vector<std::string> & placeholders, std::string & insert_head);
@@ -1,6 +1,7 @@
 #include "lexer.h"
 
 #include <algorithm>
+#include <cstring>
 #include <unordered_map>
 
 namespace {
@@ -119,6 +120,36 @@ void Lexer::SetEmitSpaces(bool value) {
 
 Token Lexer::NextToken() {
     for (; cur_ < end_; ++cur_) {
+        /** Comments */
+
+        const bool line_comment = (*cur_ == '-' && cur_ + 1 < end_ && *(cur_ + 1) == '-');
+        const bool block_comment = (*cur_ == '/' && cur_ + 1 < end_ && *(cur_ + 1) == '*');
+
+        if (line_comment || block_comment) {
+            const char * st = cur_;
+
+            if (line_comment) {
+                for (cur_ += 2; cur_ < end_ && *cur_ != '\n'; ++cur_) {
+                }
+            } else {
+                for (cur_ += 2; cur_ + 1 < end_ && !(*cur_ == '*' && *(cur_ + 1) == '/'); ++cur_) {
+                }
+
+                if (cur_ + 1 >= end_) {
+                    cur_ = end_;
+                    return Token {Token::INVALID, StringView(st, end_)};
+                }
+
+                cur_ += 2;
+            }
+
+            if (emit_space_)
+                return Token {Token::COMMENT, StringView(st, cur_)};
+
+            --cur_; // The loop steps past the comment.
+            continue;
+        }
+
         switch (*cur_) {
                 /** Whitespaces */
 
@@ -144,6 +175,14 @@ Token Lexer::NextToken() {
                 return MakeToken(Token::RCURLY, 1);
             case ',':
                 return MakeToken(Token::COMMA, 1);
+            case ';':
+                return MakeToken(Token::SEMICOLON, 1);
+
+                /** Quoted identifiers */
+
+            case '"':
+            case '`':
+                return QuotedIdentifier();
 
             case '\'': {
                 const char * st = cur_;
@@ -155,6 +194,11 @@ Token Lexer::NextToken() {
                         continue;
                     }
                     if (*cur_ == '\'' && !has_slash) {
+                        // A quote escaped by doubling it.
+                        if (cur_ + 1 < end_ && *(cur_ + 1) == '\'') {
+                            ++cur_;
+                            continue;
+                        }
                         return Token {Token::STRING, StringView(st, ++cur_)};
                     }
 
@@ -167,25 +211,15 @@ Token Lexer::NextToken() {
             default: {
                 const char * st = cur_;
 
-                if (*cur_ == '`') {
-                    bool inside_quotes = true;
+                // Named parameters, and the placeholders the statement puts in place of parameters, '@' and a UUID.
+                if (*cur_ == '@') {
                     for (++cur_; cur_ < end_; ++cur_) {
-                        if (*cur_ == '`') {
-                            inside_quotes = !inside_quotes;
-                            if (cur_ < end_ && *(cur_ + 1) == '.') {
-                                ++cur_;
-                                continue;
-                            } else if (!inside_quotes)
-                                return Token {Token::IDENT, StringView(st, ++cur_)};
-                            if (cur_ < end_)
-                                ++cur_;
-                        }
-                        if (!isalpha(*cur_) && !isdigit(*cur_) && *cur_ != '_' && *cur_ != '.') {
-                            return Token {Token::INVALID, StringView(st, cur_)};
+                        if (!isalnum(*cur_) && *cur_ != '_' && *cur_ != '-') {
+                            break;
                         }
                     }
 
-                    break;
+                    return Token {Token::IDENT, StringView(st, cur_)};
                 }
 
                 if (isalpha(*cur_) || *cur_ == '_') {
@@ -224,8 +258,9 @@ Token Lexer::NextToken() {
                     return Token {Token::NUMBER, StringView(st, cur_)};
                 }
 
-                for (; cur_ < end_; ++cur_) {
-                    if (isspace(*cur_)) {
+                // Up to a delimiter or a quote too, so that the parentheses and the quotes in it are tokens of their own.
+                for (++cur_; cur_ < end_; ++cur_) {
+                    if (isspace(*cur_) || strchr("(){},;'\"`", *cur_)) {
                         break;
                     }
                 }
@@ -237,3 +272,47 @@ Token Lexer::NextToken() {
 
     return Token {Token::EOS, StringView()};
 }
+
+Token Lexer::QuotedIdentifier() {
+    const char * st = cur_;
+
+    while (true) {
+        const char quote = *cur_;
+
+        // The quote is escaped in it by a backslash, or by doubling it.
+        for (++cur_;; ++cur_) {
+            if (cur_ >= end_) {
+                return Token {Token::INVALID, StringView(st, end_)};
+            }
+            if (*cur_ == '\\') {
+                if (++cur_ >= end_) {
+                    return Token {Token::INVALID, StringView(st, end_)};
+                }
+                continue;
+            }
+            if (*cur_ == quote) {
+                if (cur_ + 1 < end_ && *(cur_ + 1) == quote) {
+                    ++cur_;
+                    continue;
+                }
+                break;
+            }
+        }
+
+        ++cur_;
+
+        // The next part of a compound identifier, e.g., `table`.`field`.
+        if (cur_ + 1 < end_ && *cur_ == '.') {
+            if (*(cur_ + 1) == '`' || *(cur_ + 1) == '"') {
+                ++cur_;
+                continue;
+            }
+            if (isalpha(*(cur_ + 1)) || *(cur_ + 1) == '_') {
+                for (cur_ += 2; cur_ < end_ && (isalnum(*cur_) || *cur_ == '_'); ++cur_) {
+                }
+            }
+        }
+
+        return Token {Token::IDENT, StringView(st, cur_)};
+    }
+}
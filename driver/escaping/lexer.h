@@ -15,6 +15,7 @@ struct Token {
         INVALID = 0,
         EOS,
         SPACE,
+        COMMENT,
         OTHER,
 
         // Identifiers and literals
@@ -37,6 +38,7 @@ struct Token {
         RPARENT, //  )
         LCURLY,  //  {
         RCURLY,  //  }
+        SEMICOLON, //  ;
     };
 
 #undef DECLARE
@@ -75,7 +77,7 @@ public:
     /// Peek next token.
     Token Peek();
 
-    /// Enable or disable emitting of space tokens.
+    /// Enable or disable emitting of space tokens, and of comment tokens, which are skipped like spaces otherwise.
     void SetEmitSpaces(bool value);
 
 private:
@@ -85,6 +87,9 @@ private:
     /// Recoginze next token.
     Token NextToken();
 
+    /// Recognize an identifier quoted with the current char, " or `, with the parts of a compound one after it.
+    Token QuotedIdentifier();
+
 private:
     const StringView text_;
     /// Pointer to current char in the input string.
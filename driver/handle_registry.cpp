@@ -0,0 +1,34 @@
+#include "handle_registry.h"
+
+constexpr std::size_t HandleRegistry::num_shards;
+
+void HandleRegistry::add(SQLHANDLE handle, Object & object) {
+    auto & shard = getShard(handle);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.objects[handle] = &object;
+}
+
+void HandleRegistry::remove(SQLHANDLE handle) noexcept {
+    auto & shard = getShard(handle);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.objects.erase(handle);
+}
+
+Object * HandleRegistry::find(SQLHANDLE handle) const noexcept {
+    const auto & shard = getShard(handle);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    const auto it = shard.objects.find(handle);
+    return (it == shard.objects.end() ? nullptr : it->second);
+}
+
+std::size_t HandleRegistry::size() const noexcept {
+    std::size_t num_handles = 0;
+
+    for (const auto & shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        num_handles += shard.objects.size();
+    }
+
+    return num_handles;
+}
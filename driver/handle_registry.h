@@ -0,0 +1,53 @@
+#pragma once
+
+#include "platform.h"
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+#include <cstddef>
+#include <cstdint>
+
+class Object;
+
+/// Maps handles to the objects they were allocated for. Split into shards, each guarded by a mutex of its own,
+/// so that handles can be allocated, freed, and looked up by many threads at once without them waiting for each other,
+/// unless two handles happen to land in the same shard at the same moment.
+class HandleRegistry {
+public:
+    /// Replaces the object registered for the handle, if any.
+    void add(SQLHANDLE handle, Object & object);
+
+    void remove(SQLHANDLE handle) noexcept;
+
+    /// Returns null if the handle is not registered.
+    Object * find(SQLHANDLE handle) const noexcept;
+
+    std::size_t size() const noexcept;
+
+private:
+    static constexpr std::size_t num_shards = 64;
+
+    struct alignas(64) Shard { // A cache line each, so that the mutexes of neighboring shards don't share one.
+        mutable std::mutex mutex;
+        std::unordered_map<SQLHANDLE, Object *> objects;
+    };
+
+    static std::size_t getShardIndex(SQLHANDLE handle) noexcept {
+        // Handles are addresses of heap objects: the lowest bits are mostly alignment, and the next ones vary the most.
+        const auto value = reinterpret_cast<std::uintptr_t>(handle);
+        return ((value >> 4) ^ (value >> 10)) % num_shards;
+    }
+
+    Shard & getShard(SQLHANDLE handle) noexcept {
+        return shards[getShardIndex(handle)];
+    }
+
+    const Shard & getShard(SQLHANDLE handle) const noexcept {
+        return shards[getShardIndex(handle)];
+    }
+
+private:
+    std::array<Shard, num_shards> shards;
+};
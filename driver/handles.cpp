@@ -55,6 +55,11 @@ SQLRETURN allocDesc(SQLHDBC connection_handle, SQLHDESC * out_descriptor_handle)
 
 SQLRETURN freeHandle(SQLHANDLE handle) noexcept {
     return CALL_WITH_HANDLE_SKIP_DIAG(handle, [&] (auto & object) {
+        if (Driver::isExecutingAsynchronously(object)) {
+            LOG("HY010 (Function sequence error: a function is executing asynchronously on the handle)");
+            return SQL_ERROR;
+        }
+
         if ( // Refuse to manually deallocate an automatically allocated descriptor.
             std::is_convertible<std::decay<decltype(object)> *, Descriptor *>::value &&
             object.template getAttrAs<SQLSMALLINT>(SQL_DESC_ALLOC_TYPE) != SQL_DESC_ALLOC_USER
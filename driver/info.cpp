@@ -106,9 +106,9 @@ SQLRETURN SQL_API SQLGetInfo(
 
             /// UINTEGER single values
             CASE_NUM(SQL_ODBC_INTERFACE_CONFORMANCE, SQLUINTEGER, SQL_OIC_CORE)
-            CASE_NUM(SQL_ASYNC_MODE, SQLUINTEGER, SQL_AM_NONE)
+            CASE_NUM(SQL_ASYNC_MODE, SQLUINTEGER, SQL_AM_STATEMENT)
 #if defined(SQL_ASYNC_NOTIFICATION)
-            CASE_NUM(SQL_ASYNC_NOTIFICATION, SQLUINTEGER, SQL_ASYNC_NOTIFICATION_NOT_CAPABLE)
+            CASE_NUM(SQL_ASYNC_NOTIFICATION, SQLUINTEGER, SQL_ASYNC_NOTIFICATION_CAPABLE)
 #endif
             CASE_NUM(SQL_DEFAULT_TXN_ISOLATION, SQLUINTEGER, SQL_TXN_SERIALIZABLE)
 #if defined(SQL_DRIVER_AWARE_POOLING_CAPABLE)
@@ -134,6 +134,7 @@ SQLRETURN SQL_API SQLGetInfo(
             CASE_NUM(SQL_NON_NULLABLE_COLUMNS, SQLUSMALLINT, SQL_NNC_NON_NULL)
             CASE_NUM(SQL_NULL_COLLATION, SQLUSMALLINT, SQL_NC_END)
             CASE_NUM(SQL_TXN_CAPABLE, SQLUSMALLINT, SQL_TC_NONE)
+            CASE_NUM(SQL_MAX_CONCURRENT_ACTIVITIES, SQLUSMALLINT, 0) // No limit: every active statement has a session of its own.
 
             /// UINTEGER non-empty bitmasks
             CASE_NUM(SQL_CATALOG_USAGE, SQLUINTEGER, SQL_CU_DML_STATEMENTS | SQL_CU_TABLE_DEFINITION)
@@ -152,7 +153,9 @@ SQLRETURN SQL_API SQLGetInfo(
             CASE_NUM(SQL_GETDATA_EXTENSIONS, SQLUINTEGER, SQL_GD_ANY_COLUMN | SQL_GD_ANY_ORDER | SQL_GD_BOUND)
             CASE_NUM(SQL_INDEX_KEYWORDS, SQLUINTEGER, SQL_IK_NONE)
             CASE_NUM(SQL_INSERT_STATEMENT, SQLUINTEGER, SQL_IS_INSERT_LITERALS | SQL_IS_INSERT_SEARCHED)
-            CASE_NUM(SQL_SCROLL_OPTIONS, SQLUINTEGER, SQL_SO_FORWARD_ONLY)
+            CASE_NUM(SQL_SCROLL_OPTIONS, SQLUINTEGER, SQL_SO_FORWARD_ONLY | SQL_SO_STATIC)
+            CASE_NUM(SQL_FORWARD_ONLY_CURSOR_ATTRIBUTES1, SQLUINTEGER, SQL_CA1_NEXT)
+            CASE_NUM(SQL_STATIC_CURSOR_ATTRIBUTES1, SQLUINTEGER, SQL_CA1_NEXT | SQL_CA1_ABSOLUTE | SQL_CA1_RELATIVE)
             CASE_NUM(SQL_SQL92_DATETIME_FUNCTIONS, SQLUINTEGER, SQL_SDF_CURRENT_DATE | SQL_SDF_CURRENT_TIME | SQL_SDF_CURRENT_TIMESTAMP)
 
             CASE_FALLTHROUGH(SQL_CONVERT_BIGINT)
@@ -274,11 +277,9 @@ SQLRETURN SQL_API SQLGetInfo(
             CASE_FALLTHROUGH(SQL_DROP_TRANSLATION)
             CASE_FALLTHROUGH(SQL_DYNAMIC_CURSOR_ATTRIBUTES1)
             CASE_FALLTHROUGH(SQL_DYNAMIC_CURSOR_ATTRIBUTES2)
-            CASE_FALLTHROUGH(SQL_FORWARD_ONLY_CURSOR_ATTRIBUTES1)
             CASE_FALLTHROUGH(SQL_FORWARD_ONLY_CURSOR_ATTRIBUTES2)
             CASE_FALLTHROUGH(SQL_KEYSET_CURSOR_ATTRIBUTES1)
             CASE_FALLTHROUGH(SQL_KEYSET_CURSOR_ATTRIBUTES2)
-            CASE_FALLTHROUGH(SQL_STATIC_CURSOR_ATTRIBUTES1)
             CASE_FALLTHROUGH(SQL_STATIC_CURSOR_ATTRIBUTES2)
             CASE_FALLTHROUGH(SQL_INFO_SCHEMA_VIEWS)
             CASE_FALLTHROUGH(SQL_POS_OPERATIONS)
@@ -300,7 +301,6 @@ SQLRETURN SQL_API SQLGetInfo(
             CASE_FALLTHROUGH(SQL_MAX_COLUMNS_IN_ORDER_BY)
             CASE_FALLTHROUGH(SQL_MAX_COLUMNS_IN_SELECT)
             CASE_FALLTHROUGH(SQL_MAX_COLUMNS_IN_TABLE)
-            CASE_FALLTHROUGH(SQL_MAX_CONCURRENT_ACTIVITIES)
             CASE_FALLTHROUGH(SQL_MAX_DRIVER_CONNECTIONS)
             CASE_FALLTHROUGH(SQL_MAX_IDENTIFIER_LEN)
             CASE_FALLTHROUGH(SQL_MAX_PROCEDURE_NAME_LEN)
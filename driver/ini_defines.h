@@ -20,6 +20,13 @@
 #define INI_DATABASE        "Database"        /* Database Name */
 #define INI_READONLY        "ReadOnly"        /* Database is read only */
 #define INI_STRINGMAXLENGTH "StringMaxLength"
+#define INI_READBUFFERSIZE  "ReadBufferSize"  /* Size of chunks the result stream is read in, in bytes */
+#define INI_FORMAT          "Format"          /* Format the query results are requested in */
+#define INI_PREFETCH        "Prefetch"        /* Max size of results read ahead in background, in bytes */
+#define INI_READAHEADSIZE   "ReadAheadSize"   /* Max size of a batch of rows read at once, in bytes */
+#define INI_COMPRESSION     "Compression"     /* Compression of responses and large requests: none, gzip or deflate */
+#define INI_COMPRESSIONTHRESHOLD "CompressionThreshold" /* Min size of a request body to compress, in bytes */
+#define INI_CURSORMEMORYLIMIT "CursorMemoryLimit" /* Max size of the rows a static cursor keeps in memory, in bytes */
 #define INI_TRACE           "Trace"
 #define INI_TRACEFILE       "TraceFile"
 
@@ -35,6 +42,13 @@
 #define INI_DATABASE_DEFAULT        ""
 #define INI_READONLY_DEFAULT        ""
 #define INI_STRINGMAXLENGTH_DEFAULT "1048575"
+#define INI_READBUFFERSIZE_DEFAULT  "1048576"
+#define INI_FORMAT_DEFAULT          "ODBCDriver2"
+#define INI_PREFETCH_DEFAULT        "0"
+#define INI_READAHEADSIZE_DEFAULT   "1048576"
+#define INI_COMPRESSION_DEFAULT     "none"
+#define INI_COMPRESSIONTHRESHOLD_DEFAULT "65536"
+#define INI_CURSORMEMORYLIMIT_DEFAULT "67108864"
 
 #ifdef NDEBUG
 #    define INI_TRACE_DEFAULT "off"
@@ -0,0 +1,446 @@
+#include "number_parser.h"
+#include "number_parser_powers.h"
+
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+
+#include <cstring>
+
+// Parsing of 8 digits at once relies on the byte order of a loaded word.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#    define NUMBER_PARSER_SWAR 0
+#else
+#    define NUMBER_PARSER_SWAR 1
+#endif
+
+namespace {
+
+inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+#if NUMBER_PARSER_SWAR
+
+inline uint64_t loadEightBytes(const char * p) {
+    uint64_t res;
+    std::memcpy(&res, p, sizeof(res));
+    return res;
+}
+
+inline bool isEightDigits(uint64_t chunk) {
+    // Every byte is in 0x30..0x39: its high nibble is 3, and adding 6 does not carry out of the low one.
+    return (((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333);
+}
+
+inline uint32_t parseEightDigits(uint64_t chunk) {
+    // Combine pairs of digits, then pairs of those, with multiplications that do not carry across the lanes.
+    const uint64_t mask = 0x000000FF000000FF;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8);
+    chunk = (((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32;
+    return static_cast<uint32_t>(chunk);
+}
+
+#endif
+
+/// Parses the digits at [p, end) into 'res', advancing 'p' past them.
+/// Returns false if the value does not fit into uint64 (the digits are still skipped).
+bool parseDigits(const char * & p, const char * end, uint64_t & res) {
+    uint64_t value = 0;
+
+    while (p < end && *p == '0')
+        ++p;
+
+    const char * const significant_begin = p;
+
+#if NUMBER_PARSER_SWAR
+    // Up to 16 digits can not overflow.
+    while (end - p >= 8 && p - significant_begin <= 8) {
+        const auto chunk = loadEightBytes(p);
+        if (!isEightDigits(chunk))
+            break;
+        value = value * 100000000 + parseEightDigits(chunk);
+        p += 8;
+    }
+#endif
+
+    bool fits = true;
+    for (; p < end && isDigit(*p); ++p) {
+        const auto digit = static_cast<uint64_t>(*p - '0');
+        if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+            fits = false;
+        else
+            value = value * 10 + digit;
+    }
+
+    res = value;
+    return fits;
+}
+
+template <typename T>
+struct FloatTraits;
+
+// Integers up to 2^digits and the powers of 10 up to 10^max_exact_power10 are exact in T,
+// so a product or a quotient of them is correctly rounded.
+// The rest describes the binary format for the Eisel-Lemire algorithm, see computeFloat().
+template <>
+struct FloatTraits<double> {
+    using Bits = uint64_t;
+    static constexpr int mantissa_bits = 52;
+    static constexpr int minimum_exponent = -1023;
+    static constexpr int infinite_power = 0x7FF;
+    static constexpr int smallest_power10 = -342; // Smaller powers of 10 round any mantissa to 0.
+    static constexpr int largest_power10 = 308;   // Larger ones, to infinity.
+    static constexpr int min_exponent_round_to_even = -4;
+    static constexpr int max_exponent_round_to_even = 23;
+    static constexpr int max_exact_power10 = 22;
+    static constexpr uint64_t max_exact_mantissa = uint64_t(1) << 53;
+    static double power10(int exponent) {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        return powers[exponent];
+    }
+};
+
+template <>
+struct FloatTraits<float> {
+    using Bits = uint32_t;
+    static constexpr int mantissa_bits = 23;
+    static constexpr int minimum_exponent = -127;
+    static constexpr int infinite_power = 0xFF;
+    static constexpr int smallest_power10 = -65;
+    static constexpr int largest_power10 = 38;
+    static constexpr int min_exponent_round_to_even = -17;
+    static constexpr int max_exponent_round_to_even = 10;
+    static constexpr int max_exact_power10 = 10;
+    static constexpr uint64_t max_exact_mantissa = uint64_t(1) << 24;
+    static float power10(int exponent) {
+        static const float powers[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+        return powers[exponent];
+    }
+};
+
+inline bool equalsIgnoreCase(const char * data, std::size_t size, const char * lower) {
+    if (size != std::strlen(lower))
+        return false;
+    for (std::size_t i = 0; i < size; ++i) {
+        if ((data[i] | 0x20) != lower[i])
+            return false;
+    }
+    return true;
+}
+
+struct UInt128 {
+    uint64_t low;
+    uint64_t high;
+};
+
+inline UInt128 multiply(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    const auto product = static_cast<unsigned __int128>(a) * b;
+    return {static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64)};
+#else
+    const uint64_t a_low = a & 0xFFFFFFFF;
+    const uint64_t a_high = a >> 32;
+    const uint64_t b_low = b & 0xFFFFFFFF;
+    const uint64_t b_high = b >> 32;
+
+    const uint64_t low_low = a_low * b_low;
+    const uint64_t high_low = a_high * b_low;
+    const uint64_t low_high = a_low * b_high;
+    const uint64_t high_high = a_high * b_high;
+
+    // Can not overflow: at most (2^32 - 1) * 2 + (2^32 - 1)^2.
+    const uint64_t middle = (low_low >> 32) + (high_low & 0xFFFFFFFF) + low_high;
+    return {(middle << 32) | (low_low & 0xFFFFFFFF), high_high + (high_low >> 32) + (middle >> 32)};
+#endif
+}
+
+inline int countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int res = 0;
+    for (; !(value & (uint64_t(1) << 63)); value <<= 1)
+        ++res;
+    return res;
+#endif
+}
+
+/// The Eisel-Lemire algorithm, as in the fast_float library: the bits of the correctly rounded T nearest to w * 10^q,
+/// w not 0, from the product of w and a 128-bit approximation of 5^q. The bits of infinity if it is too large.
+template <typename T>
+typename FloatTraits<T>::Bits computeFloat(int64_t q, uint64_t w) {
+    using Traits = FloatTraits<T>;
+    using Bits = typename Traits::Bits;
+    constexpr int mantissa_bits = Traits::mantissa_bits;
+    constexpr Bits infinity = Bits(Traits::infinite_power) << mantissa_bits;
+
+    if (q < Traits::smallest_power10)
+        return 0;
+    if (q > Traits::largest_power10)
+        return infinity;
+
+    const int leading_zeros = countLeadingZeros(w);
+    w <<= leading_zeros;
+
+    // The high bits of the product are those of the result, unless the ones right below them are all ones,
+    // in which case a carry from the next 64 bits of the power of five may change them.
+    const auto idx = 2 * static_cast<std::size_t>(q - power_of_five_table::smallest_power);
+    constexpr uint64_t precision_mask = ~uint64_t(0) >> (mantissa_bits + 3);
+
+    auto product = multiply(w, power_of_five_table::powers[idx]);
+    if ((product.high & precision_mask) == precision_mask) {
+        const auto next = multiply(w, power_of_five_table::powers[idx + 1]);
+        product.low += next.high;
+        if (next.high > product.low)
+            ++product.high;
+    }
+
+    // One more bit than the mantissa has, for rounding.
+    const int upper_bit = static_cast<int>(product.high >> 63);
+    const int shift = upper_bit + 64 - mantissa_bits - 3;
+    uint64_t mantissa = product.high >> shift;
+
+    // floor(log2(10^q)) + 63, then biased.
+    int64_t power2 = (((152170 + 65536) * q) >> 16) + 63 + upper_bit - leading_zeros - Traits::minimum_exponent;
+
+    if (power2 <= 0) {
+        // Subnormal, or too small even for that.
+        if (-power2 + 1 >= 64)
+            return 0;
+
+        mantissa >>= -power2 + 1;
+        mantissa += (mantissa & 1);
+        mantissa >>= 1;
+
+        // Rounding up may have made it the smallest normal number, with the exponent of 1.
+        power2 = (mantissa < (uint64_t(1) << mantissa_bits) ? 0 : 1);
+        return static_cast<Bits>(mantissa | (static_cast<uint64_t>(power2) << mantissa_bits));
+    }
+
+    // Exactly halfway between two numbers, which is only possible for small powers: round to even, not up.
+    if (product.low <= 1 && q >= Traits::min_exponent_round_to_even && q <= Traits::max_exponent_round_to_even
+        && (mantissa & 3) == 1 && (mantissa << shift) == product.high)
+    {
+        mantissa &= ~uint64_t(1);
+    }
+
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+
+    if (mantissa >= (uint64_t(2) << mantissa_bits)) {
+        mantissa = (uint64_t(1) << mantissa_bits);
+        ++power2;
+    }
+
+    mantissa &= ~(uint64_t(1) << mantissa_bits);
+
+    if (power2 >= Traits::infinite_power)
+        return infinity;
+
+    return static_cast<Bits>(mantissa | (static_cast<uint64_t>(power2) << mantissa_bits));
+}
+
+/// Numbers with more than 19 significant digits, the rounding of which depends on the digits beyond those:
+/// let the standard library round them correctly.
+template <typename T>
+ParseStatus parseFloatSlow(const char * data, std::size_t size, T & res) {
+    std::istringstream in(std::string(data, size));
+    in.imbue(std::locale::classic());
+
+    T value = 0;
+    in >> value;
+
+    // The syntax has already been checked, so a failure here means the value is out of range.
+    if (in.fail())
+        return ParseStatus::OutOfRange;
+
+    res = value;
+    return ParseStatus::Ok;
+}
+
+template <typename T>
+ParseStatus parseFloat(const char * data, std::size_t size, T & res) {
+    const char * p = data;
+    const char * const end = data + size;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    if (equalsIgnoreCase(p, end - p, "inf") || equalsIgnoreCase(p, end - p, "infinity")) {
+        res = (negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity());
+        return ParseStatus::Ok;
+    }
+
+    if (equalsIgnoreCase(p, end - p, "nan")) {
+        res = std::numeric_limits<T>::quiet_NaN();
+        return ParseStatus::Ok;
+    }
+
+    // Collect up to 19 significant digits of the mantissa, that always fit into uint64.
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    bool truncated = false;
+    int64_t exponent = 0;
+    bool has_digits = false;
+
+    for (; p < end && isDigit(*p); ++p) {
+        has_digits = true;
+        if (mantissa == 0 && *p == '0')
+            continue;
+        if (significant_digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            ++significant_digits;
+        } else {
+            truncated |= (*p != '0');
+            ++exponent;
+        }
+    }
+
+    if (p < end && *p == '.') {
+        ++p;
+        for (; p < end && isDigit(*p); ++p) {
+            has_digits = true;
+            if (mantissa == 0 && *p == '0') {
+                --exponent;
+                continue;
+            }
+            if (significant_digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                ++significant_digits;
+                --exponent;
+            } else {
+                truncated |= (*p != '0');
+            }
+        }
+    }
+
+    if (!has_digits)
+        return ParseStatus::Invalid;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+
+        bool negative_exponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative_exponent = (*p == '-');
+            ++p;
+        }
+
+        if (p == end || !isDigit(*p))
+            return ParseStatus::Invalid;
+
+        uint64_t explicit_exponent = 0;
+        if (!parseDigits(p, end, explicit_exponent) || explicit_exponent > 100000)
+            explicit_exponent = 100000; // Way beyond any range, the exact value does not matter.
+
+        exponent += (negative_exponent ? -static_cast<int64_t>(explicit_exponent) : static_cast<int64_t>(explicit_exponent));
+    }
+
+    if (p != end)
+        return ParseStatus::Invalid;
+
+    if (mantissa == 0) {
+        res = (negative ? -T(0) : T(0));
+        return ParseStatus::Ok;
+    }
+
+    using Traits = FloatTraits<T>;
+
+    if (!truncated && mantissa <= Traits::max_exact_mantissa &&
+        exponent >= -Traits::max_exact_power10 && exponent <= Traits::max_exact_power10
+    ) {
+        T value = static_cast<T>(mantissa);
+        if (exponent < 0)
+            value /= Traits::power10(static_cast<int>(-exponent));
+        else
+            value *= Traits::power10(static_cast<int>(exponent));
+        res = (negative ? -value : value);
+        return ParseStatus::Ok;
+    }
+
+    // The dropped digits, if any, make the value anything between the mantissa and the next one.
+    const auto bits = computeFloat<T>(exponent, mantissa);
+    if (truncated && computeFloat<T>(exponent, mantissa + 1) != bits)
+        return parseFloatSlow(data, size, res);
+
+    if (bits == (typename Traits::Bits(Traits::infinite_power) << Traits::mantissa_bits))
+        return ParseStatus::OutOfRange;
+
+    T value;
+    std::memcpy(&value, &bits, sizeof(value));
+    res = (negative ? -value : value);
+    return ParseStatus::Ok;
+}
+
+} // namespace
+
+ParseStatus parseNumber(const char * data, std::size_t size, uint64_t & res) {
+    const char * p = data;
+    const char * const end = data + size;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    if (p == end || !isDigit(*p))
+        return ParseStatus::Invalid;
+
+    uint64_t value = 0;
+    const bool fits = parseDigits(p, end, value);
+
+    if (p != end)
+        return ParseStatus::Invalid;
+
+    if (!fits || (negative && value != 0))
+        return ParseStatus::OutOfRange;
+
+    res = value;
+    return ParseStatus::Ok;
+}
+
+ParseStatus parseNumber(const char * data, std::size_t size, int64_t & res) {
+    const char * p = data;
+    const char * const end = data + size;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    if (p == end || !isDigit(*p))
+        return ParseStatus::Invalid;
+
+    uint64_t magnitude = 0;
+    const bool fits = parseDigits(p, end, magnitude);
+
+    if (p != end)
+        return ParseStatus::Invalid;
+
+    const uint64_t max_magnitude = static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0);
+    if (!fits || magnitude > max_magnitude)
+        return ParseStatus::OutOfRange;
+
+    // Negate in unsigned arithmetic, so that the minimal value does not overflow.
+    res = static_cast<int64_t>(negative ? (0 - magnitude) : magnitude);
+    return ParseStatus::Ok;
+}
+
+ParseStatus parseNumber(const char * data, std::size_t size, double & res) {
+    return parseFloat(data, size, res);
+}
+
+ParseStatus parseNumber(const char * data, std::size_t size, float & res) {
+    return parseFloat(data, size, res);
+}
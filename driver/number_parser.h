@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+/// Outcome of parsing a number out of its text representation.
+enum class ParseStatus {
+    Ok,
+    Invalid,    // Not a number at all, or has extra characters.
+    OutOfRange, // A well-formed number that the type cannot hold.
+};
+
+/// Locale-independent parsers of the text representations of numbers the server uses.
+/// They work on pointer+length (no terminating '\0' needed) and never throw. The whole input must be a number:
+/// an optional sign, digits, and for floating point numbers an optional fraction and exponent, or inf/nan.
+/// 'res' is left unchanged unless ParseStatus::Ok is returned.
+ParseStatus parseNumber(const char * data, std::size_t size, uint64_t & res);
+ParseStatus parseNumber(const char * data, std::size_t size, int64_t & res);
+ParseStatus parseNumber(const char * data, std::size_t size, double & res);
+ParseStatus parseNumber(const char * data, std::size_t size, float & res);
+
+/// Convert a number to a type that may not be able to hold it, truncating a fraction towards zero when an integer is requested.
+/// Returns ParseStatus::OutOfRange, instead of casting, if the value does not fit; NaN does not fit into integers.
+/// 'res' is left unchanged unless ParseStatus::Ok is returned.
+template <typename To, typename From>
+typename std::enable_if<std::is_integral<From>::value && std::is_integral<To>::value, ParseStatus>::type narrowNumber(From value, To & res) {
+    // Negative values are compared as signed 64-bit integers, the rest as unsigned ones.
+    if (std::is_signed<From>::value && static_cast<int64_t>(value) < 0) {
+        if (!std::is_signed<To>::value || static_cast<int64_t>(value) < static_cast<int64_t>(std::numeric_limits<To>::min()))
+            return ParseStatus::OutOfRange;
+    }
+    else if (static_cast<uint64_t>(value) > static_cast<uint64_t>(std::numeric_limits<To>::max())) {
+        return ParseStatus::OutOfRange;
+    }
+
+    res = static_cast<To>(value);
+    return ParseStatus::Ok;
+}
+
+template <typename To, typename From>
+typename std::enable_if<std::is_floating_point<From>::value && std::is_integral<To>::value, ParseStatus>::type narrowNumber(From value, To & res) {
+    // The minimum is 0 or a power of 2, and so is the maximum plus one, which the maximum of 64-bit types rounds up to anyway,
+    // so the bounds are exact doubles.
+    const double whole = std::trunc(static_cast<double>(value));
+    if (!(whole >= static_cast<double>(std::numeric_limits<To>::min()) && whole < static_cast<double>(std::numeric_limits<To>::max()) + 1.0))
+        return ParseStatus::OutOfRange;
+
+    res = static_cast<To>(whole);
+    return ParseStatus::Ok;
+}
+
+template <typename To, typename From>
+typename std::enable_if<std::is_floating_point<To>::value, ParseStatus>::type narrowNumber(From value, To & res) {
+    // Infinities and NaN are kept as they are, only finite doubles that are too large for a float do not fit.
+    if (std::is_floating_point<From>::value && sizeof(To) < sizeof(From) && std::isfinite(value) && std::fabs(value) > FLT_MAX)
+        return ParseStatus::OutOfRange;
+
+    res = static_cast<To>(value);
+    return ParseStatus::Ok;
+}
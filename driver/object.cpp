@@ -1,14 +1,16 @@
 #include "object.h"
 #include "driver.h"
 
-Object::Object() noexcept
-    : handle(this)
+constexpr std::uint32_t Object::live_tag;
+
+Object::Object(SQLSMALLINT handle_type_) noexcept
+    : handle_type(handle_type_)
+    , handle(this)
 {
 }
 
-Object::Object(SQLHANDLE h) noexcept
-    : handle(h)
-{
+Object::~Object() {
+    tag = 0;
 }
 
 SQLHANDLE Object::getHandle() const noexcept {
@@ -8,6 +8,8 @@
 #include <fstream>
 #include <memory>
 
+#include <cstdint>
+
 class Object
     : public AttributeContainer
     , public DiagnosticsContainer
@@ -18,13 +20,30 @@ public:
     Object& operator= (const Object &) = delete;
     Object& operator= (Object &&) = delete;
 
-    explicit Object() noexcept;
-    explicit Object(SQLHANDLE h) noexcept;
-    virtual ~Object() = default;
+    /// 'handle_type_' is one of SQL_HANDLE_*, or 0 for objects that are not handles.
+    explicit Object(SQLSMALLINT handle_type_ = 0) noexcept;
+    virtual ~Object();
 
+    /// The address of the object itself.
     SQLHANDLE getHandle() const noexcept;
 
+    SQLSMALLINT getHandleType() const noexcept {
+        return handle_type;
+    }
+
+    /// The object of a handle, validated only by the tag the object carries while it is alive, so that no lookup is needed.
+    /// Returns null for a handle of an object that has been destroyed, as long as its memory hasn't been reused,
+    /// but a pointer that never was a handle can't be told apart safely this way.
+    static Object * fromHandle(SQLHANDLE handle) noexcept {
+        auto * object = static_cast<Object *>(handle);
+        return (object->tag == live_tag && object->handle == handle ? object : nullptr);
+    }
+
 private:
+    static constexpr std::uint32_t live_tag = 0x4F444243; // "ODBC"
+
+    volatile std::uint32_t tag = live_tag; // Cleared by the destructor, volatile so that the store isn't optimized away.
+    SQLSMALLINT const handle_type;
     SQLHANDLE const handle;
 };
 
@@ -37,13 +56,7 @@ class Child
 {
 public:
     explicit Child(Parent & p) noexcept
-        : parent(p)
-    {
-        getDriver().registerDescendant(*this);
-    }
-
-    explicit Child(Parent & p, SQLHANDLE h) noexcept
-        : Object(h)
+        : Object(getObjectHandleType<Self>())
         , parent(p)
     {
         getDriver().registerDescendant(*this);
@@ -10,6 +10,7 @@
 #include "descriptor.h"
 #include "statement.h"
 #include "result_set.h"
+#include "column_converter.h"
 
 #include <iostream>
 #include <locale>
@@ -295,6 +296,57 @@ SQLRETURN DescribeParam(
     return CALL_WITH_HANDLE(handle, func);
 }
 
+/// Call 'func' on the statement, or, if asynchronous execution is enabled for it, in a worker thread: the first call of
+/// the function starts it and returns SQL_STILL_EXECUTING, and so do its repeated calls until it finishes, after which
+/// the result of 'func' is returned. 'func' must not refer to the arguments of the call, which are gone by then.
+/// The diagnostics are filled by the worker thread, and left intact by the polling calls. Meanwhile, the other functions
+/// are refused with HY010 (see Driver::call()), except for cancelling and reading the diagnostics.
+template <typename Callable>
+SQLRETURN CallMaybeAsync(SQLUSMALLINT function_id, SQLHSTMT handle, Callable && func) noexcept {
+    bool run_synchronously = false;
+
+    const auto rc = CALL_WITH_HANDLE_SKIP_DIAG(handle, [&] (Statement & statement) -> SQLRETURN {
+        if (statement.hasAsyncOperation())
+            return statement.pollAsyncOperation(function_id);
+
+        if (!statement.isAsyncEnabled()) {
+            run_synchronously = true;
+            return SQL_SUCCESS;
+        }
+
+        statement.startAsyncOperation(function_id, [handle, func] () mutable {
+            return CALL_WITH_HANDLE(handle, func);
+        });
+
+        return SQL_STILL_EXECUTING;
+    });
+
+    if (run_synchronously)
+        return CALL_WITH_HANDLE(handle, func);
+
+    return rc;
+}
+
+/// Usually called from another thread than the one executing a function on the handle, so the diagnostics,
+/// which belong to that function, are left intact.
+SQLRETURN Cancel(SQLSMALLINT handle_type, SQLHANDLE handle) noexcept {
+    switch (handle_type) {
+        case SQL_HANDLE_STMT:
+            return CALL_WITH_TYPED_HANDLE_SKIP_DIAG(SQL_HANDLE_STMT, handle, [&] (Statement & statement) {
+                statement.cancel();
+                return SQL_SUCCESS;
+            });
+
+        // No connection functions are executed asynchronously, so there is nothing to cancel.
+        case SQL_HANDLE_DBC:
+            return CALL_WITH_TYPED_HANDLE_SKIP_DIAG(SQL_HANDLE_DBC, handle, [&] (Connection &) {
+                return SQL_SUCCESS;
+            });
+    }
+
+    return SQL_ERROR;
+}
+
 } } // namespace impl
 
 
@@ -362,7 +414,7 @@ RETCODE SQL_API FUNCTION_MAYBE_W(SQLPrepare)(HSTMT statement_handle, SQLTCHAR *
 RETCODE SQL_API SQLExecute(HSTMT statement_handle) {
     LOG(__FUNCTION__);
 
-    return CALL_WITH_HANDLE(statement_handle, [&](Statement & statement) {
+    return impl::CallMaybeAsync(SQL_API_SQLEXECUTE, statement_handle, [](Statement & statement) {
         statement.executeQuery();
         return SQL_SUCCESS;
     });
@@ -372,8 +424,16 @@ RETCODE SQL_API SQLExecute(HSTMT statement_handle) {
 RETCODE SQL_API FUNCTION_MAYBE_W(SQLExecDirect)(HSTMT statement_handle, SQLTCHAR * statement_text, SQLINTEGER statement_text_size) {
     LOG(__FUNCTION__ << " statement_text_size=" << statement_text_size << " statement_text=" << statement_text);
 
-    return CALL_WITH_HANDLE(statement_handle, [&](Statement & statement) {
-        const auto query = stringFromSQLSymbols(statement_text, statement_text_size);
+    // Read while the text is still there, the statement may be executed after the call returns.
+    std::string query;
+    try {
+        query = stringFromSQLSymbols(statement_text, statement_text_size);
+    }
+    catch (const std::exception & ex) {
+        return CALL_WITH_HANDLE(statement_handle, [&](Statement &) -> SQLRETURN { throw std::runtime_error(ex.what()); });
+    }
+
+    return impl::CallMaybeAsync(SQL_API_SQLEXECDIRECT, statement_handle, [query](Statement & statement) {
         statement.executeQuery(query);
         return SQL_SUCCESS;
     });
@@ -590,139 +650,60 @@ RETCODE SQL_API impl_SQLGetData(HSTMT statement_handle,
         if (!statement.hasCurrentRow())
             throw SqlException("Invalid cursor state", "24000");
 
+        // There is no SQLSetPos to pick a row of a rowset, and SQL_GD_BLOCK is not supported.
+        if (statement.getEffectiveDescriptor(SQL_ATTR_APP_ROW_DESC).getAttrAs<SQLULEN>(SQL_DESC_ARRAY_SIZE, 1) > 1)
+            throw SqlException("Invalid cursor position", "HY109");
+
+        if (out_value_max_size < 0)
+            throw SqlException("Invalid string or buffer length", "HY090");
+
         const auto column_idx = column_or_param_number - 1;
 
-        const Field & field = statement.getCurrentRow().data[column_idx];
+        const auto field = statement.getCurrentField(column_idx);
 
         LOG("column: " << column_idx << ", target_type: " << target_type << ", out_value_max_size: " << out_value_max_size
-                       << " null=" << field.is_null << " data=" << field.data);
+                       << " null=" << field.isNull() << " data=" << field.toString());
 
-        if (field.is_null)
+        if (field.isNull())
             return fillOutputNULL(out_value, out_value_max_size, out_value_size_or_indicator);
 
-        switch (target_type) {
-            case SQL_C_CHAR:
-            case SQL_C_BINARY:
-                return fillOutputRawString(field.data, out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_WCHAR:
-                return fillOutputUSC2String(field.data, out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_TINYINT:
-            case SQL_C_STINYINT:
-                return fillOutputNumber<int8_t>(field.getInt(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_UTINYINT:
-            case SQL_C_BIT:
-                return fillOutputNumber<uint8_t>(field.getUInt(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_SHORT:
-            case SQL_C_SSHORT:
-                return fillOutputNumber<int16_t>(field.getInt(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_USHORT:
-                return fillOutputNumber<uint16_t>(field.getUInt(), out_value, out_value_max_size, out_value_size_or_indicator);
+        const auto converter = getColumnConverter(field.getEncoding(), target_type);
+        const auto code = converter(field, out_value, out_value_max_size, out_value_size_or_indicator);
 
-            case SQL_C_LONG:
-            case SQL_C_SLONG:
-                return fillOutputNumber<int32_t>(field.getInt(), out_value, out_value_max_size, out_value_size_or_indicator);
+        if (code == SQL_ERROR)
+            return fillConversionError(statement, field, target_type);
 
-            case SQL_C_ULONG:
-                return fillOutputNumber<uint32_t>(field.getUInt(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_SBIGINT:
-                return fillOutputNumber<int64_t>(field.getInt(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_UBIGINT:
-                return fillOutputNumber<uint64_t>(field.getUInt(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_FLOAT:
-                return fillOutputNumber<float>(field.getFloat(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_DOUBLE:
-                return fillOutputNumber<double>(field.getDouble(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_DATE:
-            case SQL_C_TYPE_DATE:
-                return fillOutputNumber<SQL_DATE_STRUCT>(field.getDate(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_C_TIMESTAMP:
-            case SQL_C_TYPE_TIMESTAMP:
-                return fillOutputNumber<SQL_TIMESTAMP_STRUCT>(
-                    field.getDateTime(), out_value, out_value_max_size, out_value_size_or_indicator);
-
-            case SQL_ARD_TYPE:
-            case SQL_C_DEFAULT:
-                LOG(__FUNCTION__ << ": Unsupported type requested (throw)." << target_type);
-                throw std::runtime_error("Unsupported type requested.");
-
-            default:
-                LOG(__FUNCTION__ << ": Unknown type requested (throw)." << target_type);
-                throw std::runtime_error("Unknown type requested.");
-        }
+        return code;
     });
 }
 
 
 RETCODE
-impl_SQLFetch(HSTMT statement_handle) {
+impl_SQLFetch(SQLUSMALLINT function_id, HSTMT statement_handle, SQLSMALLINT orientation = SQL_FETCH_NEXT, SQLLEN offset = 0) {
     LOG(__FUNCTION__);
 #ifndef NDEBUG
     SCOPE_EXIT({ LOG("impl_SQLFetch finish."); }); // for timing only
 #endif
 
-    return CALL_WITH_HANDLE(statement_handle, [&](Statement & statement) -> RETCODE {
-        auto * rows_fetched_ptr = statement.getEffectiveDescriptor(SQL_ATTR_IMP_ROW_DESC).getAttrAs<SQLULEN *>(SQL_DESC_ROWS_PROCESSED_PTR, 0);
-
-        if (rows_fetched_ptr)
-            *rows_fetched_ptr = 0;
-
-        if (!statement.hasResultSet())
-            return SQL_NO_DATA;
-
-        if (!statement.advanceToNextRow())
-            return SQL_NO_DATA;
-
-        if (rows_fetched_ptr)
-            *rows_fetched_ptr = 1;
-
-        // LOG("impl_SQLFetch statement.bindings.size()=" << statement.bindings.size());
+    return impl::CallMaybeAsync(function_id, statement_handle, [orientation, offset](Statement & statement) -> RETCODE {
+        const auto rowset_size = statement.getEffectiveDescriptor(SQL_ATTR_APP_ROW_DESC).getAttrAs<SQLULEN>(SQL_DESC_ARRAY_SIZE, 1);
+        auto & ird = statement.getEffectiveDescriptor(SQL_ATTR_IMP_ROW_DESC);
+        auto * rows_fetched_ptr = ird.getAttrAs<SQLULEN *>(SQL_DESC_ROWS_PROCESSED_PTR, 0);
+        auto * row_status_ptr = ird.getAttrAs<SQLUSMALLINT *>(SQL_DESC_ARRAY_STATUS_PTR, 0);
 
-        auto res = SQL_SUCCESS;
-
-        for (auto & col_num_binding : statement.bindings) {
-            auto code = impl_SQLGetData(statement_handle,
-                col_num_binding.first,
-                col_num_binding.second.type,
-                col_num_binding.second.value,
-                col_num_binding.second.value_max_size,
-                col_num_binding.second.value_size/* or .indicator */);
-
-            if (code == SQL_SUCCESS_WITH_INFO)
-                res = code;
-            else if (code != SQL_SUCCESS)
-                return code;
-        }
-
-        return res;
+        return statement.fetchRowset(orientation, offset, rowset_size, rows_fetched_ptr, row_status_ptr);
     });
 }
 
 
 RETCODE SQL_API SQLFetch(HSTMT statement_handle) {
-    return impl_SQLFetch(statement_handle);
+    return impl_SQLFetch(SQL_API_SQLFETCH, statement_handle);
 }
 
 
 RETCODE SQL_API SQLFetchScroll(HSTMT statement_handle, SQLSMALLINT orientation, SQLLEN offset) {
-    LOG(__FUNCTION__);
-
-    return CALL_WITH_HANDLE(statement_handle, [&](Statement & statement) -> RETCODE {
-        if (orientation != SQL_FETCH_NEXT)
-            throw SqlException("Fetch type out of range", "HY106");
-
-        return impl_SQLFetch(statement_handle);
-    });
+    LOG(__FUNCTION__ << " orientation=" << orientation << " offset=" << offset);
+    return impl_SQLFetch(SQL_API_SQLFETCHSCROLL, statement_handle, orientation, offset);
 }
 
 
@@ -759,6 +740,7 @@ RETCODE SQL_API SQLBindCol(HSTMT statement_handle,
         // Unbinding column
         if (out_value_size_or_indicator == nullptr) {
             statement.bindings.erase(column_number);
+            statement.invalidateFetchPlan();
             return SQL_SUCCESS;
         }
 
@@ -776,6 +758,7 @@ RETCODE SQL_API SQLBindCol(HSTMT statement_handle,
         binding.indicator = out_value_size_or_indicator;
 
         statement.bindings[column_number] = binding;
+        statement.invalidateFetchPlan();
 
         return SQL_SUCCESS;
     });
@@ -808,7 +791,7 @@ RETCODE SQL_API SQLDisconnect(HDBC connection_handle) {
     LOG(__FUNCTION__);
 
     return CALL_WITH_HANDLE(connection_handle, [&](Connection & connection) {
-        connection.session->reset();
+        connection.disconnect();
         return SQL_SUCCESS;
     });
 }
@@ -1179,9 +1162,8 @@ RETCODE SQL_API FUNCTION_MAYBE_W(SQLBrowseConnect)(HDBC connection_handle,
 
 
 RETCODE SQL_API SQLCancel(HSTMT StatementHandle) {
-    LOG(__FUNCTION__ << "Ignoring SQLCancel " << StatementHandle);
-    return SQL_SUCCESS;
-    //return SQL_ERROR;
+    LOG(__FUNCTION__ << " " << StatementHandle);
+    return impl::Cancel(SQL_HANDLE_STMT, StatementHandle);
 }
 
 
@@ -1248,6 +1230,7 @@ RETCODE SQL_API SQLGetFunctions(HDBC connection_handle, SQLUSMALLINT FunctionId,
             SET_EXISTS(SQL_API_SQLDESCRIBECOL);
             SET_EXISTS(SQL_API_SQLFETCH);
             SET_EXISTS(SQL_API_SQLFETCHSCROLL);
+            SET_EXISTS(SQL_API_SQLEXTENDEDFETCH);
             SET_EXISTS(SQL_API_SQLGETDATA);
             SET_EXISTS(SQL_API_SQLBINDCOL);
             SET_EXISTS(SQL_API_SQLROWCOUNT);
@@ -1263,7 +1246,12 @@ RETCODE SQL_API SQLGetFunctions(HDBC connection_handle, SQLUSMALLINT FunctionId,
             SET_EXISTS(SQL_API_SQLCLOSECURSOR);
             // CLR_EXISTS(SQL_API_SQLBROWSECONNECT);
             SET_EXISTS(SQL_API_SQLCANCEL);
-            // SET_EXISTS(SQL_API_SQLCANCELHANDLE);
+#if defined(SQL_API_SQLCANCELHANDLE)
+            SET_EXISTS(SQL_API_SQLCANCELHANDLE);
+#endif
+#if defined(SQL_API_SQLCOMPLETEASYNC)
+            SET_EXISTS(SQL_API_SQLCOMPLETEASYNC);
+#endif
             // CLR_EXISTS(SQL_API_SQLDATASOURCES);
             // CLR_EXISTS(SQL_API_SQLGETCURSORNAME);
             SET_EXISTS(SQL_API_SQLGETFUNCTIONS);
@@ -1409,7 +1397,19 @@ RETCODE SQL_API SQLExtendedFetch(HSTMT hstmt,
 #endif /* WITH_UNIXODBC */
     SQLUSMALLINT * rgfRowStatus) {
     LOG(__FUNCTION__);
-    return SQL_ERROR;
+
+    return CALL_WITH_HANDLE(hstmt, [&](Statement & statement) -> RETCODE {
+        // ODBC 2 rowsets are sized by SQL_ROWSET_SIZE, and their counters are passed directly.
+        const auto rowset_size = statement.getAttrAs<SQLULEN>(SQL_ROWSET_SIZE, 1);
+        SQLULEN rows_fetched = 0;
+
+        const auto rc = statement.fetchRowset(fFetchType, irow, rowset_size, &rows_fetched, rgfRowStatus);
+
+        if (pcrow)
+            *pcrow = rows_fetched;
+
+        return rc;
+    });
 }
 
 
@@ -1527,14 +1527,25 @@ SQLBulkOperations(
 
 
 RETCODE SQL_API SQLCancelHandle(SQLSMALLINT HandleType, SQLHANDLE Handle) {
-    LOG(__FUNCTION__);
-    return SQL_ERROR;
+    LOG(__FUNCTION__ << " HandleType=" << HandleType);
+    return impl::Cancel(HandleType, Handle);
 }
 
 
 RETCODE SQL_API SQLCompleteAsync(SQLSMALLINT HandleType, SQLHANDLE Handle, RETCODE * AsyncRetCodePtr) {
-    LOG(__FUNCTION__);
-    return SQL_ERROR;
+    LOG(__FUNCTION__ << " HandleType=" << HandleType);
+
+    if (HandleType != SQL_HANDLE_STMT)
+        return SQL_ERROR; // Only statement functions are executed asynchronously.
+
+    // The diagnostics are those of the completed function.
+    return CALL_WITH_TYPED_HANDLE_SKIP_DIAG(SQL_HANDLE_STMT, Handle, [&](Statement & statement) -> RETCODE {
+        if (!statement.hasAsyncOperation() || !AsyncRetCodePtr)
+            return SQL_ERROR;
+
+        *AsyncRetCodePtr = statement.waitForAsyncOperation();
+        return SQL_SUCCESS;
+    });
 }
 
 
@@ -93,6 +93,20 @@
 
 #define SIZEOF_CHAR sizeof(SQLTCHAR)
 
+#if !defined(SQL_DRIVER_STMT_ATTR_BASE)
+#    define SQL_DRIVER_STMT_ATTR_BASE 0x00004000
+#endif
+
+// Driver-specific statement attributes.
+#define SQL_ATTR_CH_READ_AHEAD_SIZE (SQL_DRIVER_STMT_ATTR_BASE + 1) /* Max size of a batch of rows read at once, in bytes */
+
+// Asynchronous notification of ODBC 3.8, set by the driver manager (sqlspi.h, which is not available everywhere).
+#if (ODBCVER >= 0x0380) && !defined(SQL_ATTR_ASYNC_STMT_PCALLBACK)
+#    define SQL_ATTR_ASYNC_STMT_PCALLBACK 10012
+#    define SQL_ATTR_ASYNC_STMT_PCONTEXT 10013
+typedef SQLRETURN (SQL_API * SQL_ASYNC_NOTIFICATION_CALLBACK)(SQLPOINTER pContext, BOOL fLast);
+#endif
+
 #if defined(_MSC_VER) && !defined(USE_SSL)
 // Enabled by default, but you can disable
 #    define USE_SSL 1
@@ -1,27 +1,75 @@
 #include "read_helpers.h"
 
+#include <algorithm>
 #include <stdexcept>
-#include <string>
-#include <iostream>
 
-void readSize(std::istream & istr, int32_t & res) {
-    istr.read(reinterpret_cast<char *>(&res), sizeof(res));
+BufferedReader::BufferedReader(std::istream & istr_, std::size_t chunk_size_)
+    : istr(istr_)
+    , chunk_size(std::max<std::size_t>(chunk_size_, 4096))
+{
 }
 
-void readString(std::istream & istr, std::string & res, bool * is_null) {
-    int32_t size = 0;
-    readSize(istr, size);
-
-    if (size >= 0) {
-        res.resize(size);
-        if (size > 0)
-            istr.read(&res[0], size);
-    } else if (size == -1) {
-        res.resize(0);
-        if (is_null)
-            *is_null = true;
+bool BufferedReader::fill(std::size_t size) {
+    if (end - pos >= size)
+        return true;
+
+    // Move the unconsumed tail (a value that straddles the chunk boundary) to the front.
+    if (pos > 0) {
+        if (end > pos)
+            std::memmove(buffer.data(), buffer.data() + pos, end - pos);
+        end -= pos;
+        pos = 0;
+    }
+
+    // Values larger than a chunk are the only reason to grow the buffer beyond the chunk size.
+    if (buffer.size() < std::max(size, chunk_size))
+        buffer.resize(std::max(size, chunk_size));
+
+    // Wait only for the bytes that are missing: the rest of a chunk may not even have been sent by the server yet.
+    while (end < size && !stream_exhausted) {
+        istr.read(buffer.data() + end, size - end);
+        end += istr.gcount();
+
+        if (!istr.good()) {
+            if (istr.bad())
+                throw std::runtime_error("Error while reading the result stream.");
+            stream_exhausted = true;
+        }
+    }
+
+    // Then take whatever has already arrived, up to the end of the chunk, without waiting for more.
+    if (!stream_exhausted && end < buffer.size()) {
+        end += istr.readsome(buffer.data() + end, buffer.size() - end);
+
+        if (!istr.good()) {
+            if (istr.bad())
+                throw std::runtime_error("Error while reading the result stream.");
+            stream_exhausted = true;
+        }
+    }
+
+    return end >= size;
+}
+
+bool drainStream(std::istream & in, std::size_t max_size, std::chrono::steady_clock::time_point deadline, std::size_t & drained,
+    const std::function<void (std::chrono::microseconds)> & set_read_timeout)
+{
+    drained = 0;
+    char buffer[16 * 1024];
+
+    // At least one read, even past the deadline: the rest may be there already, or there may be nothing left at all.
+    while (true) {
+        if (set_read_timeout) {
+            const auto time_left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+            set_read_timeout(std::max(time_left, std::chrono::microseconds{1000})); // A timeout of 0 would mean no timeout.
+        }
+
+        in.read(buffer, sizeof(buffer));
+        drained += static_cast<std::size_t>(in.gcount());
+
+        if (!in || drained > max_size || std::chrono::steady_clock::now() >= deadline)
+            break;
     }
 
-    if (!istr.good())
-        throw std::runtime_error("Incomplete result received. Want size=" + std::to_string(size) + ".");
+    return (in.eof() && !in.bad());
 }
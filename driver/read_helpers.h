@@ -1,6 +1,119 @@
 #pragma once
 
+#include "string_ref.h"
+
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+/// Reads the response stream in chunks of up to chunk_size into a reusable buffer and hands out
+/// length-prefixed ODBCDriver2 values as views into that buffer. A chunk is only waited for as far
+/// as the value being read needs, the rest of it is whatever the stream has already received.
+/// A value is copied (moved to the front of the buffer) only when it straddles a chunk boundary.
+class BufferedReader {
+public:
+    static constexpr std::size_t default_chunk_size = 1 << 20;
+
+    /// Sizes of values come from the stream as they are, larger ones are taken for a corrupt stream rather than allocated for.
+    /// The server does not read strings larger than this either.
+    static constexpr std::size_t max_value_size = std::size_t(1) << 30;
+
+    explicit BufferedReader(std::istream & istr_, std::size_t chunk_size_ = default_chunk_size);
+
+    /// Returns true if there is no more data, neither in the buffer nor in the underlying stream.
+    bool eof() {
+        return (pos == end && !fill(1));
+    }
+
+    /// Returns a pointer to the next 'size' contiguous bytes and consumes them.
+    /// The pointer is valid until the next read call.
+    const char * readRaw(std::size_t size) {
+        if (end - pos < size) {
+            if (size > max_value_size)
+                throw std::runtime_error("Invalid value size received: " + std::to_string(size) + ".");
+
+            if (!fill(size))
+                throw std::runtime_error("Incomplete result received. Want size=" + std::to_string(size) + ".");
+        }
+
+        const char * res = buffer.data() + pos;
+        pos += size;
+        return res;
+    }
+
+    void readSize(int32_t & res) {
+        std::memcpy(&res, readRaw(sizeof(res)), sizeof(res));
+    }
+
+    /// Reads a length-prefixed value. The view is valid until the next read call.
+    StringRef readString(bool * is_null = nullptr) {
+        int32_t size = 0;
+        readSize(size);
+
+        if (is_null)
+            *is_null = (size == -1);
+
+        if (size < 0) {
+            if (size != -1)
+                throw std::runtime_error("Invalid value size received: " + std::to_string(size) + ".");
+            return StringRef{"", 0};
+        }
+
+        return StringRef{readRaw(size), static_cast<std::size_t>(size)};
+    }
+
+    void readString(std::string & res, bool * is_null = nullptr) {
+        const auto value = readString(is_null);
+        res.assign(value.data, value.size);
+    }
+
+    /// Reads an unsigned LEB128 integer, as used for sizes in the RowBinary and Native formats.
+    uint64_t readVarUInt() {
+        uint64_t res = 0;
+        for (std::size_t i = 0; i < 10; ++i) {
+            const auto byte = static_cast<unsigned char>(*readRaw(1));
+            res |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+            if (!(byte & 0x80))
+                break;
+        }
+        return res;
+    }
+
+    /// Reads a varint-length-prefixed value of the RowBinary and Native formats. The view is valid until the next read call.
+    StringRef readBinaryString() {
+        const auto size = readVarUInt();
+        if (size > max_value_size)
+            throw std::runtime_error("Invalid value size received: " + std::to_string(size) + ".");
+
+        return StringRef{readRaw(static_cast<std::size_t>(size)), static_cast<std::size_t>(size)};
+    }
+
+    std::size_t getChunkSize() const {
+        return chunk_size;
+    }
+
+private:
+    /// Make at least 'size' unconsumed bytes available in the buffer, reading more from the stream if needed.
+    /// Returns false if the stream ended before that.
+    bool fill(std::size_t size);
+
+private:
+    std::istream & istr;
+    const std::size_t chunk_size;
+    std::vector<char> buffer;
+    std::size_t pos = 0;
+    std::size_t end = 0;
+    bool stream_exhausted = false;
+};
 
-void readSize(std::istream & istr, int32_t & res);
-void readString(std::istream & istr, std::string & res, bool * is_null = nullptr);
+/// Read and drop the rest of 'in', unless more than 'max_size' bytes of it are left, or it has not arrived by 'deadline'.
+/// 'set_read_timeout', if set, is called before each read with the time left, for a blocking read to wait no longer.
+/// Returns true if the end of the stream has been reached without an error. 'drained' is set to the number of bytes dropped.
+bool drainStream(std::istream & in, std::size_t max_size, std::chrono::steady_clock::time_point deadline, std::size_t & drained,
+    const std::function<void (std::chrono::microseconds)> & set_read_timeout = {});
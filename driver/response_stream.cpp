@@ -0,0 +1,146 @@
+#include "response_stream.h"
+
+#include <Poco/DeflatingStream.h>
+#include <Poco/InflatingStream.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <cstring>
+
+bool isSupportedCompression(const std::string & compression) {
+    return (
+        compression == "none" ||
+        compression == "gzip" ||
+        compression == "deflate"
+    );
+}
+
+std::string getAcceptEncoding(const std::string & compression) {
+    if (compression == "none")
+        return std::string{};
+
+    if (!isSupportedCompression(compression))
+        throw std::runtime_error("Unsupported compression: " + compression);
+
+    return compression;
+}
+
+std::string compressBody(const std::string & body, const std::string & content_encoding) {
+    Poco::DeflatingStreamBuf::StreamType type = Poco::DeflatingStreamBuf::STREAM_ZLIB;
+
+    if (content_encoding == "gzip")
+        type = Poco::DeflatingStreamBuf::STREAM_GZIP;
+    else if (content_encoding != "deflate")
+        throw std::runtime_error("Unsupported Content-Encoding of the request: " + content_encoding);
+
+    // Fast compression: text compresses well at any level, and the point is to save time on the wire, not to spend it here.
+    std::ostringstream out;
+    Poco::DeflatingOutputStream deflating(out, type, 1);
+    deflating.write(body.data(), body.size());
+    deflating.close();
+
+    if (!out)
+        throw std::runtime_error("Error while compressing the request body.");
+
+    return out.str();
+}
+
+CountingStreamBuf::CountingStreamBuf(std::istream & source_, std::size_t buffer_size)
+    : source(source_)
+    , buffer(std::max<std::size_t>(buffer_size, 4096))
+{
+}
+
+std::streamsize CountingStreamBuf::readFromSource(char * dest, std::streamsize size) {
+    if (size <= 0)
+        return 0;
+
+    // Wait only for the first byte, then take whatever else has already arrived with it.
+    source.read(dest, 1);
+    auto read = source.gcount();
+    if (read > 0 && size > 1)
+        read += source.readsome(dest + 1, size - 1);
+
+    count += read;
+
+    if (source.bad())
+        throw std::runtime_error("Error while reading the response stream.");
+
+    return read;
+}
+
+std::streamsize CountingStreamBuf::showmanyc() {
+    // What the source holds can be taken without waiting, see readFromSource().
+    return source.rdbuf()->in_avail();
+}
+
+CountingStreamBuf::int_type CountingStreamBuf::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    const auto read = readFromSource(buffer.data(), buffer.size());
+    if (read <= 0)
+        return traits_type::eof();
+
+    setg(buffer.data(), buffer.data(), buffer.data() + read);
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize CountingStreamBuf::xsgetn(char * dest, std::streamsize size) {
+    std::streamsize done = 0;
+
+    // Whatever is left in the buffer goes first.
+    const auto buffered = std::min<std::streamsize>(egptr() - gptr(), size);
+    if (buffered > 0) {
+        std::memcpy(dest, gptr(), buffered);
+        gbump(static_cast<int>(buffered));
+        done += buffered;
+    }
+
+    // Unlike a single read from the source, this waits until all of 'size' bytes are there, as sgetn() is expected to.
+    while (done < size) {
+        const auto remaining = size - done;
+
+        if (remaining >= static_cast<std::streamsize>(buffer.size())) {
+            const auto read = readFromSource(dest + done, remaining);
+            if (read <= 0)
+                break;
+            done += read;
+        }
+        else {
+            if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+                break;
+
+            const auto chunk = std::min<std::streamsize>(egptr() - gptr(), remaining);
+            std::memcpy(dest + done, gptr(), chunk);
+            gbump(static_cast<int>(chunk));
+            done += chunk;
+        }
+    }
+
+    return done;
+}
+
+ResponseStream::ResponseStream(std::istream & raw, const std::string & content_encoding_)
+    : content_encoding(content_encoding_)
+    , received_buf(raw)
+    , received(&received_buf)
+{
+    if (content_encoding.empty() || content_encoding == "identity") {
+        decoded = &received;
+        return;
+    }
+
+    if (content_encoding == "gzip")
+        inflating = std::make_unique<Poco::InflatingInputStream>(received, Poco::InflatingStreamBuf::STREAM_GZIP);
+    else if (content_encoding == "deflate")
+        inflating = std::make_unique<Poco::InflatingInputStream>(received, Poco::InflatingStreamBuf::STREAM_ZLIB);
+    else
+        throw std::runtime_error("Unsupported Content-Encoding of the response: " + content_encoding);
+
+    decoded_buf = std::make_unique<CountingStreamBuf>(*inflating);
+    decoded_stream = std::make_unique<std::istream>(decoded_buf.get());
+    decoded = decoded_stream.get();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+/// Returns true if the value of the Compression setting is recognized: none, gzip or deflate.
+bool isSupportedCompression(const std::string & compression);
+
+/// Returns the value of the Accept-Encoding header to request responses with, or an empty string if compression is disabled.
+/// The same value names the encoding in the Content-Encoding header of compressed requests.
+std::string getAcceptEncoding(const std::string & compression);
+
+/// Compresses a request body for sending it with the Content-Encoding header set to 'content_encoding' (gzip or deflate).
+std::string compressBody(const std::string & body, const std::string & content_encoding);
+
+/// Passes the data of an input stream through, counting the bytes. Reads that are at least as large as
+/// the internal buffer go directly into the caller's memory, so the counting costs no extra copy for the
+/// large chunks BufferedReader reads in. Refilling the buffer waits only until some data arrives, not until
+/// the whole buffer can be filled, and the data the source already holds is reported as available to readsome().
+class CountingStreamBuf
+    : public std::streambuf
+{
+public:
+    explicit CountingStreamBuf(std::istream & source_, std::size_t buffer_size = 64 * 1024);
+
+    std::uint64_t getCount() const {
+        return count;
+    }
+
+protected:
+    virtual int_type underflow() override;
+    virtual std::streamsize showmanyc() override;
+    virtual std::streamsize xsgetn(char * dest, std::streamsize size) override;
+
+private:
+    std::streamsize readFromSource(char * dest, std::streamsize size);
+
+private:
+    std::istream & source;
+    std::vector<char> buffer;
+    std::uint64_t count = 0;
+};
+
+/// The body of an HTTP response, decoded according to its Content-Encoding while it is being read.
+/// Keeps track of how many bytes were received over the wire and how many were produced by decoding them.
+class ResponseStream {
+public:
+    /// Throws if the content encoding is not supported.
+    ResponseStream(std::istream & raw, const std::string & content_encoding);
+
+    /// The decoded stream, to read the result from.
+    std::istream & get() {
+        return *decoded;
+    }
+
+    const std::string & getContentEncoding() const {
+        return content_encoding;
+    }
+
+    std::uint64_t getReceivedBytes() const {
+        return received_buf.getCount();
+    }
+
+    std::uint64_t getDecodedBytes() const {
+        return (decoded_buf ? decoded_buf->getCount() : received_buf.getCount());
+    }
+
+private:
+    const std::string content_encoding;
+    CountingStreamBuf received_buf;
+    std::istream received;
+    std::unique_ptr<std::istream> inflating;
+    std::unique_ptr<CountingStreamBuf> decoded_buf;
+    std::unique_ptr<std::istream> decoded_stream;
+    std::istream * decoded = nullptr;
+};
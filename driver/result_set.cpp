@@ -1,86 +1,278 @@
 #include "result_set.h"
 
+#include "diagnostics.h"
 #include "statement.h"
+#include "value_decoder.h"
 
-uint64_t Field::getUInt() const {
-    try {
-        return std::stoull(data);
-    } catch (std::exception & e) {
-        throw std::runtime_error("Cannot interpret '" + data + "' as uint64: " + e.what());
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+template <typename T>
+std::string formatFloat(T value) {
+    // Use the shortest representation that reads back as the same value, like the server does.
+    const int max_precision = std::numeric_limits<T>::max_digits10;
+    char buf[64];
+    for (int precision = std::numeric_limits<T>::digits10; precision <= max_precision; ++precision) {
+        std::snprintf(buf, sizeof(buf), "%.*g", precision, static_cast<double>(value));
+        if (precision == max_precision || static_cast<T>(std::strtod(buf, nullptr)) == value)
+            break;
     }
+    return buf;
 }
-int64_t Field::getInt() const {
-    try {
-        return std::stoll(data);
-    } catch (std::exception & e) {
-        throw std::runtime_error("Cannot interpret '" + data + "' as int64: " + e.what());
+
+std::string formatDateTime(const SQL_TIMESTAMP_STRUCT & value, bool with_time) {
+    char buf[32];
+    if (with_time)
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d", value.year, value.month, value.day, value.hour, value.minute, value.second);
+    else
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", value.year, value.month, value.day);
+    return buf;
+}
+
+std::size_t getValueSize(ValueEncoding encoding) {
+    switch (encoding) {
+        case ValueEncoding::Text:     return 0;
+        case ValueEncoding::Int8:     return sizeof(int8_t);
+        case ValueEncoding::Int16:    return sizeof(int16_t);
+        case ValueEncoding::Int32:    return sizeof(int32_t);
+        case ValueEncoding::Int64:    return sizeof(int64_t);
+        case ValueEncoding::UInt8:    return sizeof(uint8_t);
+        case ValueEncoding::UInt16:   return sizeof(uint16_t);
+        case ValueEncoding::UInt32:   return sizeof(uint32_t);
+        case ValueEncoding::UInt64:   return sizeof(uint64_t);
+        case ValueEncoding::Float32:  return sizeof(float);
+        case ValueEncoding::Float64:  return sizeof(double);
+        case ValueEncoding::Date:     return sizeof(uint16_t);
+        case ValueEncoding::DateTime: return sizeof(int64_t);
     }
+    return 0;
 }
-float Field::getFloat() const {
-    try {
-        return std::stof(data);
-    } catch (std::exception & e) {
-        throw std::runtime_error("Cannot interpret '" + data + "' as float: " + e.what());
+
+} // namespace
+
+std::string Field::toString() const {
+    switch (encoding) {
+        case ValueEncoding::Text:     return {data_ptr, data_size};
+        case ValueEncoding::Int8:     return std::to_string(getBinary<int8_t>());
+        case ValueEncoding::Int16:    return std::to_string(getBinary<int16_t>());
+        case ValueEncoding::Int32:    return std::to_string(getBinary<int32_t>());
+        case ValueEncoding::Int64:    return std::to_string(getBinary<int64_t>());
+        case ValueEncoding::UInt8:    return std::to_string(getBinary<uint8_t>());
+        case ValueEncoding::UInt16:   return std::to_string(getBinary<uint16_t>());
+        case ValueEncoding::UInt32:   return std::to_string(getBinary<uint32_t>());
+        case ValueEncoding::UInt64:   return std::to_string(getBinary<uint64_t>());
+        case ValueEncoding::Float32:  return formatFloat(getBinary<float>());
+        case ValueEncoding::Float64:  return formatFloat(getBinary<double>());
+        case ValueEncoding::Date:     return formatDateTime(getDateTime(), false);
+        case ValueEncoding::DateTime: return formatDateTime(getDateTime(), true);
+    }
+    return {};
+}
+
+bool isBinaryOfCType(ValueEncoding encoding, SQLSMALLINT c_type) {
+    switch (encoding) {
+        case ValueEncoding::Int8:    return (c_type == SQL_C_TINYINT || c_type == SQL_C_STINYINT);
+        case ValueEncoding::Int16:   return (c_type == SQL_C_SHORT || c_type == SQL_C_SSHORT);
+        case ValueEncoding::Int32:   return (c_type == SQL_C_LONG || c_type == SQL_C_SLONG);
+        case ValueEncoding::Int64:   return (c_type == SQL_C_SBIGINT);
+        case ValueEncoding::UInt8:   return (c_type == SQL_C_UTINYINT);
+        case ValueEncoding::UInt16:  return (c_type == SQL_C_USHORT);
+        case ValueEncoding::UInt32:  return (c_type == SQL_C_ULONG);
+        case ValueEncoding::UInt64:  return (c_type == SQL_C_UBIGINT);
+        case ValueEncoding::Float32: return (c_type == SQL_C_FLOAT);
+        case ValueEncoding::Float64: return (c_type == SQL_C_DOUBLE);
+        default:                     return false;
+    }
+}
+
+bool Field::isBinaryOfCType(SQLSMALLINT c_type) const {
+    return ::isBinaryOfCType(encoding, c_type);
+}
+
+namespace {
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, ParseStatus>::type parseText(const char * data, std::size_t size, T & res) {
+    return parseNumber(data, size, res);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, ParseStatus>::type parseText(const char * data, std::size_t size, T & res) {
+    const auto status = parseNumber(data, size, res);
+    if (status != ParseStatus::Invalid)
+        return status;
+
+    // Not an integer, but possibly a number with a fraction (or an exponent), which is truncated.
+    double value = 0;
+    if (parseNumber(data, size, value) != ParseStatus::Ok || std::isnan(value))
+        return ParseStatus::Invalid;
+
+    // Truncation towards zero must land within the range.
+    return narrowNumber(value, res);
+}
+
+} // namespace
+
+template <typename T>
+ParseStatus Field::tryGetNumber(T & res) const {
+    switch (encoding) {
+        case ValueEncoding::Int8:    return narrowNumber(getBinary<int8_t>(), res);
+        case ValueEncoding::Int16:   return narrowNumber(getBinary<int16_t>(), res);
+        case ValueEncoding::Int32:   return narrowNumber(getBinary<int32_t>(), res);
+        case ValueEncoding::Int64:   return narrowNumber(getBinary<int64_t>(), res);
+        case ValueEncoding::UInt8:   return narrowNumber(getBinary<uint8_t>(), res);
+        case ValueEncoding::UInt16:  return narrowNumber(getBinary<uint16_t>(), res);
+        case ValueEncoding::UInt32:  return narrowNumber(getBinary<uint32_t>(), res);
+        case ValueEncoding::UInt64:  return narrowNumber(getBinary<uint64_t>(), res);
+        case ValueEncoding::Float32: return narrowNumber(getBinary<float>(), res);
+        case ValueEncoding::Float64: return narrowNumber(getBinary<double>(), res);
+        case ValueEncoding::Text:    return parseText(data_ptr, data_size, res);
+        default:                     break;
+    }
+
+    const auto text = toString();
+    return parseText(text.data(), text.size(), res);
+}
+
+template ParseStatus Field::tryGetNumber<uint64_t>(uint64_t & res) const;
+template ParseStatus Field::tryGetNumber<int64_t>(int64_t & res) const;
+template ParseStatus Field::tryGetNumber<float>(float & res) const;
+template ParseStatus Field::tryGetNumber<double>(double & res) const;
+
+template <typename T>
+T Field::getNumber(const char * type_name) const {
+    T res = 0;
+    switch (tryGetNumber(res)) {
+        case ParseStatus::Ok:
+            return res;
+        case ParseStatus::OutOfRange:
+            throw SqlException("Value '" + toString() + "' is out of range of " + type_name, "22003");
+        default:
+            throw SqlException("Cannot interpret '" + toString() + "' as " + type_name, "22018");
     }
 }
+
+uint64_t Field::getUInt() const {
+    return getNumber<uint64_t>("uint64");
+}
+
+int64_t Field::getInt() const {
+    return getNumber<int64_t>("int64");
+}
+
+float Field::getFloat() const {
+    return getNumber<float>("float");
+}
+
 double Field::getDouble() const {
-    try {
-        return std::stod(data);
-    } catch (std::exception & e) {
-        throw std::runtime_error("Cannot interpret '" + data + "' as double: " + e.what());
+    return getNumber<double>("double");
+}
+
+ParseStatus Field::tryGetDate(SQL_DATE_STRUCT & res) const {
+    if (encoding == ValueEncoding::Date) {
+        res = dateFromDays(getBinary<uint16_t>());
+        return ParseStatus::Ok;
+    }
+
+    if (encoding == ValueEncoding::DateTime) {
+        const auto date_time = dateTimeFromSeconds(getBinary<int64_t>());
+        res.year = date_time.year;
+        res.month = date_time.month;
+        res.day = date_time.day;
+        return ParseStatus::Ok;
     }
+
+    if (encoding != ValueEncoding::Text)
+        return ParseStatus::Invalid;
+
+    return parseDate(data_ptr, data_size, res);
 }
 
-SQL_DATE_STRUCT Field::getDate() const {
-    if (data.size() != 10)
-        throw std::runtime_error("Cannot interpret '" + data + "' as Date");
+ParseStatus Field::tryGetDateTime(SQL_TIMESTAMP_STRUCT & res) const {
+    if (encoding == ValueEncoding::Date) {
+        res = dateTimeFromSeconds(static_cast<int64_t>(getBinary<uint16_t>()) * 86400);
+        return ParseStatus::Ok;
+    }
 
-    SQL_DATE_STRUCT res;
-    res.year = (data[0] - '0') * 1000 + (data[1] - '0') * 100 + (data[2] - '0') * 10 + (data[3] - '0');
-    res.month = (data[5] - '0') * 10 + (data[6] - '0');
-    res.day = (data[8] - '0') * 10 + (data[9] - '0');
+    if (encoding == ValueEncoding::DateTime) {
+        res = dateTimeFromSeconds(getBinary<int64_t>());
+        return ParseStatus::Ok;
+    }
 
-    normalizeDate(res);
+    if (encoding != ValueEncoding::Text)
+        return ParseStatus::Invalid;
 
-    return res;
+    return parseDateTime(data_ptr, data_size, res);
+}
+
+SQL_DATE_STRUCT Field::getDate() const {
+    SQL_DATE_STRUCT res;
+    switch (tryGetDate(res)) {
+        case ParseStatus::Ok:
+            return res;
+        case ParseStatus::OutOfRange:
+            throw SqlException("Invalid Date '" + toString() + "'", "22008");
+        default:
+            throw SqlException("Cannot interpret '" + toString() + "' as Date", "22018");
+    }
 }
 
 SQL_TIMESTAMP_STRUCT Field::getDateTime() const {
     SQL_TIMESTAMP_STRUCT res;
-
-    if (data.size() == 10) {
-        res.year = (data[0] - '0') * 1000 + (data[1] - '0') * 100 + (data[2] - '0') * 10 + (data[3] - '0');
-        res.month = (data[5] - '0') * 10 + (data[6] - '0');
-        res.day = (data[8] - '0') * 10 + (data[9] - '0');
-        res.hour = 0;
-        res.minute = 0;
-        res.second = 0;
-        res.fraction = 0;
-    } else if (data.size() == 19) {
-        res.year = (data[0] - '0') * 1000 + (data[1] - '0') * 100 + (data[2] - '0') * 10 + (data[3] - '0');
-        res.month = (data[5] - '0') * 10 + (data[6] - '0');
-        res.day = (data[8] - '0') * 10 + (data[9] - '0');
-        res.hour = (data[11] - '0') * 10 + (data[12] - '0');
-        res.minute = (data[14] - '0') * 10 + (data[15] - '0');
-        res.second = (data[17] - '0') * 10 + (data[18] - '0');
-        res.fraction = 0;
-    } else {
-        throw std::runtime_error("Cannot interpret '" + data + "' as DateTime");
+    switch (tryGetDateTime(res)) {
+        case ParseStatus::Ok:
+            return res;
+        case ParseStatus::OutOfRange:
+            throw SqlException("Invalid DateTime '" + toString() + "'", "22008");
+        default:
+            throw SqlException("Cannot interpret '" + toString() + "' as DateTime", "22018");
     }
+}
 
-    normalizeDate(res);
+SQL_DATE_STRUCT dateFromDays(int64_t days) {
+    // Civil from days, see http://howardhinnant.github.io/date_algorithms.html
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t day_of_era = days - era * 146097;
+    const int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const int64_t mp = (5 * day_of_year + 2) / 153;
+    const int64_t day = day_of_year - (153 * mp + 2) / 5 + 1;
+    const int64_t month = (mp < 10 ? mp + 3 : mp - 9);
 
+    SQL_DATE_STRUCT res;
+    res.year = static_cast<SQLSMALLINT>(year_of_era + era * 400 + (month <= 2 ? 1 : 0));
+    res.month = static_cast<SQLUSMALLINT>(month);
+    res.day = static_cast<SQLUSMALLINT>(day);
     return res;
 }
 
-template <typename T>
-void Field::normalizeDate(T & date) const {
-    if (date.year == 0)
-        date.year = 1970;
-    if (date.month == 0)
-        date.month = 1;
-    if (date.day == 0)
-        date.day = 1;
+SQL_TIMESTAMP_STRUCT dateTimeFromSeconds(int64_t seconds) {
+    int64_t days = seconds / 86400;
+    int64_t seconds_of_day = seconds % 86400;
+    if (seconds_of_day < 0) {
+        seconds_of_day += 86400;
+        --days;
+    }
+
+    const auto date = dateFromDays(days);
+
+    SQL_TIMESTAMP_STRUCT res;
+    res.year = date.year;
+    res.month = date.month;
+    res.day = date.day;
+    res.hour = static_cast<SQLUSMALLINT>(seconds_of_day / 3600);
+    res.minute = static_cast<SQLUSMALLINT>(seconds_of_day % 3600 / 60);
+    res.second = static_cast<SQLUSMALLINT>(seconds_of_day % 60);
+    res.fraction = 0;
+    return res;
 }
 
 void assignTypeInfo(const TypeAst & ast, ColumnInfo * info) {
@@ -97,50 +289,74 @@ void assignTypeInfo(const TypeAst & ast, ColumnInfo * info) {
     }
 }
 
-ResultSet::ResultSet(std::istream & in_, IResultMutatorPtr && mutator_)
-    : in(in_)
+void assignTypeInfo(const std::string & type, ColumnInfo * info) {
+    TypeAst ast;
+    if (TypeParser(type).parse(&ast)) {
+        assignTypeInfo(ast, info);
+    } else {
+        // Interprete all unknown types as String.
+        info->type_without_parameters = "String";
+    }
+}
+
+ResultSet::ResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size)
+    : in(in_, read_buffer_size)
     , mutator(std::move(mutator_))
 {
-    if (in.peek() == EOF) {
+}
+
+constexpr std::size_t ResultSet::default_read_ahead_size;
+constexpr std::size_t ResultSet::first_batch_rows;
+constexpr std::size_t ResultSet::max_batch_rows;
+
+ResultSet::~ResultSet() {
+    if (max_batch_size > 0)
+        LOG("Read-ahead high-water mark: " << max_batch_size << " bytes in a batch of " << max_batch_size_rows << " rows, limit "
+                                           << read_ahead_size << " bytes");
+}
+
+void ResultSet::finishHeader() {
+    if (mutator)
+        mutator->UpdateColumnInfo(&columns_info);
+
+    prepareSomeRows();
+}
+
+ODBCDriver2ResultSet::ODBCDriver2ResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size)
+    : RowWiseResultSet(in_, std::move(mutator_), read_buffer_size)
+{
+    if (in.eof()) {
         finished = true;
         return;
     }
 
     int32_t num_header_rows = 0;
-    readSize(in, num_header_rows);
+    in.readSize(num_header_rows);
     if (!num_header_rows)
         return;
 
     for (size_t row_n = 0; row_n < num_header_rows; ++row_n) {
         /// Title: number of columns, their names and types.
         int32_t num_columns = 0;
-        readSize(in, num_columns);
+        in.readSize(num_columns);
 
         if (num_columns <= 1)
             return;
 
         std::string row_name;
-        readString(in, row_name);
+        in.readString(row_name);
         --num_columns;
 
         if (row_name == "name") {
             columns_info.resize(num_columns);
             for (size_t i = 0; i < num_columns; ++i) {
-                readString(in, columns_info[i].name);
+                in.readString(columns_info[i].name);
             }
         } else if (row_name == "type") {
             columns_info.resize(num_columns);
             for (size_t i = 0; i < num_columns; ++i) {
-                readString(in, columns_info[i].type);
-                {
-                    TypeAst ast;
-                    if (TypeParser(columns_info[i].type).parse(&ast)) {
-                        assignTypeInfo(ast, &columns_info[i]);
-                    } else {
-                        // Interprete all unknown types as String.
-                        columns_info[i].type_without_parameters = "String";
-                    }
-                }
+                in.readString(columns_info[i].type);
+                assignTypeInfo(columns_info[i].type, &columns_info[i]);
                 LOG("Row " << i << " name=" << columns_info[i].name << " type=" << columns_info[i].type << " -> " << columns_info[i].type
                            << " typenoparams=" << columns_info[i].type_without_parameters << " fixedsize=" << columns_info[i].fixed_size);
             }
@@ -150,16 +366,161 @@ ResultSet::ResultSet(std::istream & in_, IResultMutatorPtr && mutator_)
         } else {
             LOG("Unknown header " << row_name << "; Columns left: " << num_columns);
             for (size_t i = 0; i < num_columns; ++i) {
-                std::string dummy;
-                readString(in, dummy);
+                in.readString();
             }
         }
     }
 
-    if (mutator)
-        mutator->UpdateColumnInfo(&columns_info);
+    finishHeader();
+}
 
-    prepareSomeRows();
+ODBCDriver2ResultSet::~ODBCDriver2ResultSet() {
+    stopPrefetching();
+}
+
+void ODBCDriver2ResultSet::readRow(ColumnBatch & batch) {
+    for (size_t j = 0; j < columns_info.size(); ++j) {
+        bool is_null = false;
+        const auto value = in.readString(&is_null);
+        batch.appendValue(j, value.data, value.size, is_null);
+    }
+}
+
+RowBinaryWithNamesAndTypesResultSet::RowBinaryWithNamesAndTypesResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size, const std::string & server_time_zone)
+    : RowWiseResultSet(in_, std::move(mutator_), read_buffer_size)
+{
+    if (in.eof()) {
+        finished = true;
+        return;
+    }
+
+    /// Header: number of columns, their names, then their types.
+    columns_info.resize(in.readVarUInt());
+
+    for (auto & column_info : columns_info) {
+        column_info.name = in.readBinaryString().toString();
+    }
+
+    decoders.reserve(columns_info.size());
+    for (auto & column_info : columns_info) {
+        column_info.type = in.readBinaryString().toString();
+        assignTypeInfo(column_info.type, &column_info);
+
+        decoders.emplace_back(makeValueDecoder(column_info.type, server_time_zone));
+        column_info.encoding = decoders.back()->getEncoding();
+        column_info.display_size = decoders.back()->getDisplaySize();
+
+        LOG("Column name=" << column_info.name << " type=" << column_info.type << " typenoparams=" << column_info.type_without_parameters
+                           << " fixedsize=" << column_info.fixed_size << " binary=" << (column_info.encoding != ValueEncoding::Text));
+    }
+
+    finishHeader();
+}
+
+RowBinaryWithNamesAndTypesResultSet::~RowBinaryWithNamesAndTypesResultSet() {
+    stopPrefetching();
+}
+
+void RowBinaryWithNamesAndTypesResultSet::readRow(ColumnBatch & batch) {
+    for (size_t j = 0; j < decoders.size(); ++j) {
+        decoders[j]->decodeTo(in, batch, j);
+    }
+}
+
+NativeResultSet::NativeResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size, const std::string & server_time_zone_)
+    : ResultSet(in_, std::move(mutator_), read_buffer_size)
+    , server_time_zone(server_time_zone_)
+{
+    if (in.eof()) {
+        finished = true;
+        return;
+    }
+
+    readBlock(first_block, true);
+    has_first_block = true;
+
+    finishHeader();
+}
+
+NativeResultSet::~NativeResultSet() {
+    stopPrefetching();
+}
+
+void NativeResultSet::readRows(ColumnBatch & batch, std::size_t /* max_rows */, std::size_t /* max_bytes */) {
+    // Blocks are taken as they are sent by the server.
+    if (has_first_block) {
+        has_first_block = false;
+        std::swap(batch, first_block);
+    }
+
+    // Skip empty blocks, if any.
+    while (batch.getNumRows() == 0) {
+        if (in.eof()) {
+            finished = true;
+            break;
+        }
+
+        readBlock(batch, false);
+    }
+}
+
+void NativeResultSet::readBlock(ColumnBatch & batch, bool is_first_block) {
+    /// Block: number of columns, number of rows, then name, type and data of every column.
+    const auto num_columns = in.readVarUInt();
+    const auto num_rows = in.readVarUInt();
+
+    if (is_first_block) {
+        columns_info.resize(num_columns);
+        decoders.reserve(num_columns);
+        batch.clear(columns_info);
+    } else if (num_columns != columns_info.size()) {
+        throw std::runtime_error("Unexpected number of columns in a block: " + std::to_string(num_columns) + ", expected "
+            + std::to_string(columns_info.size()) + ".");
+    }
+
+    for (std::size_t j = 0; j < num_columns; ++j) {
+        const auto name = in.readBinaryString().toString();
+        const auto type = in.readBinaryString().toString();
+
+        if (is_first_block) {
+            if (type.find("LowCardinality(") != std::string::npos)
+                throw std::runtime_error("Native serialization of LowCardinality columns is not supported, column " + name);
+
+            auto & column_info = columns_info[j];
+            column_info.name = name;
+            column_info.type = type;
+            assignTypeInfo(column_info.type, &column_info);
+
+            decoders.emplace_back(makeValueDecoder(column_info.type, server_time_zone));
+            column_info.encoding = decoders.back()->getEncoding();
+            column_info.display_size = decoders.back()->getDisplaySize();
+            batch.resetColumn(j, column_info.encoding);
+
+            LOG("Column name=" << column_info.name << " type=" << column_info.type << " typenoparams=" << column_info.type_without_parameters
+                               << " fixedsize=" << column_info.fixed_size << " binary=" << (column_info.encoding != ValueEncoding::Text));
+        }
+
+        decoders[j]->decodeColumnTo(in, batch, j, num_rows);
+    }
+
+    batch.finishRows(num_rows);
+}
+
+bool isSupportedResultFormat(const std::string & format) {
+    return (format == "ODBCDriver2" || format == "RowBinaryWithNamesAndTypes" || format == "Native");
+}
+
+std::unique_ptr<ResultSet> makeResultSet(const std::string & format, std::istream & in, IResultMutatorPtr && mutator, std::size_t read_buffer_size, const std::string & server_time_zone) {
+    if (format == "ODBCDriver2")
+        return std::make_unique<ODBCDriver2ResultSet>(in, std::move(mutator), read_buffer_size);
+
+    if (format == "RowBinaryWithNamesAndTypes")
+        return std::make_unique<RowBinaryWithNamesAndTypesResultSet>(in, std::move(mutator), read_buffer_size, server_time_zone);
+
+    if (format == "Native")
+        return std::make_unique<NativeResultSet>(in, std::move(mutator), read_buffer_size, server_time_zone);
+
+    throw std::runtime_error("Unsupported result format: " + format);
 }
 
 size_t ResultSet::getNumColumns() const {
@@ -171,11 +532,24 @@ const ColumnInfo & ResultSet::getColumnInfo(size_t i) const {
 }
 
 bool ResultSet::hasCurrentRow() const {
-    return current_row.isValid();
+    return has_current_row;
+}
+
+Field ResultSet::getCurrentField(std::size_t column_idx) const {
+    if (mutator) {
+        const auto & value = current_row.data[column_idx];
+        return Field{value.data.c_str(), value.data.size(), value.is_null};
+    }
+
+    return batch.getField(current_batch_row, column_idx);
 }
 
-const Row & ResultSet::getCurrentRow() const {
-    return current_row;
+ValueEncoding ResultSet::getFieldEncoding(std::size_t column_idx) const {
+    // Rows modified by a mutator are kept as text.
+    if (mutator)
+        return ValueEncoding::Text;
+
+    return columns_info[column_idx].encoding;
 }
 
 std::size_t ResultSet::getCurrentRowNum() const {
@@ -183,50 +557,311 @@ std::size_t ResultSet::getCurrentRowNum() const {
 }
 
 bool ResultSet::advanceToNextRow() {
-    if (endOfSet()) {
+    if (isRowLimitReached() || endOfSet()) {
+        has_current_row = false;
         current_row = Row{};
     }
     else {
-        current_row = std::move(ready_raw_rows.front());
-        ready_raw_rows.pop_front();
+        current_batch_row = next_batch_row++;
+        has_current_row = true;
         ++current_row_num;
 
-        if (mutator)
+        if (mutator) {
+            const auto num_columns = getNumColumns();
+            current_row.data.resize(num_columns);
+            for (std::size_t j = 0; j < num_columns; ++j) {
+                const auto field = batch.getField(current_batch_row, j);
+                if (field.isText())
+                    current_row.data[j].data.assign(field.data(), field.size());
+                else
+                    current_row.data[j].data = field.toString();
+                current_row.data[j].is_null = field.isNull();
+            }
+
             mutator->UpdateRow(columns_info, &current_row);
+        }
     }
 
     return hasCurrentRow();
 }
 
+std::size_t ResultSet::advanceToNextRows(std::size_t max_rows) {
+    if (max_rows == 0)
+        return 0;
+
+    if (mutator)
+        return (advanceToNextRow() ? 1 : 0);
+
+    if (isRowLimitReached() || endOfSet()) {
+        has_current_row = false;
+        return 0;
+    }
+
+    auto num_rows = std::min(max_rows, batch.getNumRows() - next_batch_row);
+    if (row_limit > 0)
+        num_rows = std::min(num_rows, row_limit - current_row_num);
+
+    first_batch_row = next_batch_row;
+    next_batch_row += num_rows;
+    current_batch_row = next_batch_row - 1;
+    has_current_row = true;
+    current_row_num += num_rows;
+
+    return num_rows;
+}
+
+Field ResultSet::getField(std::size_t row_idx, std::size_t column_idx) const {
+    // With a mutator, only the current row is materialized, and it is the only one advanced over.
+    if (mutator)
+        return getCurrentField(column_idx);
+
+    return batch.getField(first_batch_row + row_idx, column_idx);
+}
+
+const char * ResultSet::getFixedWidthValues(std::size_t column_idx) const {
+    if (mutator || !has_current_row)
+        return nullptr;
+
+    return batch.getFixedWidthValues(first_batch_row, next_batch_row - first_batch_row, column_idx);
+}
+
 IResultMutatorPtr ResultSet::releaseMutator() {
     return std::move(mutator);
 }
 
+void ResultSet::setReadAheadSize(std::size_t bytes) {
+    read_ahead_size = std::max<std::size_t>(1, bytes);
+}
+
+void ResultSet::setRowLimit(std::size_t max_rows) {
+    row_limit = max_rows;
+}
+
+bool ResultSet::isRowLimitReached() const {
+    return (row_limit > 0 && current_row_num >= row_limit);
+}
+
+void ResultSet::startPrefetching(std::size_t max_queued_bytes) {
+    if (prefetch_queue || finished)
+        return;
+
+    prefetch_queue = std::make_unique<BatchQueue>(max_queued_bytes);
+    prefetch_thread = std::thread([this] { prefetch(); });
+}
+
+void ResultSet::stopPrefetching(const std::function<void ()> & abort_reading) {
+    if (!prefetch_thread.joinable())
+        return;
+
+    // Otherwise, the thread would only notice once it has read a whole batch, which may take up to the receive timeout.
+    if (prefetch_queue->close() && abort_reading)
+        abort_reading();
+
+    prefetch_thread.join();
+}
+
+void ResultSet::prefetch() {
+    try {
+        ColumnBatch next_batch;
+
+        while (!finished) {
+            next_batch.clear(columns_info);
+            readBatch(next_batch);
+
+            if (next_batch.getNumRows() > 0 && !prefetch_queue->push(next_batch))
+                return;
+        }
+
+        prefetch_queue->finish();
+    } catch (...) {
+        prefetch_queue->finish(std::current_exception());
+    }
+}
+
 bool ResultSet::endOfSet() {
-    if (ready_raw_rows.empty())
+    if (next_batch_row >= batch.getNumRows())
         prepareSomeRows();
 
-    return ready_raw_rows.empty();
+    return next_batch_row >= batch.getNumRows();
 }
 
-size_t ResultSet::prepareSomeRows(size_t max_ready_rows) {
-    while (!finished && ready_raw_rows.size() < max_ready_rows) {
-        if (in.peek() == EOF /* || TODO: reached the end of the current rowset */) {
+size_t ResultSet::prepareSomeRows() {
+    const auto num_columns = getNumColumns();
+
+    next_batch_row = 0;
+
+    if (prefetch_queue) {
+        // 'finished' belongs to the prefetching thread now.
+        if (!prefetch_queue->pop(batch))
+            batch.clear(columns_info);
+    } else {
+        batch.clear(columns_info);
+
+        if (num_columns == 0)
             finished = true;
-            break;
+
+        if (!finished)
+            readBatch(batch);
+    }
+
+    for (size_t j = 0; j < num_columns; ++j) {
+        if (columns_info[j].encoding == ValueEncoding::Text) {
+            for (std::size_t row_idx = 0; row_idx < batch.getNumRows(); ++row_idx) {
+                columns_info[j].display_size
+                    = std::max<decltype(columns_info[j].display_size)>(batch.getField(row_idx, j).size(), columns_info[j].display_size);
+            }
         }
+    }
 
-        const auto num_columns = getNumColumns();
-        Row row(num_columns);
+    return batch.getNumRows();
+}
 
-        for (size_t j = 0; j < num_columns; ++j) {
-            readString(in, row.data[j].data, &row.data[j].is_null);
-            columns_info[j].display_size
-                = std::max<decltype(columns_info[j].display_size)>(row.data[j].data.size(), columns_info[j].display_size);
+void ResultSet::readBatch(ColumnBatch & batch) {
+    std::size_t max_rows = first_batch_rows;
+    if (avg_row_size > 0)
+        max_rows = std::min(max_batch_rows, std::max<std::size_t>(1, read_ahead_size / avg_row_size));
+
+    // Row-wise formats stop reading exactly at the limit, block-wise ones at the end of the block that reaches it.
+    if (row_limit > 0)
+        max_rows = std::min(max_rows, row_limit - rows_read);
+
+    readRows(batch, max_rows, read_ahead_size);
+
+    const auto num_rows = batch.getNumRows();
+    const auto batch_size = batch.getByteSize();
+
+    rows_read += num_rows;
+    if (row_limit > 0 && rows_read >= row_limit)
+        finished = true;
+
+    if (num_rows == 0)
+        return;
+
+    const auto row_size = std::max<std::size_t>(1, batch_size / num_rows);
+    avg_row_size = (avg_row_size ? (avg_row_size + row_size) / 2 : row_size);
+
+    if (batch_size > max_batch_size) {
+        max_batch_size = batch_size;
+        max_batch_size_rows = num_rows;
+    }
+}
+
+void RowWiseResultSet::readRows(ColumnBatch & batch, std::size_t max_rows, std::size_t max_bytes) {
+    while (batch.getNumRows() < max_rows && batch.getByteSize() < max_bytes) {
+        if (in.eof() /* || TODO: reached the end of the current rowset */) {
+            finished = true;
+            break;
         }
 
-        ready_raw_rows.emplace_back(std::move(row));
+        readRow(batch);
+        batch.finishRow();
+    }
+}
+
+void ColumnBatch::clear(const std::vector<ColumnInfo> & columns_info) {
+    columns.resize(columns_info.size());
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        resetColumn(i, columns_info[i].encoding);
+    }
+    num_rows = 0;
+    byte_size = 0;
+}
+
+void ColumnBatch::resetColumn(std::size_t column_idx, ValueEncoding encoding) {
+    auto & column = columns[column_idx];
+    byte_size -= column.arena.size() + (column.value_size ? 0 : column.num_values * sizeof(std::size_t));
+    column.encoding = encoding;
+    column.value_size = getValueSize(encoding);
+    column.num_values = 0;
+    column.arena.clear();
+    column.offsets.assign(1, 0);
+    column.null_bitmap.clear();
+}
+
+const char * ColumnBatch::getFixedWidthValues(std::size_t first_row, std::size_t count, std::size_t column_idx) const {
+    const auto & column = columns[column_idx];
+    if (!column.value_size || count == 0)
+        return nullptr;
+
+    // The null bitmap is checked a word at a time.
+    const auto end_row = first_row + count;
+    for (auto row = first_row; row < end_row;) {
+        const auto bit = row % 64;
+        const auto num_bits = std::min<std::size_t>(64 - bit, end_row - row);
+        const auto mask = (num_bits == 64 ? ~uint64_t(0) : ((uint64_t(1) << num_bits) - 1) << bit);
+
+        if (column.null_bitmap[row / 64] & mask)
+            return nullptr;
+
+        row += num_bits;
     }
 
-    return ready_raw_rows.size();
+    return column.arena.data() + first_row * column.value_size;
+}
+
+BatchQueue::BatchQueue(std::size_t max_bytes_)
+    : max_bytes(max_bytes_)
+{
+}
+
+bool BatchQueue::push(ColumnBatch & batch) {
+    const auto batch_bytes = batch.getByteSize();
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // A batch larger than the limit is still queued, when nothing else is.
+    waiting_for_room = true;
+    cv.wait(lock, [&] { return closed || batches.empty() || bytes + batch_bytes <= max_bytes; });
+    waiting_for_room = false;
+
+    if (closed)
+        return false;
+
+    batches.emplace_back(std::move(batch));
+    bytes += batch_bytes;
+
+    if (free_batches.empty()) {
+        batch = ColumnBatch{};
+    } else {
+        batch = std::move(free_batches.back());
+        free_batches.pop_back();
+    }
+
+    cv.notify_all();
+    return true;
+}
+
+void BatchQueue::finish(std::exception_ptr exception_) {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    exception = exception_;
+    cv.notify_all();
+}
+
+bool BatchQueue::pop(ColumnBatch & batch) {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    cv.wait(lock, [&] { return finished || closed || !batches.empty(); });
+
+    if (batches.empty()) {
+        // The producer may have failed because it has been stopped.
+        if (finished && exception && !closed)
+            std::rethrow_exception(exception);
+        return false;
+    }
+
+    free_batches.emplace_back(std::move(batch));
+    batch = std::move(batches.front());
+    batches.pop_front();
+    bytes -= batch.getByteSize();
+
+    cv.notify_all();
+    return true;
+}
+
+bool BatchQueue::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    cv.notify_all();
+    return (!finished && !waiting_for_room);
 }
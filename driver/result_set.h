@@ -1,38 +1,142 @@
 #pragma once
 
+#include <condition_variable>
 #include <deque>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
+
+#include <cstdint>
+#include <cstring>
+
 #include "platform.h"
+#include "date_time_parser.h"
+#include "number_parser.h"
 #include "read_helpers.h"
 #include "type_parser.h"
 
 class Statement;
 
+/// How values of a column are stored in a batch: as text (ODBCDriver2, and complex types of binary formats),
+/// or as little-endian binary values that are interpreted directly, without parsing.
+enum class ValueEncoding : uint8_t {
+    Text,
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    UInt8,
+    UInt16,
+    UInt32,
+    UInt64,
+    Float32,
+    Float64,
+    Date,     // UInt16, days since the epoch
+    DateTime, // Int64, seconds since the epoch of the wall clock of the time zone of the column
+};
+
+/// Whether values of the encoding are stored exactly as the C type 'c_type' lays them out in memory, so that they can be just copied.
+bool isBinaryOfCType(ValueEncoding encoding, SQLSMALLINT c_type);
+
+/// A view of a single value of the current row. Valid until the cursor is advanced.
 class Field {
 public:
-    std::string data;
-    bool is_null = false;
+    using value_type = char;
+
+    Field() = default;
+    Field(const char * data_, std::size_t size_, bool is_null_, ValueEncoding encoding_ = ValueEncoding::Text)
+        : data_ptr(data_)
+        , data_size(size_)
+        , is_null(is_null_)
+        , encoding(encoding_)
+    {
+    }
+
+    const char * data() const {
+        return data_ptr;
+    }
+
+    /// Values are always stored followed by a '\0'.
+    const char * c_str() const {
+        return data_ptr;
+    }
+
+    std::size_t size() const {
+        return data_size;
+    }
+
+    bool isNull() const {
+        return is_null;
+    }
+
+    /// Whether data() is the text representation of the value. Otherwise, use toString() to get one.
+    bool isText() const {
+        return encoding == ValueEncoding::Text;
+    }
+
+    ValueEncoding getEncoding() const {
+        return encoding;
+    }
+
+    std::string toString() const;
 
+    /// Whether data() holds the value exactly as the C type 'c_type' lays it out in memory, so that it can be just copied.
+    bool isBinaryOfCType(SQLSMALLINT c_type) const;
+
+    /// Non-throwing versions of the numeric getters, for T = uint64_t, int64_t, float, double.
+    /// Text that is a number with a fraction is truncated when an integer is requested.
+    template <typename T>
+    ParseStatus tryGetNumber(T & res) const;
+
+    /// These throw SqlException with SQLSTATE 22018 if the value is not a number, or 22003 if it is out of range.
     uint64_t getUInt() const;
     int64_t getInt() const;
     float getFloat() const;
     double getDouble() const;
 
+    /// Non-throwing versions of getDate() and getDateTime().
+    ParseStatus tryGetDate(SQL_DATE_STRUCT & res) const;
+    ParseStatus tryGetDateTime(SQL_TIMESTAMP_STRUCT & res) const;
+
+    /// These throw SqlException with SQLSTATE 22018 if the value is not a date, or 22008 if it is not a valid one.
     SQL_DATE_STRUCT getDate() const;
     SQL_TIMESTAMP_STRUCT getDateTime() const;
 
+    /// The value as it is stored, for fixed-width encodings only.
+    template <typename T>
+    T getBinary() const {
+        T res;
+        std::memcpy(&res, data_ptr, sizeof(res));
+        return res;
+    }
+
 private:
     template <typename T>
-    void normalizeDate(T & date) const;
+    T getNumber(const char * type_name) const;
+
+private:
+    const char * data_ptr = "";
+    std::size_t data_size = 0;
+    bool is_null = false;
+    ValueEncoding encoding = ValueEncoding::Text;
 };
 
+/// A row materialized out of a batch, so that it can be modified by a result mutator.
 class Row {
 public:
+    struct Value {
+        std::string data;
+        bool is_null = false;
+    };
+
     Row() {}
     Row(size_t num_columns) : data(num_columns) {}
 
-    std::vector<Field> data;
+    std::vector<Value> data;
 
     bool isValid() const {
         return !data.empty();
@@ -46,6 +150,138 @@ struct ColumnInfo {
     size_t display_size = 0;
     size_t fixed_size = 0;
     bool is_nullable = false;
+    ValueEncoding encoding = ValueEncoding::Text;
+};
+
+/// A batch of rows stored column-wise: each column keeps all its values back to back in a single byte arena,
+/// and nulls are tracked in a bitmap. Text values are followed by a '\0' each and indexed by an offsets array,
+/// fixed-width binary values are stored contiguously, exactly as they are laid out in memory by the server.
+/// Clearing a batch keeps the allocated memory, so refilling it usually allocates nothing.
+class ColumnBatch {
+public:
+    void clear(const std::vector<ColumnInfo> & columns_info);
+
+    /// Drop the values of a column and (re)set its encoding.
+    void resetColumn(std::size_t column_idx, ValueEncoding encoding);
+
+    std::size_t getNumRows() const {
+        return num_rows;
+    }
+
+    void appendValue(std::size_t column_idx, const char * data, std::size_t size, bool is_null) {
+        auto & column = columns[column_idx];
+        const auto row_idx = column.num_values++;
+
+        if (column.value_size) {
+            if (is_null)
+                column.arena.resize(column.arena.size() + column.value_size, '\0');
+            else
+                column.arena.insert(column.arena.end(), data, data + column.value_size);
+            byte_size += column.value_size;
+        } else {
+            column.arena.insert(column.arena.end(), data, data + size);
+            column.arena.push_back('\0');
+            column.offsets.push_back(column.arena.size());
+            byte_size += size + 1 + sizeof(std::size_t);
+        }
+
+        if (row_idx / 64 >= column.null_bitmap.size())
+            column.null_bitmap.push_back(0);
+        if (is_null)
+            column.null_bitmap[row_idx / 64] |= (uint64_t(1) << (row_idx % 64));
+    }
+
+    /// Append 'count' non-null values of a column with a fixed-width binary encoding at once.
+    void appendFixedWidthValues(std::size_t column_idx, const char * data, std::size_t count) {
+        auto & column = columns[column_idx];
+        column.arena.insert(column.arena.end(), data, data + count * column.value_size);
+        column.num_values += count;
+        byte_size += count * column.value_size;
+        column.null_bitmap.resize((column.num_values + 63) / 64, 0);
+    }
+
+    void setNull(std::size_t column_idx, std::size_t row_idx) {
+        columns[column_idx].null_bitmap[row_idx / 64] |= (uint64_t(1) << (row_idx % 64));
+    }
+
+    /// Must be called after a value has been appended to every column.
+    void finishRow() {
+        ++num_rows;
+    }
+
+    /// Must be called after 'count' values have been appended to every column.
+    void finishRows(std::size_t count) {
+        num_rows += count;
+    }
+
+    /// Approximate size of the memory used by the values.
+    std::size_t getByteSize() const {
+        return byte_size;
+    }
+
+    /// The values of 'count' rows of a column, starting with 'first_row', back to back, if the column has a fixed-width
+    /// encoding and none of them is NULL, otherwise null. Valid until the batch is modified.
+    const char * getFixedWidthValues(std::size_t first_row, std::size_t count, std::size_t column_idx) const;
+
+    Field getField(std::size_t row_idx, std::size_t column_idx) const {
+        const auto & column = columns[column_idx];
+        const bool is_null = (column.null_bitmap[row_idx / 64] >> (row_idx % 64)) & 1;
+
+        if (column.value_size)
+            return Field{column.arena.data() + row_idx * column.value_size, column.value_size, is_null, column.encoding};
+
+        const auto begin = column.offsets[row_idx];
+        const auto end = column.offsets[row_idx + 1];
+        return Field{column.arena.data() + begin, end - begin - 1, is_null, column.encoding};
+    }
+
+private:
+    struct Column {
+        ValueEncoding encoding = ValueEncoding::Text;
+        std::size_t value_size = 0; // For fixed-width encodings, otherwise 0.
+        std::size_t num_values = 0;
+        std::vector<char> arena;
+        std::vector<std::size_t> offsets;
+        std::vector<uint64_t> null_bitmap;
+    };
+
+    std::vector<Column> columns;
+    std::size_t num_rows = 0;
+    std::size_t byte_size = 0;
+};
+
+/// A queue of batches passed from a producer thread to a consumer thread, limited by the total size of the queued batches.
+/// Batches are swapped in and out, and the ones returned by the consumer are handed back to the producer for reuse.
+class BatchQueue {
+public:
+    explicit BatchQueue(std::size_t max_bytes_);
+
+    /// Called by the producer. Blocks while the queue is full. Returns false if the consumer has closed the queue.
+    /// On success, 'batch' is replaced by a drained one.
+    bool push(ColumnBatch & batch);
+
+    /// Called by the producer when there will be no more batches, possibly because of an exception.
+    void finish(std::exception_ptr exception = nullptr);
+
+    /// Called by the consumer. Blocks while the queue is empty. Returns false once the producer has finished, or the queue
+    /// has been closed, and all the batches have been taken, or rethrows the exception of the producer. On success, 'batch' is replaced by the next one.
+    bool pop(ColumnBatch & batch);
+
+    /// Called by the consumer to make the producer stop. Returns false if the producer is done, or is waiting for room
+    /// in the queue, and so will stop right away. Otherwise, it may be busy producing the next batch.
+    bool close();
+
+private:
+    const std::size_t max_bytes;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<ColumnBatch> batches;
+    std::vector<ColumnBatch> free_batches;
+    std::size_t bytes = 0;
+    bool finished = false;
+    bool closed = false;
+    bool waiting_for_room = false;
+    std::exception_ptr exception;
 };
 
 class IResultMutator {
@@ -59,32 +295,179 @@ public:
 
 using IResultMutatorPtr = std::unique_ptr<IResultMutator>;
 
+/// Common part of result sets of all the supported formats: the columns info and a cursor over batches of rows.
 class ResultSet {
 public:
-    explicit ResultSet(std::istream & in_, IResultMutatorPtr && mutator_);
+    static constexpr std::size_t default_read_ahead_size = 1 << 20;
+
+    virtual ~ResultSet();
 
     const ColumnInfo & getColumnInfo(size_t i) const;
     size_t getNumColumns() const;
 
     bool hasCurrentRow() const;
-    const Row & getCurrentRow() const;
+    Field getCurrentField(std::size_t column_idx) const;
     std::size_t getCurrentRowNum() const;
+
+    /// The encoding of the fields of the column returned by getCurrentField(), the same for all rows.
+    ValueEncoding getFieldEncoding(std::size_t column_idx) const;
     bool advanceToNextRow();
 
+    /// Advance by up to 'max_rows' rows at once, but not past the end of the batch in memory, so that the rows can be
+    /// processed column by column with getField(). The last of them becomes the current row. Returns the number of rows,
+    /// 0 at the end of the result set. Rows modified by a mutator are advanced over one by one.
+    std::size_t advanceToNextRows(std::size_t max_rows);
+
+    /// A field of the rows advanced over by the last call to advanceToNextRows(), 'row_idx' counting from the first of them.
+    Field getField(std::size_t row_idx, std::size_t column_idx) const;
+
+    /// The values of a column of all the rows advanced over by the last call to advanceToNextRows(), back to back,
+    /// if the column has a fixed-width binary encoding and none of them is NULL, otherwise null. See ColumnBatch::getFixedWidthValues().
+    const char * getFixedWidthValues(std::size_t column_idx) const;
+
     IResultMutatorPtr releaseMutator();
 
+    /// Limit the size of the batches read from the stream at once, in bytes.
+    /// Must be called before prefetching is started.
+    void setReadAheadSize(std::size_t bytes);
+
+    /// Stop after 'max_rows' rows, 0 for no limit: no more rows are read from the stream, nor returned, once that many have been.
+    /// Must be called before prefetching is started.
+    void setRowLimit(std::size_t max_rows);
+
+    /// Whether the rows up to the limit have all been advanced over, so that the rest of the stream will never be read.
+    bool isRowLimitReached() const;
+
+    /// Read and decode the following batches in a background thread, keeping up to 'max_queued_bytes' of them ready,
+    /// so that reading from the network overlaps with the processing of the rows by the application.
+    void startPrefetching(std::size_t max_queued_bytes);
+
+    /// Stop the background thread, if any. Waits for the batch it is reading at the moment, unless 'abort_reading' is given:
+    /// then, if the thread may be waiting for the stream, 'abort_reading' is called first, and must make the stream fail.
+    /// After that, only the rows that have already been prefetched can be read. Descendants must call this in their destructors,
+    /// since the background thread reads through their readRows().
+    void stopPrefetching(const std::function<void ()> & abort_reading = std::function<void ()>{});
+
+protected:
+    ResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size);
+
+    /// Must be called at the end of the constructor of a descendant, once the header has been read into columns_info.
+    void finishHeader();
+
+    /// Read some rows from the stream and append their values to the batch, stopping after 'max_rows' rows,
+    /// or once the batch has grown to 'max_bytes'. Must set 'finished' once the stream has ended.
+    virtual void readRows(ColumnBatch & batch, std::size_t max_rows, std::size_t max_bytes) = 0;
+
 private:
+    /// The first batch is small, to make the first rows available soon. The following ones are sized after the rows seen so far.
+    static constexpr std::size_t first_batch_rows = 100;
+    static constexpr std::size_t max_batch_rows = 1 << 16;
+
     bool endOfSet();
-    size_t prepareSomeRows(size_t max_ready_rows = 100);
+    size_t prepareSomeRows();
+    void readBatch(ColumnBatch & batch);
+    void prefetch();
+
+protected:
+    BufferedReader in;
+    std::vector<ColumnInfo> columns_info;
+    bool finished = false;
 
 private:
-    std::istream & in;
     IResultMutatorPtr mutator;
-    std::vector<ColumnInfo> columns_info;
-    std::deque<Row> ready_raw_rows;
-    Row current_row;
+    ColumnBatch batch;
+    std::size_t next_batch_row = 0;
+    std::size_t current_batch_row = 0;
+    std::size_t first_batch_row = 0; // Of the rows advanced over by advanceToNextRows().
+    bool has_current_row = false;
+    Row current_row; // Materialized only when there is a mutator.
     std::size_t current_row_num = 0;
-    bool finished = false;
+    std::size_t row_limit = 0;
+
+    // Read-ahead state belongs to the thread that reads the stream: this one, or the prefetching one.
+    std::size_t read_ahead_size = default_read_ahead_size;
+    std::size_t avg_row_size = 0; // Of the batches read so far, 0 before the first one.
+    std::size_t max_batch_size = 0;
+    std::size_t max_batch_size_rows = 0;
+    std::size_t rows_read = 0;
+
+    std::unique_ptr<BatchQueue> prefetch_queue;
+    std::thread prefetch_thread;
+};
+
+/// Result set of a format that transfers the data row by row.
+class RowWiseResultSet
+    : public ResultSet
+{
+protected:
+    using ResultSet::ResultSet;
+
+    virtual void readRows(ColumnBatch & batch, std::size_t max_rows, std::size_t max_bytes) override;
+
+    /// Read a single row from the stream and append its values to the batch.
+    virtual void readRow(ColumnBatch & batch) = 0;
 };
 
+class ODBCDriver2ResultSet
+    : public RowWiseResultSet
+{
+public:
+    explicit ODBCDriver2ResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size);
+    virtual ~ODBCDriver2ResultSet();
+
+protected:
+    virtual void readRow(ColumnBatch & batch) override;
+};
+
+class ValueDecoder;
+
+class RowBinaryWithNamesAndTypesResultSet
+    : public RowWiseResultSet
+{
+public:
+    explicit RowBinaryWithNamesAndTypesResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size, const std::string & server_time_zone);
+    virtual ~RowBinaryWithNamesAndTypesResultSet();
+
+protected:
+    virtual void readRow(ColumnBatch & batch) override;
+
+private:
+    std::vector<std::unique_ptr<ValueDecoder>> decoders;
+};
+
+/// Native format: the data comes in blocks, and every column of a block is decoded at once,
+/// so that a batch holds exactly one block. The first block defines the columns of the result set.
+/// LowCardinality columns must be sent as ordinary ones (low_cardinality_allow_in_native_format=0).
+class NativeResultSet
+    : public ResultSet
+{
+public:
+    explicit NativeResultSet(std::istream & in_, IResultMutatorPtr && mutator_, std::size_t read_buffer_size, const std::string & server_time_zone_);
+    virtual ~NativeResultSet();
+
+protected:
+    virtual void readRows(ColumnBatch & batch, std::size_t max_rows, std::size_t max_bytes) override;
+
+private:
+    void readBlock(ColumnBatch & batch, bool is_first_block);
+
+private:
+    const std::string server_time_zone;
+    std::vector<std::unique_ptr<ValueDecoder>> decoders;
+    ColumnBatch first_block;
+    bool has_first_block = false;
+};
+
+/// Instantiate a result set reading the data in the specified format, which is expected to be one of the supported ones.
+/// Binary formats show DateTime values without a time zone of their own in 'server_time_zone', or in UTC if it is empty.
+std::unique_ptr<ResultSet> makeResultSet(const std::string & format, std::istream & in, IResultMutatorPtr && mutator, std::size_t read_buffer_size, const std::string & server_time_zone);
+
+/// Whether makeResultSet() is able to read the format.
+bool isSupportedResultFormat(const std::string & format);
+
 void assignTypeInfo(const TypeAst & ast, ColumnInfo * info);
+void assignTypeInfo(const std::string & type, ColumnInfo * info);
+
+/// Conversions of days and seconds since the epoch to calendar dates and times (UTC).
+SQL_DATE_STRUCT dateFromDays(int64_t days);
+SQL_TIMESTAMP_STRUCT dateTimeFromSeconds(int64_t seconds);
@@ -0,0 +1,145 @@
+#include "row_store.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <cstring>
+
+#if defined(_win_)
+#    include <io.h>
+#else
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+namespace {
+
+/// Written instead of the size of a NULL value.
+constexpr std::uint32_t null_size = ~std::uint32_t(0);
+
+} // namespace
+
+SpillFile::SpillFile()
+    : file(std::tmpfile())
+{
+    if (!file)
+        throw std::runtime_error("Unable to create a temporary file for the rows of the cursor.");
+}
+
+SpillFile::~SpillFile() {
+    unmap();
+    std::fclose(file);
+}
+
+void SpillFile::append(const char * src, std::size_t size) {
+    if (used + size > capacity)
+        grow(used + size);
+
+    std::memcpy(mapped + used, src, size);
+    used += size;
+}
+
+void SpillFile::grow(std::size_t min_capacity) {
+    // Doubling keeps the number of remappings logarithmic in the size of the file.
+    const auto new_capacity = std::max<std::size_t>({min_capacity, capacity * 2, 16 << 20});
+
+    unmap();
+
+#if defined(_win_)
+    const auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+    const auto size = static_cast<std::uint64_t>(new_capacity);
+
+    mapping = CreateFileMapping(handle, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    if (!mapping)
+        throw std::runtime_error("Unable to grow the temporary file for the rows of the cursor.");
+
+    mapped = static_cast<char *>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, new_capacity));
+    if (!mapped)
+        throw std::runtime_error("Unable to map the temporary file for the rows of the cursor.");
+#else
+    const auto fd = fileno(file);
+
+    if (ftruncate(fd, static_cast<off_t>(new_capacity)) != 0)
+        throw std::runtime_error("Unable to grow the temporary file for the rows of the cursor.");
+
+    void * res = mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (res == MAP_FAILED)
+        throw std::runtime_error("Unable to map the temporary file for the rows of the cursor.");
+
+    mapped = static_cast<char *>(res);
+#endif
+
+    capacity = new_capacity;
+}
+
+void SpillFile::unmap() {
+#if defined(_win_)
+    if (mapped)
+        UnmapViewOfFile(mapped);
+    if (mapping)
+        CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    if (mapped)
+        munmap(mapped, capacity);
+#endif
+    mapped = nullptr;
+}
+
+RowStore::RowStore(std::vector<ValueEncoding> encodings_, std::size_t memory_limit_)
+    : encodings(std::move(encodings_))
+    , memory_limit(memory_limit_)
+    , row_offsets(1, 0)
+{
+}
+
+void RowStore::appendRow(const ResultSet & result_set, std::size_t row_idx) {
+    row_buffer.clear();
+
+    for (std::size_t column_idx = 0; column_idx < encodings.size(); ++column_idx) {
+        const auto field = result_set.getField(row_idx, column_idx);
+        const auto size = (field.isNull() ? null_size : static_cast<std::uint32_t>(field.size()));
+
+        row_buffer.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        if (!field.isNull())
+            row_buffer.append(field.data(), field.size());
+        row_buffer.push_back('\0');
+    }
+
+    // A row is never split between the memory and the file, and once a row has been spilled, all the following ones are too.
+    if (!spill_file && memory.size() + row_buffer.size() > memory_limit) {
+        spill_file = std::make_unique<SpillFile>();
+        spill_start = memory.size();
+    }
+
+    if (spill_file)
+        spill_file->append(row_buffer.data(), row_buffer.size());
+    else
+        memory.insert(memory.end(), row_buffer.begin(), row_buffer.end());
+
+    row_offsets.push_back(row_offsets.back() + row_buffer.size());
+}
+
+void RowStore::getRow(std::size_t row_idx, std::vector<Field> & fields) const {
+    const auto offset = row_offsets.at(row_idx);
+    const char * pos = (offset < spill_start || !spill_file
+        ? memory.data() + offset
+        : spill_file->data() + (offset - spill_start)
+    );
+
+    fields.resize(encodings.size());
+
+    for (std::size_t column_idx = 0; column_idx < encodings.size(); ++column_idx) {
+        std::uint32_t size = 0;
+        std::memcpy(&size, pos, sizeof(size));
+        pos += sizeof(size);
+
+        if (size == null_size) {
+            fields[column_idx] = Field{pos, 0, true, encodings[column_idx]};
+            pos += 1;
+        } else {
+            fields[column_idx] = Field{pos, size, false, encodings[column_idx]};
+            pos += size + 1;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "result_set.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstdio>
+
+/// A temporary file that is grown as data is appended to it and is accessed through a memory mapping.
+/// The file is deleted when it is closed.
+class SpillFile {
+public:
+    SpillFile();
+    ~SpillFile();
+
+    SpillFile(const SpillFile &) = delete;
+    SpillFile & operator= (const SpillFile &) = delete;
+
+    /// Invalidates the pointers returned by data() if the file has to be grown.
+    void append(const char * src, std::size_t size);
+
+    const char * data() const {
+        return mapped;
+    }
+
+    std::size_t size() const {
+        return used;
+    }
+
+private:
+    void grow(std::size_t min_capacity);
+    void unmap();
+
+private:
+    std::FILE * file = nullptr;
+    char * mapped = nullptr;
+    std::size_t used = 0;
+    std::size_t capacity = 0;
+#if defined(_win_)
+    void * mapping = nullptr;
+#endif
+};
+
+/// Rows of a result set kept for a static cursor, so that it can be scrolled without running the query again.
+/// Each row is serialized back to back with the others: for every column, the size of the value (or ~0 for NULL),
+/// followed by the value as it is stored in batches, and a '\0'. Rows are kept in memory until they take
+/// 'memory_limit' bytes, the following ones are spilled to a memory-mapped temporary file.
+class RowStore {
+public:
+    RowStore(std::vector<ValueEncoding> encodings_, std::size_t memory_limit_);
+
+    std::size_t getNumRows() const {
+        return row_offsets.size() - 1;
+    }
+
+    std::size_t getNumColumns() const {
+        return encodings.size();
+    }
+
+    /// Bytes taken by the rows, in memory and in the file.
+    std::size_t getByteSize() const {
+        return row_offsets.back();
+    }
+
+    bool isSpilled() const {
+        return static_cast<bool>(spill_file);
+    }
+
+    /// Append one of the rows advanced over by the last ResultSet::advanceToNextRows(), 'row_idx' counting from the first of them.
+    void appendRow(const ResultSet & result_set, std::size_t row_idx);
+
+    /// Fields of a row, views valid until the next append.
+    void getRow(std::size_t row_idx, std::vector<Field> & fields) const;
+
+private:
+    const std::vector<ValueEncoding> encodings;
+    const std::size_t memory_limit;
+
+    std::vector<char> memory;
+    std::unique_ptr<SpillFile> spill_file;
+    std::size_t spill_start = 0; // The offset the rows in the file start at, i.e., the size of the rows in memory.
+
+    std::vector<std::uint64_t> row_offsets; // One more than rows: the last one is where the next row starts.
+    std::string row_buffer;
+};
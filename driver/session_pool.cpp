@@ -0,0 +1,107 @@
+#include "session_pool.h"
+
+#include <Poco/Net/StreamSocket.h>
+
+constexpr std::size_t SessionPool::default_max_idle_sessions;
+constexpr std::chrono::milliseconds SessionPool::default_idle_timeout;
+
+SessionPool::SessionPool(std::size_t max_idle_sessions_, std::chrono::milliseconds idle_timeout_, HealthCheck is_healthy_)
+    : max_idle_sessions(max_idle_sessions_)
+    , idle_timeout(idle_timeout_)
+    , is_healthy(std::move(is_healthy_))
+{
+}
+
+SessionPool & SessionPool::getInstance() {
+    static SessionPool pool;
+    return pool;
+}
+
+SessionPool::SessionPtr SessionPool::acquire(const std::string & key) {
+    // Sessions are closed, and checked, without holding the lock, since that involves system calls.
+    std::deque<SessionPtr> expired;
+
+    while (true) {
+        SessionPtr session;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            removeExpired(Clock::now(), expired);
+
+            auto it = idle_sessions.find(key);
+            if (it == idle_sessions.end())
+                return SessionPtr{};
+
+            session = std::move(it->second.back().session);
+            it->second.pop_back();
+            if (it->second.empty())
+                idle_sessions.erase(it);
+        }
+
+        if (is_healthy(*session))
+            return session;
+    }
+}
+
+void SessionPool::release(const std::string & key, SessionPtr && session) {
+    if (!session || max_idle_sessions == 0 || !is_healthy(*session))
+        return;
+
+    std::deque<SessionPtr> expired;
+    const auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    removeExpired(now, expired);
+
+    auto & sessions = idle_sessions[key];
+    if (sessions.size() >= max_idle_sessions) {
+        expired.push_back(std::move(sessions.front().session));
+        sessions.pop_front();
+    }
+
+    sessions.push_back(IdleSession{std::move(session), now});
+}
+
+std::size_t SessionPool::getNumIdleSessions() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::size_t num_sessions = 0;
+    for (const auto & sessions : idle_sessions)
+        num_sessions += sessions.second.size();
+
+    return num_sessions;
+}
+
+void SessionPool::clear() {
+    decltype(idle_sessions) sessions;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sessions.swap(idle_sessions);
+    }
+}
+
+bool SessionPool::isSessionHealthy(Poco::Net::HTTPClientSession & session) {
+    try {
+        // An idle socket becomes readable when the server closes the connection.
+        return session.connected() && !session.socket().poll(Poco::Timespan(0), Poco::Net::StreamSocket::SELECT_READ);
+    } catch (...) {
+        return false;
+    }
+}
+
+void SessionPool::removeExpired(Clock::time_point now, std::deque<SessionPtr> & expired) {
+    for (auto it = idle_sessions.begin(); it != idle_sessions.end();) {
+        auto & sessions = it->second;
+
+        while (!sessions.empty() && now - sessions.front().released_at >= idle_timeout) {
+            expired.push_back(std::move(sessions.front().session));
+            sessions.pop_front();
+        }
+
+        if (sessions.empty())
+            it = idle_sessions.erase(it);
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <Poco/Net/HTTPClientSession.h>
+
+/// Process-wide pool of idle HTTP(S) sessions, so that connections opened and closed in quick succession reuse
+/// the sockets, and TLS sessions, of the previous ones instead of connecting to the server again.
+/// Sessions are pooled under a key that identifies the server and the settings of the transport, see Connection::getSessionPoolKey().
+class SessionPool {
+public:
+    using SessionPtr = std::unique_ptr<Poco::Net::HTTPClientSession>;
+    using HealthCheck = std::function<bool (Poco::Net::HTTPClientSession &)>;
+
+    /// Idle sessions kept per key, the oldest ones are closed first.
+    static constexpr std::size_t default_max_idle_sessions = 16;
+
+    /// Below the keep-alive timeout of the server (3 seconds by default in older ClickHouse versions, 10 in newer ones),
+    /// so that sessions are not handed out just as the server is closing them.
+    static constexpr std::chrono::milliseconds default_idle_timeout{2500};
+
+    explicit SessionPool(
+        std::size_t max_idle_sessions_ = default_max_idle_sessions,
+        std::chrono::milliseconds idle_timeout_ = default_idle_timeout,
+        HealthCheck is_healthy_ = isSessionHealthy
+    );
+
+    SessionPool(const SessionPool &) = delete;
+    SessionPool & operator= (const SessionPool &) = delete;
+
+    static SessionPool & getInstance();
+
+    /// Take the most recently released healthy session of the key out of the pool, or return null if there is none.
+    SessionPtr acquire(const std::string & key);
+
+    /// Put a session back to the pool, unless it is not connected anymore. The session must not be in the middle of a request.
+    void release(const std::string & key, SessionPtr && session);
+
+    std::size_t getNumIdleSessions() const;
+
+    /// Close all the idle sessions.
+    void clear();
+
+    /// Whether the session is still connected, and the server has neither closed the connection nor sent anything unrequested.
+    static bool isSessionHealthy(Poco::Net::HTTPClientSession & session);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleSession {
+        SessionPtr session;
+        Clock::time_point released_at;
+    };
+
+    /// Move the sessions that have been idle for too long out to 'expired', to be closed after unlocking.
+    void removeExpired(Clock::time_point now, std::deque<SessionPtr> & expired);
+
+private:
+    const std::size_t max_idle_sessions;
+    const std::chrono::milliseconds idle_timeout;
+    const HealthCheck is_healthy;
+
+    mutable std::mutex mutex;
+    std::map<std::string, std::deque<IdleSession>> idle_sessions; // Oldest first.
+};
@@ -1,8 +1,11 @@
 #include "platform.h"
 #include "utils.h"
 #include "statement.h"
+#include "async_executor.h"
+#include "read_helpers.h"
 #include "escaping/lexer.h"
 #include "escaping/escape_sequences.h"
+#include "escaping/batched_insert.h"
 
 #include <Poco/Exception.h>
 #include <Poco/Net/HTTPClientSession.h>
@@ -11,10 +14,36 @@
 #include <Poco/UUID.h>
 #include <Poco/UUIDGenerator.h>
 
+#include <algorithm>
+#include <limits>
+
+#include <cctype>
 #include <cstdio>
 
 namespace {
 
+    /// A rest of a response body larger than this, or arriving slower, is not worth keeping the connection alive for.
+    constexpr std::size_t max_drain_size = 1 << 20;
+    constexpr std::chrono::milliseconds max_drain_wait{100};
+
+    /// Reads of a statement with SQL_ATTR_QUERY_TIMEOUT time out this much later than the query on the server,
+    /// so that the error of the server, which tells what happened, arrives first.
+    constexpr SQLULEN query_timeout_slack = 1; // seconds
+
+    /// As a field of the TabSeparated format.
+    void appendEscapedForTabSeparated(const std::string & value, std::string & out) {
+        for (const auto ch : value) {
+            switch (ch) {
+                case '\\': out += "\\\\"; break;
+                case '\t': out += "\\t"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\0': out += "\\0"; break;
+                default: out += ch; break;
+            }
+        }
+    }
+
     template <typename T>
     struct to {
         template <typename F>
@@ -81,14 +110,14 @@ namespace {
         }
 
         if (!sz_ptr || *sz_ptr < 0)
-            std::string{cstr};
+            return std::string{cstr};
 
         return std::string{cstr, static_cast<std::size_t>(*sz_ptr)};
     }
 
     template <>
     std::string to<std::string>::from<SQLWCHAR *>(const BindingInfo& binding_info) {
-        const auto * wcstr = reinterpret_cast<const wchar_t *>(binding_info.value);
+        const auto * wcstr = reinterpret_cast<const SQLWCHAR *>(binding_info.value);
 
         if (!wcstr)
             return std::string{};
@@ -96,13 +125,21 @@ namespace {
         const auto * sz_ptr = binding_info.value_size;
         const auto * ind_ptr = binding_info.indicator;
 
-        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> convert;
+        const auto convert_nts = [wcstr] () {
+            std::size_t length = 0;
+            while (wcstr[length])
+                ++length;
+
+            std::string res;
+            transcodeWideToUTF8(wcstr, length, res);
+            return res;
+        };
 
         if (ind_ptr) {
             switch (*ind_ptr) {
                 case 0:
                 case SQL_NTS:
-                    return convert.to_bytes(wcstr);
+                    return convert_nts();
 
                 case SQL_NULL_DATA:
                 case SQL_DEFAULT_PARAM:
@@ -115,10 +152,11 @@ namespace {
         }
 
         if (!sz_ptr || *sz_ptr < 0)
-            convert.to_bytes(wcstr);
+            return convert_nts();
 
-        const auto* wcstr_last = wcstr + static_cast<std::size_t>(*sz_ptr) / sizeof(decltype(*wcstr));
-        return convert.to_bytes(wcstr, wcstr_last);
+        std::string res;
+        transcodeWideToUTF8(wcstr, static_cast<std::size_t>(*sz_ptr) / sizeof(SQLWCHAR), res);
+        return res;
     }
 
     template <>
@@ -324,6 +362,18 @@ Statement::Statement(Connection & connection)
 }
 
 Statement::~Statement() {
+    // The worker thread of a pending operation still uses the statement.
+    waitForAsyncOperation();
+
+    // A statement freed with its cursor open finishes the response, and returns its session, like SQLCloseCursor() does.
+    try {
+        closeResultSet();
+    } catch (const std::exception & e) {
+        LOG("Closing the result set of a freed statement failed: " << e.what());
+    } catch (...) {
+        LOG("Closing the result set of a freed statement failed");
+    }
+
     deallocateImplicitDescriptors();
 }
 
@@ -348,7 +398,7 @@ void Statement::executeQuery(IResultMutatorPtr && mutator) {
 }
 
 void Statement::requestNextPackOfResultSets(IResultMutatorPtr && mutator) {
-    result_set.reset();
+    closeResultSet();
 
     if (query.empty())
         return;
@@ -361,35 +411,81 @@ void Statement::requestNextPackOfResultSets(IResultMutatorPtr && mutator) {
 
     auto & connection = getParent();
 
-    if (connection.session && response && in)
-        if (!*in || in->peek() != EOF)
-            connection.session->reset();
+    const auto new_query_id = Poco::UUIDGenerator::defaultGenerator().createRandom().toString();
 
     Poco::URI uri(connection.url);
+    uri.addQueryParameter("query_id", new_query_id);
     uri.addQueryParameter("database", connection.getDatabase());
-    uri.addQueryParameter("default_format", "ODBCDriver2");
+    uri.addQueryParameter("default_format", connection.format);
+    if (connection.format == "Native")
+        uri.addQueryParameter("low_cardinality_allow_in_native_format", "0");
+
+    const auto accept_encoding = getAcceptEncoding(connection.compression);
+    if (!accept_encoding.empty())
+        uri.addQueryParameter("enable_http_compression", "1");
+
+    // The server stops producing rows at the end of the block that reaches the limit, the rest are cut off by the result set.
+    const auto max_rows = getAttrAs<SQLULEN>(SQL_ATTR_MAX_ROWS, 0);
+    if (max_rows > 0) {
+        uri.addQueryParameter("max_result_rows", std::to_string(max_rows));
+        uri.addQueryParameter("result_overflow_mode", "break");
+    }
 
-    const auto param_bindings = getParamsBindingInfo(next_param_set);
+    // The server stops the query, and the reads of the response time out a little later, should the server be unresponsive.
+    const auto query_timeout = std::min<SQLULEN>(getAttrAs<SQLULEN>(SQL_ATTR_QUERY_TIMEOUT, 0), std::numeric_limits<int>::max() - query_timeout_slack);
+    if (query_timeout > 0)
+        uri.addQueryParameter("max_execution_time", std::to_string(query_timeout));
 
-    if (param_bindings.size() < parameters.size())
-        throw SqlException("COUNT field incorrect", "07002");
+    const int read_query_timeout = (query_timeout > 0 ? static_cast<int>(query_timeout + query_timeout_slack) : 0);
 
-    for (std::size_t i = 0; i < parameters.size(); ++i) {
-        const auto param_name = getParamFinalName(i);
-        const auto & binding_info = param_bindings[i];
+    // An INSERT of an array of parameter sets is sent at once, with the sets as the rows of its data, instead of a request per set.
+    std::vector<std::string> placeholders;
+    for (const auto & param_info : parameters)
+        placeholders.push_back(param_info.tmp_placeholder);
+
+    std::string insert_head;
+    const bool batch_insert = (next_param_set == 0 && param_set_array_size > 1 && splitBatchableInsert(query, placeholders, insert_head));
+    std::size_t batch_row_count = 0;
+    std::string prepared_query;
+
+    auto * param_set_processed_ptr = getEffectiveDescriptor(SQL_ATTR_IMP_PARAM_DESC).getAttrAs<SQLULEN *>(SQL_DESC_ROWS_PROCESSED_PTR, 0);
+
+    if (batch_insert) {
+        // Until the server has inserted them, which it does all at once, or none.
+        setParamSetStatuses(param_set_array_size, SQL_PARAM_ERROR);
+        if (param_set_processed_ptr)
+            *param_set_processed_ptr = param_set_array_size;
 
-        if (!isInputParam(binding_info.io_type) || isStreamParam(binding_info.io_type))
-            throw std::runtime_error("Unable to extract data from bound param buffer: param IO type is not supported");
+        prepared_query = buildBatchInsert(insert_head, param_set_array_size, batch_row_count);
 
-        uri.addQueryParameter("param_" + param_name, readReadyDataTo<std::string>(binding_info));
+        // The server inserts the data in blocks, each of them at once, so the rows are made a single block, however many there are.
+        const auto block_size = std::to_string(std::max<std::size_t>(batch_row_count, 1));
+        uri.addQueryParameter("max_insert_block_size", block_size);
+        uri.addQueryParameter("min_insert_block_size_rows", block_size);
+        uri.addQueryParameter("min_insert_block_size_bytes", "0");
     }
+    else {
+        const auto param_bindings = getParamsBindingInfo(next_param_set);
 
-    const auto prepared_query = buildFinalQuery(param_bindings);
+        if (param_bindings.size() < parameters.size())
+            throw SqlException("COUNT field incorrect", "07002");
 
-    // TODO: set this only after this single query is fully fetched (when output parameter support is added)
-    auto * param_set_processed_ptr = getEffectiveDescriptor(SQL_ATTR_IMP_PARAM_DESC).getAttrAs<SQLULEN *>(SQL_DESC_ROWS_PROCESSED_PTR, 0);
-    if (param_set_processed_ptr)
-        *param_set_processed_ptr = next_param_set;
+        for (std::size_t i = 0; i < parameters.size(); ++i) {
+            const auto param_name = getParamFinalName(i);
+            const auto & binding_info = param_bindings[i];
+
+            if (!isInputParam(binding_info.io_type) || isStreamParam(binding_info.io_type))
+                throw std::runtime_error("Unable to extract data from bound param buffer: param IO type is not supported");
+
+            uri.addQueryParameter("param_" + param_name, readReadyDataTo<std::string>(binding_info));
+        }
+
+        prepared_query = buildFinalQuery(param_bindings);
+
+        // TODO: set this only after this single query is fully fetched (when output parameter support is added)
+        if (param_set_processed_ptr)
+            *param_set_processed_ptr = next_param_set;
+    }
 
     Poco::Net::HTTPRequest request;
     request.setMethod(Poco::Net::HTTPRequest::HTTP_POST);
@@ -399,38 +495,107 @@ void Statement::requestNextPackOfResultSets(IResultMutatorPtr && mutator) {
     request.setCredentials("Basic", connection.buildCredentialsString());
     request.setURI(uri.toString());
     request.set("User-Agent", connection.buildUserAgentString());
+    if (!accept_encoding.empty())
+        request.set("Accept-Encoding", accept_encoding);
+
+    // Large bodies, like INSERTs with their data, are compressed with the same codec as the responses.
+    std::string compressed_query;
+    const bool compress_request = (!accept_encoding.empty() && prepared_query.size() >= static_cast<std::size_t>(connection.compression_threshold));
+    if (compress_request) {
+        compressed_query = compressBody(prepared_query, accept_encoding);
+        request.set("Content-Encoding", accept_encoding);
+    }
 
-    LOG(request.getMethod() << " " << connection.session->getHost() << request.getURI() << " body=" << prepared_query
-                            << " UA=" << request.get("User-Agent"));
+    {
+        auto acquired_session = connection.acquireSession(read_query_timeout);
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        session = std::move(acquired_session);
+        query_id = new_query_id;
+    }
+
+    throwIfCanceled();
+
+    if (query_timeout > 0)
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(query_timeout);
 
-    // LOG("curl 'http://" << connection.session->getHost() << ":" << connection.session->getPort() << request.getURI() << "' -d '" << prepared_query << "'");
+    // The data of a batch is only summed up, it may be large, and it is not the query.
+    if (batch_insert) {
+        LOG(request.getMethod() << " " << session->getHost() << request.getURI() << " body=" << insert_head << " FORMAT TabSeparated"
+                                << " (" << batch_row_count << " rows, " << prepared_query.size() << " bytes)"
+                                << " UA=" << request.get("User-Agent"));
+    }
+    else {
+        LOG(request.getMethod() << " " << session->getHost() << request.getURI() << " body=" << prepared_query
+                                << " UA=" << request.get("User-Agent"));
+    }
+
+    if (compress_request)
+        LOG("Request body: " << prepared_query.size() << " bytes, sending " << compressed_query.size() << " bytes (" << accept_encoding << ")");
+
+    // LOG("curl 'http://" << session->getHost() << ":" << session->getPort() << request.getURI() << "' -d '" << prepared_query << "'");
 
     // Send request to server with finite count of retries.
     for (int i = 1;; ++i) {
         try {
-            connection.session->sendRequest(request) << prepared_query;
+            session->sendRequest(request) << (compress_request ? compressed_query : prepared_query);
             response = std::make_unique<Poco::Net::HTTPResponse>();
-            in = &connection.session->receiveResponse(*response);
+            in = &session->receiveResponse(*response);
             break;
+        } catch (const Poco::TimeoutException & e) {
+            resetSession();
+            throwIfCanceled();
+            LOG("Http request timed out: " << e.displayText());
+            connection.killQuery(query_id);
+            const auto sql_state = Connection::getTimeoutSQLState(read_query_timeout, connection.timeout);
+            throw SqlException((sql_state == "HYT00" ? "Query timeout expired" : "Connection timeout expired"), sql_state);
         } catch (const Poco::IOException & e) {
-            connection.session->reset(); // reset keepalived connection
+            resetSession(); // reset keepalived connection
+            throwIfCanceled();
             LOG("Http request try=" << i << "/" << connection.retry_count << " failed: " << e.what() << ": " << e.message());
             if (i > connection.retry_count)
                 throw;
         }
     }
 
+    // The body is decompressed on the fly, if the server did compress it.
+    response_stream = std::make_unique<ResponseStream>(*in, response->get("Content-Encoding", ""));
+
     Poco::Net::HTTPResponse::HTTPStatus status = response->getStatus();
     if (status != Poco::Net::HTTPResponse::HTTP_OK) {
         std::stringstream error_message;
-        error_message << "HTTP status code: " << status << std::endl << "Received error:" << std::endl << in->rdbuf() << std::endl;
+        error_message << "HTTP status code: " << status << std::endl << "Received error:" << std::endl << response_stream->get().rdbuf() << std::endl;
         LOG(error_message.str());
+        if (isTimeoutError(error_message.str()))
+            throw SqlException(error_message.str(), "HYT00");
         throw std::runtime_error(error_message.str());
     }
 
-    result_set.reset(new ResultSet{*in, std::move(mutator)});
+    if (batch_insert) {
+        setParamSetStatuses(param_set_array_size, SQL_PARAM_SUCCESS);
+        getDiagHeader().setAttr(SQL_DIAG_ROW_COUNT, batch_row_count);
+    }
+
+    std::unique_ptr<ResultSet> new_result_set;
+
+    try {
+        new_result_set = makeResultSet(connection.format, response_stream->get(), std::move(mutator), connection.read_buffer_size, response->get("X-ClickHouse-Timezone", ""));
+    } catch (...) {
+        throwIfCanceled();
+        throwIfTimedOut();
+        throw;
+    }
+
+    new_result_set->setReadAheadSize(getAttrAs<SQLULEN>(SQL_ATTR_CH_READ_AHEAD_SIZE, connection.read_ahead_size));
+    new_result_set->setRowLimit(max_rows);
+    if (connection.prefetch > 0)
+        new_result_set->startPrefetching(connection.prefetch);
+
+    setResultSet(std::move(new_result_set));
 
-    ++next_param_set;
+    next_param_set = (batch_insert ? param_set_array_size : next_param_set + 1);
+
+    // The response may have been cut short.
+    throwIfCanceled();
 }
 
 void Statement::processEscapeSequences() {
@@ -569,6 +734,19 @@ void Statement::executeQuery(const std::string & q, IResultMutatorPtr && mutator
     executeQuery(std::move(mutator));
 }
 
+void Statement::setResultSet(std::unique_ptr<ResultSet> && new_result_set) {
+    resetStaticCursor();
+    result_set = std::move(new_result_set);
+
+    // Scrollable cursors are static ones: rows are kept as they are read, so that they can be fetched again.
+    if (getAttrAs<SQLULEN>(SQL_ATTR_CURSOR_TYPE, SQL_CURSOR_FORWARD_ONLY) != SQL_CURSOR_FORWARD_ONLY) {
+        std::vector<ValueEncoding> encodings;
+        for (std::size_t i = 0; i < result_set->getNumColumns(); ++i)
+            encodings.push_back(result_set->getFieldEncoding(i));
+        static_rows = std::make_unique<RowStore>(std::move(encodings), getParent().cursor_memory_limit);
+    }
+}
+
 bool Statement::hasResultSet() const {
     return !!result_set;
 }
@@ -596,14 +774,27 @@ size_t Statement::getNumColumns() const {
 }
 
 bool Statement::hasCurrentRow() const {
+    if (static_rows)
+        return (rowset_start > 0);
+
     return (hasResultSet() ? result_set->hasCurrentRow() : false);
 }
 
-const Row & Statement::getCurrentRow() const {
-    return result_set->getCurrentRow();
+Field Statement::getCurrentField(std::size_t column_idx) const {
+    if (static_rows)
+        return current_row_fields.at(column_idx);
+
+    return result_set->getCurrentField(column_idx);
+}
+
+ValueEncoding Statement::getFieldEncoding(std::size_t column_idx) const {
+    return result_set->getFieldEncoding(column_idx);
 }
 
 std::size_t Statement::getCurrentRowNum() const {
+    if (static_rows)
+        return rowset_start;
+
     return (hasResultSet() ? result_set->getCurrentRowNum() : 0);
 }
 
@@ -614,31 +805,546 @@ bool Statement::advanceToNextRow() {
         advanced = result_set->advanceToNextRow();
         if (!advanced)
             getDiagHeader().setAttr(SQL_DIAG_ROW_COUNT, result_set->getCurrentRowNum());
+        closeStreamIfRowLimitReached();
     }
 
     return advanced;
 }
 
+template <typename GetField, typename GetFixedWidthValues>
+SQLRETURN Statement::convertRows(std::size_t first_row, std::size_t num_rows, GetField && get_field, GetFixedWidthValues && get_fixed_width_values) {
+    const auto & plan = getFetchPlan();
+
+    auto & ard = getEffectiveDescriptor(SQL_ATTR_APP_ROW_DESC);
+    const auto bind_type = ard.getAttrAs<SQLULEN>(SQL_DESC_BIND_TYPE, SQL_BIND_BY_COLUMN);
+    const auto * bind_offset_ptr = ard.getAttrAs<SQLULEN *>(SQL_DESC_BIND_OFFSET_PTR, 0);
+    const auto bind_offset = (bind_offset_ptr ? *bind_offset_ptr : 0);
+
+    for (const auto & entry : plan) {
+        const auto & binding = entry.binding;
+
+        const std::size_t value_stride = (bind_type == SQL_BIND_BY_COLUMN ? getBoundElementSize(binding.type, binding.value_max_size) : bind_type);
+        const std::size_t indicator_stride = (bind_type == SQL_BIND_BY_COLUMN ? sizeof(SQLLEN) : bind_type);
+
+        char * value = (binding.value ? static_cast<char *>(binding.value) + bind_offset + first_row * value_stride : nullptr);
+        char * indicator = (binding.indicator ? reinterpret_cast<char *>(binding.indicator) + bind_offset + first_row * indicator_stride : nullptr);
+
+        // Values that are stored as the bound array lays them out, with none of them NULL, are copied at once.
+        if (bind_type == SQL_BIND_BY_COLUMN && entry.is_binary_of_c_type && value) {
+            const auto * values = get_fixed_width_values(entry.column_idx);
+            if (values) {
+                std::memcpy(value, values, num_rows * value_stride);
+
+                if (indicator) {
+                    auto * indicators = reinterpret_cast<SQLLEN *>(indicator);
+                    for (std::size_t i = 0; i < num_rows; ++i)
+                        indicators[i] = static_cast<SQLLEN>(value_stride);
+                }
+
+                continue;
+            }
+        }
+
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            const auto field = get_field(i, entry.column_idx);
+            auto * indicator_ptr = reinterpret_cast<SQLLEN *>(indicator);
+
+            const auto code = (field.isNull()
+                ? fillOutputNULL(value, binding.value_max_size, indicator_ptr)
+                : entry.converter(field, value, binding.value_max_size, indicator_ptr)
+            );
+
+            auto & row_status = row_statuses[first_row + i];
+
+            if (code == SQL_SUCCESS_WITH_INFO) {
+                if (row_status == SQL_ROW_SUCCESS)
+                    row_status = SQL_ROW_SUCCESS_WITH_INFO;
+            }
+            else if (code == SQL_ERROR) {
+                fillConversionError(*this, field, binding.type);
+                auto & record = getDiagStatus(getDiagStatusCount());
+                record.setAttr(SQL_DIAG_ROW_NUMBER, static_cast<SQLLEN>(first_row + i + 1));
+                record.setAttr(SQL_DIAG_COLUMN_NUMBER, static_cast<SQLINTEGER>(entry.column_idx + 1));
+                row_status = SQL_ROW_ERROR;
+            }
+            else if (code != SQL_SUCCESS) {
+                return code;
+            }
+
+            if (value)
+                value += value_stride;
+            if (indicator)
+                indicator += indicator_stride;
+        }
+    }
+
+    return SQL_SUCCESS;
+}
+
+SQLRETURN Statement::finishRowset(std::size_t num_rows, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr) {
+    if (rows_fetched_ptr)
+        *rows_fetched_ptr = num_rows;
+
+    if (num_rows == 0)
+        return SQL_NO_DATA;
+
+    std::size_t num_errors = 0;
+    bool has_info = false;
+
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        num_errors += (row_statuses[i] == SQL_ROW_ERROR);
+        has_info = has_info || (row_statuses[i] != SQL_ROW_SUCCESS);
+    }
+
+    if (row_status_ptr) {
+        std::copy(row_statuses.begin(), row_statuses.begin() + num_rows, row_status_ptr);
+        std::fill(row_status_ptr + num_rows, row_status_ptr + rowset_size, SQL_ROW_NOROW);
+    }
+
+    if (num_errors == num_rows)
+        return SQL_ERROR;
+
+    return (has_info ? SQL_SUCCESS_WITH_INFO : SQL_SUCCESS);
+}
+
+SQLRETURN Statement::fetchRowset(SQLSMALLINT orientation, SQLLEN offset, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr) {
+    throwIfCanceled();
+
+    SQLRETURN rc = SQL_ERROR;
+
+    try {
+        rc = readRowset(orientation, offset, rowset_size, rows_fetched_ptr, row_status_ptr);
+    } catch (...) {
+        throwIfCanceled();
+        throwIfTimedOut();
+        throw;
+    }
+
+    // A response cut short by the cancellation looks like a finished one.
+    throwIfCanceled();
+    return rc;
+}
+
+SQLRETURN Statement::readRowset(SQLSMALLINT orientation, SQLLEN offset, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr) {
+    if (rows_fetched_ptr)
+        *rows_fetched_ptr = 0;
+
+    if (!hasResultSet())
+        return SQL_NO_DATA;
+
+    rowset_size = std::max<SQLULEN>(rowset_size, 1);
+    row_statuses.assign(rowset_size, SQL_ROW_SUCCESS);
+
+    if (static_rows)
+        return fetchStaticRowset(orientation, offset, rowset_size, rows_fetched_ptr, row_status_ptr);
+
+    if (orientation != SQL_FETCH_NEXT)
+        throw SqlException("Fetch type out of range", "HY106");
+
+    std::size_t num_rows = 0;
+
+    while (num_rows < rowset_size) {
+        // Rows come in runs that are contiguous in the current batch, each converted column by column.
+        const auto run_size = result_set->advanceToNextRows(rowset_size - num_rows);
+        if (run_size == 0) {
+            getDiagHeader().setAttr(SQL_DIAG_ROW_COUNT, result_set->getCurrentRowNum());
+            break;
+        }
+
+        const auto code = convertRows(num_rows, run_size,
+            [this] (std::size_t row_idx, std::size_t column_idx) {
+                return result_set->getField(row_idx, column_idx);
+            },
+            [this] (std::size_t column_idx) {
+                return result_set->getFixedWidthValues(column_idx);
+            }
+        );
+
+        closeStreamIfRowLimitReached();
+
+        if (code != SQL_SUCCESS)
+            return code;
+
+        num_rows += run_size;
+    }
+
+    return finishRowset(num_rows, rowset_size, rows_fetched_ptr, row_status_ptr);
+}
+
+SQLRETURN Statement::fetchStaticRowset(SQLSMALLINT orientation, SQLLEN offset, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr) {
+    // Positions are 1-based numbers of rows, 0 is before the first row. Rows are read from the server only as far as needed,
+    // all of them only when a position is counted from the end.
+    const auto current = static_cast<SQLLEN>(rowset_start);
+    const auto size = static_cast<SQLLEN>(rowset_size);
+    SQLLEN target = 0;
+    bool clamped = false; // Moved back to the first row instead of before it.
+
+    switch (orientation) {
+        case SQL_FETCH_NEXT:
+            if (after_last_row)
+                return SQL_NO_DATA;
+            target = (current == 0 ? 1 : current + static_cast<SQLLEN>(last_rowset_size));
+            break;
+
+        case SQL_FETCH_PRIOR:
+            if (after_last_row) {
+                const auto num_rows = static_cast<SQLLEN>(readAllStaticRows());
+                target = (num_rows == 0 ? 0 : std::max<SQLLEN>(num_rows - size + 1, 1));
+            }
+            else if (current <= 1) {
+                target = 0;
+            }
+            else if (current <= size) {
+                target = 1;
+                clamped = true;
+            }
+            else {
+                target = current - size;
+            }
+            break;
+
+        case SQL_FETCH_RELATIVE:
+            if (after_last_row) {
+                if (offset >= 0)
+                    return SQL_NO_DATA;
+                target = static_cast<SQLLEN>(readAllStaticRows()) + 1 + offset;
+            }
+            else if (current == 0) {
+                target = std::max<SQLLEN>(offset, 0);
+            }
+            else {
+                target = current + offset;
+                if (target < 1 && current > 1 && -offset <= size) {
+                    target = 1;
+                    clamped = true;
+                }
+            }
+            break;
+
+        case SQL_FETCH_ABSOLUTE:
+            if (offset >= 0) {
+                target = offset;
+            }
+            else {
+                target = static_cast<SQLLEN>(readAllStaticRows()) + 1 + offset;
+                if (target < 1 && -offset <= size) {
+                    target = 1;
+                    clamped = true;
+                }
+            }
+            break;
+
+        case SQL_FETCH_FIRST:
+            target = 1;
+            break;
+
+        case SQL_FETCH_LAST:
+            target = std::max<SQLLEN>(static_cast<SQLLEN>(readAllStaticRows()) - size + 1, 1);
+            break;
+
+        default:
+            throw SqlException("Fetch type out of range", "HY106");
+    }
+
+    if (target < 1) {
+        rowset_start = 0;
+        after_last_row = false;
+        return SQL_NO_DATA;
+    }
+
+    readStaticRows(static_cast<std::size_t>(target) + rowset_size - 1);
+
+    const auto num_stored_rows = static_rows->getNumRows();
+    if (static_cast<std::size_t>(target) > num_stored_rows) {
+        rowset_start = 0;
+        after_last_row = true;
+        return SQL_NO_DATA;
+    }
+
+    rowset_start = static_cast<std::size_t>(target);
+    after_last_row = false;
+    last_rowset_size = rowset_size;
+
+    const auto num_rows = std::min<std::size_t>(rowset_size, num_stored_rows - rowset_start + 1);
+
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        static_rows->getRow(rowset_start - 1 + i, current_row_fields);
+
+        const auto code = convertRows(i, 1,
+            [this] (std::size_t /* row_idx */, std::size_t column_idx) {
+                return current_row_fields[column_idx];
+            },
+            [this] (std::size_t column_idx) -> const char * {
+                const auto & field = current_row_fields[column_idx];
+                return (field.isNull() ? nullptr : field.data());
+            }
+        );
+
+        if (code != SQL_SUCCESS)
+            return code;
+    }
+
+    // SQLGetData reads the first row of the rowset.
+    static_rows->getRow(rowset_start - 1, current_row_fields);
+
+    const auto code = finishRowset(num_rows, rowset_size, rows_fetched_ptr, row_status_ptr);
+
+    if (clamped && code == SQL_SUCCESS) {
+        fillDiag("01S06", "Attempt to fetch before the result set returned the first rowset");
+        return SQL_SUCCESS_WITH_INFO;
+    }
+
+    return code;
+}
+
+void Statement::readStaticRows(std::size_t num_rows) {
+    while (static_rows->getNumRows() < num_rows) {
+        const auto run_size = result_set->advanceToNextRows(num_rows - static_rows->getNumRows());
+        if (run_size == 0) {
+            getDiagHeader().setAttr(SQL_DIAG_ROW_COUNT, result_set->getCurrentRowNum());
+            break;
+        }
+
+        for (std::size_t i = 0; i < run_size; ++i)
+            static_rows->appendRow(*result_set, i);
+
+        closeStreamIfRowLimitReached();
+    }
+}
+
+std::size_t Statement::readAllStaticRows() {
+    readStaticRows(std::numeric_limits<std::size_t>::max());
+    return static_rows->getNumRows();
+}
+
+void Statement::resetStaticCursor() {
+    if (static_rows && static_rows->isSpilled())
+        LOG("Static cursor: " << static_rows->getNumRows() << " rows, " << static_rows->getByteSize() << " bytes, spilled to a file");
+
+    static_rows.reset();
+    current_row_fields.clear();
+    rowset_start = 0;
+    after_last_row = false;
+    last_rowset_size = 1;
+}
+
 void Statement::closeCursor() {
-    auto & connection = getParent();
-    if (connection.session && response && in)
-        if (!*in || in->peek() != EOF)
-            connection.session->reset();
+    closeResultSet();
+
+    {
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        canceled = false;
+    }
+
+    parameters.clear();
+    query.clear();
+}
+
+void Statement::closeResultSet() {
+    // Stops prefetching, if any, before the stream is touched here.
+    if (result_set)
+        result_set->stopPrefetching([this] { abortResponse(); });
 
     result_set.reset();
+    invalidateFetchPlan();
+    resetStaticCursor();
+    releaseResponseStream();
+    finishResponse();
+
+    deadline = std::chrono::steady_clock::time_point::max();
+}
+
+void Statement::cancel() {
+    std::string query_to_kill;
+
+    {
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        if (!session && !async_operation_running)
+            return;
+
+        canceled = true;
+
+        if (session)
+            query_to_kill = abortResponseLocked();
+    }
+
+    LOG("Canceled" << (query_to_kill.empty() ? "" : " query " + query_to_kill));
+    getParent().killQuery(query_to_kill);
+}
+
+std::string Statement::abortResponseLocked() {
+    // Wakes up the thread waiting for the response, if any. Fails if the session is not connected yet,
+    // in which case the request is not sent at all.
+    try {
+        session->socket().shutdownReceive();
+    } catch (const std::exception & e) {
+        LOG("Aborting the response of query " << query_id << " failed: " << e.what());
+    }
+
+    return query_id;
+}
+
+void Statement::abortResponse() {
+    std::string query_to_kill;
+
+    {
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        if (!session)
+            return;
+
+        response_aborted = true;
+        query_to_kill = abortResponseLocked();
+    }
+
+    LOG("Aborted the response of query " << query_to_kill);
+    getParent().killQuery(query_to_kill);
+}
+
+bool Statement::isCanceled() const {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    return canceled;
+}
+
+void Statement::throwIfCanceled() {
+    if (!isCanceled())
+        return;
+
+    // Clears the flag only after the session has been reset.
+    closeResultSet();
+
+    {
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        canceled = false;
+    }
+
+    throw SqlException("Operation canceled", "HY008");
+}
+
+void Statement::throwIfTimedOut() {
+    if (std::chrono::steady_clock::now() < deadline)
+        return;
+
+    closeResultSet();
+    throw SqlException("Query timeout expired", "HYT00");
+}
+
+void Statement::resetSession() {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    session->reset();
+}
+
+void Statement::closeStreamIfRowLimitReached() {
+    if (!in || !result_set || !result_set->isRowLimitReached())
+        return;
+
+    // The rows already read stay in the result set, nothing is read from the stream after this.
+    result_set->stopPrefetching([this] { abortResponse(); });
+
+    LOG("Row limit of " << getAttrAs<SQLULEN>(SQL_ATTR_MAX_ROWS, 0) << " reached, closing the response stream");
+    finishResponse();
+}
+
+void Statement::finishResponse() {
+    auto & connection = getParent();
+
+    if (session && response && in) {
+        // A canceled or aborted response may look finished, but the socket is shut down already, and the query is being killed.
+        if (in->bad() || isCanceled() || response_aborted) {
+            resetSession();
+        }
+        else if (!in->eof() && !drainResponse()) {
+            connection.killQuery(query_id);
+            resetSession();
+        }
+    }
+
     in = nullptr;
     response.reset();
 
-    parameters.clear();
-    query.clear();
+    std::unique_ptr<Poco::Net::HTTPClientSession> finished_session;
+
+    {
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        finished_session = std::move(session);
+        response_aborted = false;
+    }
+
+    if (finished_session)
+        connection.releaseSession(std::move(finished_session));
+}
+
+bool Statement::drainResponse() {
+    auto & socket = session->socket();
+    const auto receive_timeout = socket.getReceiveTimeout();
+    std::size_t drained = 0;
+    bool finished = false;
+
+    try {
+        // Errors of the stream, timeouts included, are caught by it and set its badbit.
+        finished = drainStream(*in, max_drain_size, std::chrono::steady_clock::now() + max_drain_wait, drained,
+            [&socket] (std::chrono::microseconds time_left) {
+                socket.setReceiveTimeout(Poco::Timespan(time_left.count()));
+            }
+        );
+
+        socket.setReceiveTimeout(receive_timeout);
+    } catch (const std::exception & e) {
+        LOG("Draining the response failed: " << e.what());
+        return false;
+    }
+
+    LOG("Response " << (finished ? "drained" : "not drained") << ", " << drained << " bytes dropped");
+    return finished;
+}
+
+void Statement::releaseResponseStream() {
+    if (!response_stream)
+        return;
+
+    LOG("Response body: received " << response_stream->getReceivedBytes() << " bytes"
+        << (response_stream->getContentEncoding().empty() ? "" : " (" + response_stream->getContentEncoding() + ")")
+        << ", decoded " << response_stream->getDecodedBytes() << " bytes");
+
+    response_stream.reset();
 }
 
 void Statement::resetColBindings() {
     bindings.clear();
+    invalidateFetchPlan();
 
     getEffectiveDescriptor(SQL_ATTR_APP_ROW_DESC).setAttr(SQL_DESC_COUNT, 0);
 }
 
+const std::vector<FetchPlanEntry> & Statement::getFetchPlan() {
+    if (fetch_plan_valid)
+        return fetch_plan;
+
+    fetch_plan.clear();
+    fetch_plan.reserve(bindings.size());
+
+    for (const auto & col_num_binding : bindings) {
+        const auto column_number = col_num_binding.first;
+
+        if (column_number < 1 || column_number > getNumColumns())
+            throw SqlException("Column number " + std::to_string(column_number) + " is out of range: 1.." +
+                std::to_string(getNumColumns()), "07009");
+
+        FetchPlanEntry entry;
+        entry.column_idx = column_number - 1;
+        entry.binding = col_num_binding.second;
+        entry.converter = getColumnConverter(getFieldEncoding(entry.column_idx), entry.binding.type);
+        entry.is_binary_of_c_type = isBinaryOfCType(getFieldEncoding(entry.column_idx), entry.binding.type);
+        fetch_plan.push_back(entry);
+    }
+
+    fetch_plan_valid = true;
+    return fetch_plan;
+}
+
+void Statement::invalidateFetchPlan() {
+    fetch_plan_valid = false;
+}
+
 void Statement::resetParamBindings() {
     getEffectiveDescriptor(SQL_ATTR_APP_PARAM_DESC).setAttr(SQL_DESC_COUNT, 0);
 }
@@ -657,6 +1363,55 @@ std::string Statement::getParamFinalName(std::size_t param_idx) {
     return "odbc_positional_" + std::to_string(param_idx + 1);
 }
 
+std::string Statement::buildBatchInsert(const std::string & insert_head, std::size_t param_set_count, std::size_t & row_count) {
+    const auto * operation_ptr = getEffectiveDescriptor(SQL_ATTR_APP_PARAM_DESC).getAttrAs<SQLUSMALLINT *>(SQL_DESC_ARRAY_STATUS_PTR, 0);
+
+    std::string body = insert_head + " FORMAT TabSeparated\n";
+    row_count = 0;
+
+    for (std::size_t param_set_idx = 0; param_set_idx < param_set_count; ++param_set_idx) {
+        if (operation_ptr && operation_ptr[param_set_idx] == SQL_PARAM_IGNORE)
+            continue;
+
+        const auto param_bindings = getParamsBindingInfo(param_set_idx);
+
+        if (param_bindings.size() < parameters.size())
+            throw SqlException("COUNT field incorrect", "07002");
+
+        for (std::size_t i = 0; i < parameters.size(); ++i) {
+            const auto & binding_info = param_bindings[i];
+
+            if (!isInputParam(binding_info.io_type) || isStreamParam(binding_info.io_type))
+                throw std::runtime_error("Unable to extract data from bound param buffer: param IO type is not supported");
+
+            if (i > 0)
+                body += '\t';
+
+            if (binding_info.indicator && *binding_info.indicator == SQL_NULL_DATA)
+                body += "\\N";
+            else
+                appendEscapedForTabSeparated(readReadyDataTo<std::string>(binding_info), body);
+        }
+
+        body += '\n';
+        ++row_count;
+    }
+
+    LOG("Inserting " << row_count << " parameter sets of " << param_set_count << " in a single request");
+    return body;
+}
+
+void Statement::setParamSetStatuses(std::size_t param_set_count, SQLUSMALLINT status) {
+    auto * status_ptr = getEffectiveDescriptor(SQL_ATTR_IMP_PARAM_DESC).getAttrAs<SQLUSMALLINT *>(SQL_DESC_ARRAY_STATUS_PTR, 0);
+    const auto * operation_ptr = getEffectiveDescriptor(SQL_ATTR_APP_PARAM_DESC).getAttrAs<SQLUSMALLINT *>(SQL_DESC_ARRAY_STATUS_PTR, 0);
+
+    if (!status_ptr)
+        return;
+
+    for (std::size_t param_set_idx = 0; param_set_idx < param_set_count; ++param_set_idx)
+        status_ptr[param_set_idx] = (operation_ptr && operation_ptr[param_set_idx] == SQL_PARAM_IGNORE ? SQL_PARAM_UNUSED : status);
+}
+
 std::vector<ParamBindingInfo> Statement::getParamsBindingInfo(std::size_t param_set_idx) {
     std::vector<ParamBindingInfo> param_bindings;
 
@@ -695,9 +1450,16 @@ std::vector<ParamBindingInfo> Statement::getParamsBindingInfo(std::size_t param_
         binding_info.type = apd_record.getAttrAs<SQLSMALLINT>(SQL_DESC_CONCISE_TYPE, SQL_C_DEFAULT);
         binding_info.sql_type = ipd_record.getAttrAs<SQLSMALLINT>(SQL_DESC_CONCISE_TYPE, SQL_UNKNOWN_TYPE);
         binding_info.value_max_size = ipd_record.getAttrAs<SQLULEN>(SQL_DESC_LENGTH, 0); // TODO: or SQL_DESC_OCTET_LENGTH ?
-        binding_info.value = (void *)(data_ptr ? ((char *)(data_ptr) + param_set_idx * single_set_struct_size + bind_offset) : 0);
-        binding_info.value_size = (SQLLEN *)(sz_ptr ? ((char *)(sz_ptr) + param_set_idx * sizeof(SQLLEN) + bind_offset) : 0);
-        binding_info.indicator = (SQLLEN *)(ind_ptr ? ((char *)(ind_ptr) + param_set_idx * sizeof(SQLLEN) + bind_offset) : 0);
+
+        // Column-wise, the values of a parameter are as far apart as its buffers are long, and the lengths as SQLLEN.
+        const bool by_column = (single_set_struct_size == SQL_PARAM_BIND_BY_COLUMN);
+        const std::size_t value_stride = (by_column ?
+            getBoundElementSize(binding_info.type, apd_record.getAttrAs<SQLLEN>(SQL_DESC_OCTET_LENGTH, 0)) : single_set_struct_size);
+        const std::size_t length_stride = (by_column ? sizeof(SQLLEN) : single_set_struct_size);
+
+        binding_info.value = (void *)(data_ptr ? ((char *)(data_ptr) + param_set_idx * value_stride + bind_offset) : 0);
+        binding_info.value_size = (SQLLEN *)(sz_ptr ? ((char *)(sz_ptr) + param_set_idx * length_stride + bind_offset) : 0);
+        binding_info.indicator = (SQLLEN *)(ind_ptr ? ((char *)(ind_ptr) + param_set_idx * length_stride + bind_offset) : 0);
 
         param_bindings.emplace_back(binding_info);
     }
@@ -705,6 +1467,93 @@ std::vector<ParamBindingInfo> Statement::getParamsBindingInfo(std::size_t param_
     return param_bindings;
 }
 
+bool Statement::isAsyncEnabled() const {
+    const auto connection_default = getParent().getAttrAs<SQLULEN>(SQL_ATTR_ASYNC_ENABLE, SQL_ASYNC_ENABLE_OFF);
+    return (getAttrAs<SQLULEN>(SQL_ATTR_ASYNC_ENABLE, connection_default) == SQL_ASYNC_ENABLE_ON);
+}
+
+bool Statement::hasAsyncOperation() const {
+    return async_result.valid();
+}
+
+bool Statement::isExecutingAsynchronously() const {
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    return (async_operation_running && async_thread_id != std::this_thread::get_id());
+}
+
+void Statement::startAsyncOperation(SQLUSMALLINT function_id, std::function<SQLRETURN ()> && operation) {
+    if (hasAsyncOperation())
+        throw SqlException("Function sequence error", "HY010");
+
+    AsyncExecutor::CompletionHandler on_complete;
+
+#if defined(SQL_ATTR_ASYNC_STMT_PCALLBACK)
+    // Set by the driver manager when the application asked to be notified instead of polling.
+    const auto callback = getAttrAs<SQL_ASYNC_NOTIFICATION_CALLBACK>(SQL_ATTR_ASYNC_STMT_PCALLBACK, nullptr);
+    const auto context = getAttrAs<SQLPOINTER>(SQL_ATTR_ASYNC_STMT_PCONTEXT, nullptr);
+    if (callback) {
+        on_complete = [callback, context] () {
+            callback(context, SQL_TRUE);
+        };
+    }
+#endif
+
+    // Before the worker may start, so that it sees a cancellation that comes right away.
+    {
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        async_operation_running = true;
+    }
+
+    // The worker thread makes itself known, so that the functions it calls on the statement are not refused.
+    auto task = [this, operation = std::move(operation)] () {
+        {
+            std::lock_guard<std::mutex> lock(cancel_mutex);
+            async_thread_id = std::this_thread::get_id();
+        }
+        return operation();
+    };
+
+    try {
+        async_result = AsyncExecutor::getInstance().submit(std::move(task), std::move(on_complete));
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(cancel_mutex);
+        async_operation_running = false;
+        throw;
+    }
+
+    async_function_id = function_id;
+}
+
+SQLRETURN Statement::pollAsyncOperation(SQLUSMALLINT function_id) {
+    if (!hasAsyncOperation() || function_id != async_function_id) {
+        LOG("HY010 (Function " << function_id << " called while function " << async_function_id << " is executing asynchronously)");
+        return SQL_ERROR;
+    }
+
+    if (async_result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return SQL_STILL_EXECUTING;
+
+    return waitForAsyncOperation();
+}
+
+SQLRETURN Statement::waitForAsyncOperation() {
+    if (!hasAsyncOperation())
+        return SQL_SUCCESS;
+
+    async_function_id = 0;
+    const auto rc = async_result.get(); // Invalidates the future.
+
+    std::lock_guard<std::mutex> lock(cancel_mutex);
+    async_operation_running = false;
+    async_thread_id = std::thread::id();
+
+    // Canceled too late to have an effect on the function, and there is no response to abort.
+    if (!session)
+        canceled = false;
+
+    return rc;
+}
+
 Descriptor& Statement::getEffectiveDescriptor(SQLINTEGER type) {
     switch (type) {
         case SQL_ATTR_APP_ROW_DESC:   return choose(implicit_ard, explicit_ard);
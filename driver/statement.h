@@ -4,12 +4,21 @@
 #include "connection.h"
 #include "descriptor.h"
 #include "result_set.h"
+#include "column_converter.h"
+#include "response_stream.h"
+#include "row_store.h"
 
+#include <Poco/Net/HTTPClientSession.h>
 #include <Poco/Net/HTTPResponse.h>
 
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 /// Helper structure that represents information about where and
@@ -22,6 +31,14 @@ struct BindingInfo {
     SQLLEN * indicator = nullptr;
 };
 
+/// A bound column of the current result set, with the converter of its values to the C type of the binding chosen in advance.
+struct FetchPlanEntry {
+    std::size_t column_idx = 0;
+    BindingInfo binding;
+    ColumnConverter converter = nullptr;
+    bool is_binary_of_c_type = false; // The values are stored as the C type of the binding lays them out, see isBinaryOfCType().
+};
+
 /// Helper structure that represents information about where and
 /// how to get or put values when reading or writing bound parameter buffers.
 struct ParamBindingInfo
@@ -59,6 +76,10 @@ public:
     /// Prepare and execute query.
     void executeQuery(const std::string & q, IResultMutatorPtr && mutator = IResultMutatorPtr {});
 
+    /// Make 'new_result_set' the current result set, read through a static cursor if SQL_ATTR_CURSOR_TYPE asks for
+    /// a scrollable one. The result set of a query is set this way once the response arrives.
+    void setResultSet(std::unique_ptr<ResultSet> && new_result_set);
+
     /// Indicates whether there is an result set available for reading.
     bool hasResultSet() const;
 
@@ -71,25 +92,65 @@ public:
 
     bool hasCurrentRow() const;
 
-    const Row & getCurrentRow() const;
+    /// A view of a value of the current row, valid until the cursor is advanced.
+    Field getCurrentField(std::size_t column_idx) const;
+
+    /// How the values of the column are stored, i.e., the encoding of the fields returned by getCurrentField().
+    ValueEncoding getFieldEncoding(std::size_t column_idx) const;
 
     /// Checked way of retrieving the number of the current row in the current result set.
     std::size_t getCurrentRowNum() const;
 
     bool advanceToNextRow();
 
+    /// Fetch a rowset of up to 'rowset_size' rows into the bound columns, laid out as the ARD describes (binding type
+    /// and offset), and report the number of rows and the status of each of them, if requested. Forward-only cursors support
+    /// only SQL_FETCH_NEXT, static ones all the orientations but SQL_FETCH_BOOKMARK, with 'offset' as in SQLFetchScroll.
+    /// Returns SQL_NO_DATA past the ends of the result set, and SQL_ERROR only if every row of the rowset failed to convert.
+    SQLRETURN fetchRowset(SQLSMALLINT orientation, SQLLEN offset, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr);
+
     /// Reset statement to initial state.
     void closeCursor();
 
+    /// Stop the function executing on the statement, which may be running in another thread: the read of the response
+    /// is aborted, the query is killed on the server, and the function fails with HY008. Has no effect if neither
+    /// a function is executing asynchronously nor a request is in progress.
+    void cancel();
+
     /// Reset/release row/column buffer bindings.
     void resetColBindings();
 
+    /// The bound columns with their converters, rebuilt only after the bindings or the result set change.
+    const std::vector<FetchPlanEntry> & getFetchPlan();
+
+    /// Must be called whenever 'bindings' are modified.
+    void invalidateFetchPlan();
+
     /// Reset/release parameter buffer bindings.
     void resetParamBindings();
 
     /// Access the effective descriptor by its role (type).
     Descriptor & getEffectiveDescriptor(SQLINTEGER type);
 
+    /// Whether SQL_ATTR_ASYNC_ENABLE is on for the statement, or, unless set for the statement, for its connection.
+    bool isAsyncEnabled() const;
+
+    bool hasAsyncOperation() const;
+
+    /// Whether an operation started by startAsyncOperation() has not been polled to its end yet, and the calling thread
+    /// is not the worker thread running it. Only polling, cancelling, and reading the diagnostics are allowed then.
+    bool isExecutingAsynchronously() const;
+
+    /// Run 'operation', the body of the function 'function_id' (SQL_API_*), in a worker thread.
+    void startAsyncOperation(SQLUSMALLINT function_id, std::function<SQLRETURN ()> && operation);
+
+    /// SQL_STILL_EXECUTING while the pending operation runs, and its result once it has finished, after which
+    /// there is no pending operation anymore. Only the function that started the operation may poll it.
+    SQLRETURN pollAsyncOperation(SQLUSMALLINT function_id);
+
+    /// Block until the pending operation, if any, finishes, and return its result.
+    SQLRETURN waitForAsyncOperation();
+
     /// Set an explicit descriptor for a role (type).
     void setExplicitDescriptor(SQLINTEGER type, std::shared_ptr<Descriptor> desc);
 
@@ -99,12 +160,80 @@ public:
 private:
     void requestNextPackOfResultSets(IResultMutatorPtr && mutator);
 
+    /// Drop the current result set, and finish its response.
+    void closeResultSet();
+
+    SQLRETURN readRowset(SQLSMALLINT orientation, SQLLEN offset, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr);
+
+    bool isCanceled() const;
+
+    /// If the statement has been canceled, close the result set and fail with HY008.
+    void throwIfCanceled();
+
+    /// If SQL_ATTR_QUERY_TIMEOUT of the last request has expired, close the result set and fail with HYT00.
+    /// For telling a response cut short by a timeout from a broken one.
+    void throwIfTimedOut();
+
+    /// Reset the connection of the session, which the socket of may be shut down by cancel() concurrently.
+    void resetSession();
+
+    /// Make the reads of the response fail right away, and kill the query. Must be called with 'cancel_mutex' locked.
+    /// Returns the id of the query to kill, which should be done after unlocking.
+    std::string abortResponseLocked();
+
+    /// Abort the response, for the prefetching thread of the result set to stop without waiting for the rest of it.
+    /// finishResponse() resets the session then.
+    void abortResponse();
+
+    /// Logs the sizes of the response body, as received and as decoded, and releases the decoding stream.
+    void releaseResponseStream();
+
+    /// Once the rows up to SQL_ATTR_MAX_ROWS have been read, finish the response instead of letting the rest of it be downloaded.
+    void closeStreamIfRowLimitReached();
+
+    /// Finish with the response of the last request, and return the session to the connection. The rest of the body
+    /// is read and dropped if it is small and arrives quickly, keeping the connection alive. Otherwise, the query is killed
+    /// on the server and the connection is reset. The result set must not be reading the response anymore.
+    void finishResponse();
+
+    /// Read and drop the rest of the response body, up to a small limit, and for a short time in total, see drainStream().
+    /// Returns true if the end of the body has been reached.
+    bool drainResponse();
+
+    /// Convert 'num_rows' rows into the bound columns, starting at the row 'first_row' of the rowset, column by column.
+    /// 'get_field(row_idx, column_idx)' returns the fields of the rows, 'row_idx' counting from 0. Conversion errors are
+    /// recorded in 'row_statuses', other unexpected results are returned.
+    /// 'get_fixed_width_values(column_idx)' returns the values of a column of all the rows back to back, or null, see
+    /// ResultSet::getFixedWidthValues(). If it does, and the column is bound column-wise as a C type that lays the values out
+    /// the same way, they are copied at once.
+    template <typename GetField, typename GetFixedWidthValues>
+    SQLRETURN convertRows(std::size_t first_row, std::size_t num_rows, GetField && get_field, GetFixedWidthValues && get_fixed_width_values);
+
+    /// Report the number of rows and their statuses, and pick the result of the fetch.
+    SQLRETURN finishRowset(std::size_t num_rows, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr);
+
+    SQLRETURN fetchStaticRowset(SQLSMALLINT orientation, SQLLEN offset, SQLULEN rowset_size, SQLULEN * rows_fetched_ptr, SQLUSMALLINT * row_status_ptr);
+
+    /// Read rows of the result set into the store of the static cursor, until it has 'num_rows' rows or the result set ends.
+    void readStaticRows(std::size_t num_rows);
+    std::size_t readAllStaticRows();
+
+    void resetStaticCursor();
+
     void processEscapeSequences();
     void extractParametersinfo();
     std::string buildFinalQuery(const std::vector<ParamBindingInfo>& param_bindings);
     std::string getParamFinalName(std::size_t param_idx);
     std::vector<ParamBindingInfo> getParamsBindingInfo(std::size_t param_set_idx);
 
+    /// The query and the data of a single INSERT of the parameter sets that are not ignored (SQL_ATTR_PARAM_OPERATION_PTR),
+    /// as rows after 'insert_head', the query up to its VALUES. 'row_count' is set to the number of the rows.
+    /// They are sent with max_insert_block_size and min_insert_block_size_rows of 'row_count', so the server inserts them as one block.
+    std::string buildBatchInsert(const std::string & insert_head, std::size_t param_set_count, std::size_t & row_count);
+
+    /// Fill SQL_ATTR_PARAM_STATUS_PTR, if set, with 'status' for each of the parameter sets that are not ignored.
+    void setParamSetStatuses(std::size_t param_set_count, SQLUSMALLINT status);
+
     Descriptor & choose(std::shared_ptr<Descriptor> & implicit_desc, std::weak_ptr<Descriptor> & explicit_desc);
 
     void allocateImplicitDescriptors();
@@ -127,11 +256,38 @@ private:
     std::string query;
     std::vector<ParamInfo> parameters;
 
+    // Cancellation may be requested from any thread: changes of 'session' and 'query_id', and their use by other
+    // threads, are guarded by 'cancel_mutex', as are the flags.
+    mutable std::mutex cancel_mutex;
+    bool canceled = false;
+    bool async_operation_running = false;
+    std::thread::id async_thread_id; // The worker thread running the pending operation, once it has started.
+    bool response_aborted = false; // Set by abortResponse(), by the thread of the statement only.
+
+    std::unique_ptr<Poco::Net::HTTPClientSession> session; // Leased from the connection until the response is finished.
     std::unique_ptr<Poco::Net::HTTPResponse> response;
     std::istream* in = nullptr;
+    std::string query_id; // Of the last request, to kill the query with.
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(); // Of the last request, by SQL_ATTR_QUERY_TIMEOUT.
+    std::unique_ptr<ResponseStream> response_stream;
     std::unique_ptr<ResultSet> result_set;
     std::size_t next_param_set = 0;
 
+    std::vector<FetchPlanEntry> fetch_plan;
+    std::vector<SQLUSMALLINT> row_statuses; // Of the rowset being fetched.
+    bool fetch_plan_valid = false;
+
+    // Static cursor state: the rows read so far, and the position of the current rowset.
+    std::unique_ptr<RowStore> static_rows;
+    std::vector<Field> current_row_fields; // Of the first row of the rowset, for SQLGetData.
+    std::size_t rowset_start = 0; // 1-based, 0 if the cursor is before the first row or after the last one.
+    bool after_last_row = false;
+    SQLULEN last_rowset_size = 1;
+
+    // Asynchronous execution: the function running in the worker thread, and its result.
+    SQLUSMALLINT async_function_id = 0;
+    std::future<SQLRETURN> async_result;
+
 public:
     // TODO: switch to using the corresponding descriptor attributes.
     std::map<SQLUSMALLINT, BindingInfo> bindings;
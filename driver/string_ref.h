@@ -11,6 +11,11 @@ struct StringRef {
     StringRef(const char * c_str) {
         *this = c_str;
     }
+    StringRef(const char * data_, size_t size_)
+        : data(data_)
+        , size(size_)
+    {
+    }
     StringRef & operator=(const char * c_str) {
         data = c_str;
         size = strlen(c_str);
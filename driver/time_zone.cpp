@@ -0,0 +1,454 @@
+#include "time_zone.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+int64_t floorDiv(int64_t value, int64_t divisor) {
+    return value / divisor - (value % divisor < 0 ? 1 : 0);
+}
+
+bool isLeapYear(int64_t year) {
+    return (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
+}
+
+int64_t getDaysInMonth(int64_t year, int64_t month) {
+    static const int64_t days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return days_in_month[month - 1] + (month == 2 && isLeapYear(year) ? 1 : 0);
+}
+
+/// Days since the epoch of a date of the proleptic Gregorian calendar.
+int64_t daysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= (month <= 2 ? 1 : 0);
+    const int64_t era = floorDiv(year, 400);
+    const int64_t year_of_era = year - era * 400;
+    const int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+int64_t yearFromDays(int64_t days) {
+    days += 719468;
+    const int64_t era = floorDiv(days, 146097);
+    const int64_t day_of_era = days - era * 146097;
+    const int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const int64_t mp = (5 * day_of_year + 2) / 153;
+    return year_of_era + era * 400 + (mp >= 10 ? 1 : 0);
+}
+
+/// 1970-01-01 was a Thursday.
+int64_t getDayOfWeek(int64_t days) {
+    const auto res = (days + 4) % 7;
+    return (res < 0 ? res + 7 : res);
+}
+
+/// Reader of POSIX TZ strings, like "CET-1CEST,M3.5.0,M10.5.0/3".
+class RuleParser {
+public:
+    explicit RuleParser(const std::string & rule_) : rule(rule_) {}
+
+    bool atEnd() const {
+        return pos == rule.size();
+    }
+
+    bool next(char ch) const {
+        return (!atEnd() && rule[pos] == ch);
+    }
+
+    bool skip(char ch) {
+        if (!next(ch))
+            return false;
+        ++pos;
+        return true;
+    }
+
+    void expect(char ch) {
+        if (!skip(ch))
+            fail();
+    }
+
+    /// Like "CET", or quoted like "<+03>".
+    void skipName() {
+        const auto begin = pos;
+
+        if (skip('<')) {
+            while (!atEnd() && rule[pos] != '>')
+                ++pos;
+            if (pos == begin + 1)
+                fail();
+            expect('>');
+            return;
+        }
+
+        while (!atEnd() && std::isalpha(static_cast<unsigned char>(rule[pos])))
+            ++pos;
+        if (pos - begin < 3)
+            fail();
+    }
+
+    /// [+|-]hh[:mm[:ss]], in seconds.
+    int64_t parseTime() {
+        int64_t sign = 1;
+        if (skip('-'))
+            sign = -1;
+        else
+            skip('+');
+
+        int64_t seconds = parseNumber(0, 167) * 3600;
+        if (skip(':')) {
+            seconds += parseNumber(0, 59) * 60;
+            if (skip(':'))
+                seconds += parseNumber(0, 59);
+        }
+
+        return sign * seconds;
+    }
+
+    int64_t parseNumber(int64_t min, int64_t max) {
+        const auto begin = pos;
+        int64_t res = 0;
+
+        while (!atEnd() && rule[pos] >= '0' && rule[pos] <= '9') {
+            res = res * 10 + (rule[pos] - '0');
+            if (res > max)
+                fail();
+            ++pos;
+        }
+
+        if (pos == begin || res < min)
+            fail();
+
+        return res;
+    }
+
+    [[noreturn]] void fail() const {
+        throw std::runtime_error("Cannot parse time zone rule '" + rule + "'");
+    }
+
+private:
+    const std::string & rule;
+    std::size_t pos = 0;
+};
+
+/// Reader of the big-endian binary data of TZif files.
+class TZifReader {
+public:
+    struct Header {
+        char version = '\0';
+        uint64_t isutcnt = 0;
+        uint64_t isstdcnt = 0;
+        uint64_t leapcnt = 0;
+        uint64_t timecnt = 0;
+        uint64_t typecnt = 0;
+        uint64_t charcnt = 0;
+    };
+
+    explicit TZifReader(const std::string & data_) : data(data_) {}
+
+    Header readHeader() {
+        if (std::string(read(4), 4) != "TZif")
+            fail();
+
+        Header res;
+        res.version = *read(1);
+        skip(15);
+        res.isutcnt = readUInt32();
+        res.isstdcnt = readUInt32();
+        res.leapcnt = readUInt32();
+        res.timecnt = readUInt32();
+        res.typecnt = readUInt32();
+        res.charcnt = readUInt32();
+        return res;
+    }
+
+    /// Skip the data that follows the header, with times of 'time_size' bytes.
+    void skipData(const Header & header, uint64_t time_size) {
+        skip(header.timecnt * (time_size + 1) + header.typecnt * 6 + header.charcnt + header.leapcnt * (time_size + 4) + header.isstdcnt + header.isutcnt);
+    }
+
+    const char * read(uint64_t size) {
+        if (data.size() - pos < size)
+            fail();
+        const auto * res = data.data() + pos;
+        pos += static_cast<std::size_t>(size);
+        return res;
+    }
+
+    void skip(uint64_t size) {
+        read(size);
+    }
+
+    int64_t readInt(std::size_t size) {
+        const auto * bytes = reinterpret_cast<const unsigned char *>(read(size));
+        uint64_t res = (bytes[0] & 0x80 ? ~uint64_t(0) : 0);
+        for (std::size_t i = 0; i < size; ++i)
+            res = (res << 8) | bytes[i];
+        return static_cast<int64_t>(res);
+    }
+
+    uint64_t readUInt32() {
+        return static_cast<uint32_t>(readInt(4));
+    }
+
+    /// The POSIX TZ string between newlines at the end of the file, may be empty.
+    std::string readFooter() {
+        if (*read(1) != '\n')
+            fail();
+
+        const auto end = data.find('\n', pos);
+        if (end == std::string::npos)
+            fail();
+
+        return data.substr(pos, end - pos);
+    }
+
+    [[noreturn]] void fail() const {
+        throw std::runtime_error("Malformed time zone data");
+    }
+
+private:
+    const std::string & data;
+    std::size_t pos = 0;
+};
+
+const char * const utc_names[] = {
+    "UTC", "Etc/UTC", "UCT", "Etc/UCT", "GMT", "Etc/GMT", "GMT0", "Etc/GMT0",
+    "Universal", "Etc/Universal", "Zulu", "Etc/Zulu",
+};
+
+std::string getDatabaseDir() {
+    const char * dir = std::getenv("TZDIR");
+    return (dir && *dir ? dir : "/usr/share/zoneinfo");
+}
+
+TimeZone loadTimeZone(const std::string & name) {
+    for (const auto * utc_name : utc_names) {
+        if (name == utc_name)
+            return TimeZone{};
+    }
+
+    // Names are paths relative to the database, nothing else may be read.
+    if (name.empty() || name.front() == '/' || name.find("..") != std::string::npos || name.find('\\') != std::string::npos)
+        throw std::runtime_error("Invalid time zone name '" + name + "'");
+
+    const std::string path = getDatabaseDir() + "/" + name;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Unknown time zone '" + name + "': cannot open " + path);
+
+    std::ostringstream data;
+    data << file.rdbuf();
+    return TimeZone::fromTZif(data.str());
+}
+
+} // namespace
+
+std::shared_ptr<const TimeZone> TimeZone::get(const std::string & name) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const TimeZone>> time_zones;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto & time_zone = time_zones[name];
+    if (!time_zone)
+        time_zone = std::make_shared<const TimeZone>(loadTimeZone(name));
+
+    return time_zone;
+}
+
+bool TimeZone::isDatabaseAvailable() {
+    // Every tz database has UTC.
+    std::ifstream file(getDatabaseDir() + "/UTC", std::ios::binary);
+    return static_cast<bool>(file);
+}
+
+TimeZone TimeZone::fromTZif(const std::string & data) {
+    TZifReader reader(data);
+
+    auto header = reader.readHeader();
+    std::size_t time_size = 4;
+
+    // Version 2 and later repeat the data with 64-bit times, and add a rule for the times after the last transition.
+    if (header.version >= '2') {
+        reader.skipData(header, 4);
+        header = reader.readHeader();
+        time_size = 8;
+    }
+
+    if (header.typecnt == 0)
+        reader.fail();
+
+    TimeZone res;
+
+    res.transitions.reserve(static_cast<std::size_t>(std::min<uint64_t>(header.timecnt, data.size())));
+    for (uint64_t i = 0; i < header.timecnt; ++i) {
+        res.transitions.push_back(reader.readInt(time_size));
+        if (i > 0 && res.transitions[i] <= res.transitions[i - 1])
+            reader.fail();
+    }
+
+    const auto * type_indices = reinterpret_cast<const unsigned char *>(reader.read(header.timecnt));
+
+    std::vector<int64_t> type_offsets;
+    for (uint64_t i = 0; i < header.typecnt; ++i) {
+        type_offsets.push_back(reader.readInt(4));
+        reader.skip(2); // isdst, desigidx
+    }
+
+    for (uint64_t i = 0; i < header.timecnt; ++i) {
+        if (type_indices[i] >= type_offsets.size())
+            reader.fail();
+        res.offsets.push_back(type_offsets[type_indices[i]]);
+    }
+
+    res.initial_offset = type_offsets[0];
+
+    reader.skip(header.charcnt + header.leapcnt * (time_size + 4) + header.isstdcnt + header.isutcnt);
+
+    if (header.version >= '2') {
+        const auto footer = reader.readFooter();
+        if (!footer.empty()) {
+            res.rule = parseRule(footer);
+            res.has_rule = true;
+        }
+    }
+
+    return res;
+}
+
+TimeZone TimeZone::fromPosixRule(const std::string & rule) {
+    TimeZone res;
+    res.rule = parseRule(rule);
+    res.has_rule = true;
+    return res;
+}
+
+TimeZone::Rule TimeZone::parseRule(const std::string & rule) {
+    RuleParser parser(rule);
+    Rule res;
+
+    // The offsets are of UTC from the wall clock, the opposite of ours.
+    parser.skipName();
+    res.std_offset = -parser.parseTime();
+    if (parser.atEnd())
+        return res;
+
+    parser.skipName();
+    res.has_dst = true;
+    res.dst_offset = (parser.atEnd() || parser.next(',') ? res.std_offset + 3600 : -parser.parseTime());
+
+    // The rules of the United States, when none are given.
+    if (parser.atEnd()) {
+        res.dst_start.month = 3;
+        res.dst_start.week = 2;
+        res.dst_end.month = 11;
+        res.dst_end.week = 1;
+        return res;
+    }
+
+    const auto parse_date = [&parser] () {
+        RuleDate date;
+
+        if (parser.skip('J')) {
+            date.kind = RuleDate::JulianNoLeap;
+            date.day = parser.parseNumber(1, 365);
+        } else if (parser.skip('M')) {
+            date.kind = RuleDate::MonthWeekDay;
+            date.month = parser.parseNumber(1, 12);
+            parser.expect('.');
+            date.week = parser.parseNumber(1, 5);
+            parser.expect('.');
+            date.day = parser.parseNumber(0, 6);
+        } else {
+            date.kind = RuleDate::JulianZeroBased;
+            date.day = parser.parseNumber(0, 365);
+        }
+
+        if (parser.skip('/'))
+            date.time = parser.parseTime();
+
+        return date;
+    };
+
+    parser.expect(',');
+    res.dst_start = parse_date();
+    parser.expect(',');
+    res.dst_end = parse_date();
+
+    if (!parser.atEnd())
+        parser.fail();
+
+    return res;
+}
+
+bool TimeZone::isUTC() const {
+    if (!transitions.empty())
+        return false;
+
+    if (has_rule)
+        return (!rule.has_dst && rule.std_offset == 0);
+
+    return (initial_offset == 0);
+}
+
+int64_t TimeZone::getOffset(int64_t utc_seconds) const {
+    if (!transitions.empty() && utc_seconds < transitions.front())
+        return initial_offset;
+
+    if (transitions.empty() || utc_seconds >= transitions.back()) {
+        if (has_rule)
+            return rule.getOffset(utc_seconds);
+        return (transitions.empty() ? initial_offset : offsets.back());
+    }
+
+    const auto it = std::upper_bound(transitions.begin(), transitions.end(), utc_seconds);
+    return offsets[it - transitions.begin() - 1];
+}
+
+int64_t TimeZone::RuleDate::getDay(int64_t year) const {
+    const auto new_year = daysFromCivil(year, 1, 1);
+
+    switch (kind) {
+        case JulianNoLeap:
+            // February 29 is never counted.
+            return new_year + day - 1 + (isLeapYear(year) && day >= 60 ? 1 : 0);
+
+        case JulianZeroBased:
+            return new_year + day;
+
+        case MonthWeekDay:
+            break;
+    }
+
+    const auto first_day = daysFromCivil(year, month, 1);
+    auto day_of_month = (day - getDayOfWeek(first_day) + 7) % 7 + (week - 1) * 7;
+    while (day_of_month >= getDaysInMonth(year, month))
+        day_of_month -= 7;
+
+    return first_day + day_of_month;
+}
+
+int64_t TimeZone::Rule::getOffset(int64_t utc_seconds) const {
+    if (!has_dst)
+        return std_offset;
+
+    const auto year = yearFromDays(floorDiv(utc_seconds + std_offset, 86400));
+
+    // The switches happen at the times of the wall clock in effect before them.
+    const auto start = dst_start.getDay(year) * 86400 + dst_start.time - std_offset;
+    const auto end = dst_end.getDay(year) * 86400 + dst_end.time - dst_offset;
+
+    // In the southern hemisphere, the daylight saving time spans the new year.
+    const bool is_dst = (start < end ? (utc_seconds >= start && utc_seconds < end) : (utc_seconds >= start || utc_seconds < end));
+    return (is_dst ? dst_offset : std_offset);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+/// Offsets from UTC of a time zone of the tz database, as the server uses them to show DateTime values in text formats.
+/// Binary formats transfer seconds since the epoch, which are converted with these to the same wall-clock time.
+/// Time zones are read from the TZif files of the system database: TZDIR, or /usr/share/zoneinfo by default.
+/// UTC and its aliases are always available, even where there is no such database.
+class TimeZone {
+public:
+    /// UTC.
+    TimeZone() = default;
+
+    /// The time zone by its name, like "Europe/Moscow", loaded once and then shared.
+    /// Throws std::runtime_error if there is no such time zone in the database.
+    static std::shared_ptr<const TimeZone> get(const std::string & name);
+
+    /// Whether the system database can be read, which it cannot be on Windows, for example. UTC is available regardless.
+    static bool isDatabaseAvailable();
+
+    /// Parse the contents of a TZif file (RFC 8536). Throws std::runtime_error if they are malformed.
+    static TimeZone fromTZif(const std::string & data);
+
+    /// Parse a POSIX TZ string, like "CET-1CEST,M3.5.0,M10.5.0/3". Throws std::runtime_error if it is malformed.
+    static TimeZone fromPosixRule(const std::string & rule);
+
+    bool isUTC() const;
+
+    /// Offset from UTC, in seconds, at the moment 'utc_seconds' after the epoch.
+    int64_t getOffset(int64_t utc_seconds) const;
+
+    /// The wall-clock time at that moment, as seconds after the epoch of the wall clock.
+    int64_t toLocal(int64_t utc_seconds) const {
+        return utc_seconds + getOffset(utc_seconds);
+    }
+
+private:
+    /// A day of the year a POSIX TZ rule switches on.
+    struct RuleDate {
+        enum Kind { JulianNoLeap, JulianZeroBased, MonthWeekDay };
+
+        Kind kind = MonthWeekDay;
+        int64_t day = 0;   // Day of the year for the Julian kinds, day of the week (0 is Sunday) for MonthWeekDay.
+        int64_t week = 0;  // 1 to 5, 5 is the last one of the month.
+        int64_t month = 0;
+        int64_t time = 7200; // Of the wall clock in effect before the switch.
+
+        /// Days since the epoch.
+        int64_t getDay(int64_t year) const;
+    };
+
+    /// Offsets that follow from a POSIX TZ rule, for all the years.
+    struct Rule {
+        int64_t std_offset = 0;
+        int64_t dst_offset = 0;
+        bool has_dst = false;
+        RuleDate dst_start;
+        RuleDate dst_end;
+
+        int64_t getOffset(int64_t utc_seconds) const;
+    };
+
+    static Rule parseRule(const std::string & rule);
+
+private:
+    std::vector<int64_t> transitions; // Sorted moments the offset changes at.
+    std::vector<int64_t> offsets;     // The offset from the corresponding transition on.
+    int64_t initial_offset = 0;       // Before the first transition, or always if there are neither transitions nor a rule.
+    bool has_rule = false;            // From the last transition on, or always if there are none.
+    Rule rule;
+};
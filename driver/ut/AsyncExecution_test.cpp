@@ -0,0 +1,187 @@
+#include <async_executor.h>
+#include <driver.h>
+#include <environment.h>
+#include <connection.h>
+#include <statement.h>
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(AsyncExecution, PollAndComplete)
+{
+    auto & driver = Driver::getInstance();
+    auto & environment = driver.allocateChild<Environment>();
+    auto & connection = environment.allocateChild<Connection>();
+    auto & statement = connection.allocateChild<Statement>();
+    const auto environment_handle = environment.getHandle();
+
+    EXPECT_FALSE(statement.isAsyncEnabled());
+    connection.setAttr(SQL_ATTR_ASYNC_ENABLE, SQL_ASYNC_ENABLE_ON);
+    EXPECT_TRUE(statement.isAsyncEnabled());
+    statement.setAttr(SQL_ATTR_ASYNC_ENABLE, SQL_ASYNC_ENABLE_OFF);
+    EXPECT_FALSE(statement.isAsyncEnabled());
+
+    std::promise<void> response_arrived;
+    auto arrival = response_arrived.get_future().share();
+
+    EXPECT_FALSE(statement.hasAsyncOperation());
+    statement.startAsyncOperation(SQL_API_SQLEXECUTE, [arrival] {
+        arrival.wait();
+        return SQL_SUCCESS_WITH_INFO;
+    });
+
+    EXPECT_TRUE(statement.hasAsyncOperation());
+    EXPECT_EQ(SQL_STILL_EXECUTING, statement.pollAsyncOperation(SQL_API_SQLEXECUTE));
+
+    // Only the function that is executing may be called on the statement.
+    EXPECT_EQ(SQL_ERROR, statement.pollAsyncOperation(SQL_API_SQLFETCH));
+    EXPECT_TRUE(statement.hasAsyncOperation());
+
+    response_arrived.set_value();
+    SQLRETURN rc = SQL_STILL_EXECUTING;
+    while (rc == SQL_STILL_EXECUTING)
+        rc = statement.pollAsyncOperation(SQL_API_SQLEXECUTE);
+
+    EXPECT_EQ(SQL_SUCCESS_WITH_INFO, rc);
+    EXPECT_FALSE(statement.hasAsyncOperation());
+
+    // The statement waits for a pending operation before it is freed.
+    statement.startAsyncOperation(SQL_API_SQLFETCH, [] { return SQL_NO_DATA; });
+    EXPECT_EQ(SQL_NO_DATA, statement.waitForAsyncOperation());
+    statement.startAsyncOperation(SQL_API_SQLFETCH, [] { return SQL_SUCCESS; });
+
+    driver.deallocateChild<Environment>(environment_handle);
+}
+
+TEST(AsyncExecution, Cancel)
+{
+    auto & driver = Driver::getInstance();
+    auto & environment = driver.allocateChild<Environment>();
+    auto & connection = environment.allocateChild<Connection>();
+    auto & statement = connection.allocateChild<Statement>();
+    const auto environment_handle = environment.getHandle();
+
+    // Nothing is executing, nothing to cancel.
+    statement.cancel();
+    EXPECT_EQ(SQL_NO_DATA, statement.fetchRowset(SQL_FETCH_NEXT, 0, 1, nullptr, nullptr));
+
+    std::promise<void> canceled;
+    auto cancellation = canceled.get_future().share();
+    std::string sql_state;
+
+    statement.startAsyncOperation(SQL_API_SQLFETCH, [&statement, &sql_state, cancellation] () -> SQLRETURN {
+        cancellation.wait();
+        try {
+            return statement.fetchRowset(SQL_FETCH_NEXT, 0, 1, nullptr, nullptr);
+        } catch (const SqlException & e) {
+            sql_state = e.getSQLState();
+            return SQL_ERROR;
+        }
+    });
+
+    statement.cancel();
+    canceled.set_value();
+
+    EXPECT_EQ(SQL_ERROR, statement.waitForAsyncOperation());
+    EXPECT_EQ("HY008", sql_state);
+
+    // The cancellation ends with the function it stopped.
+    EXPECT_EQ(SQL_NO_DATA, statement.fetchRowset(SQL_FETCH_NEXT, 0, 1, nullptr, nullptr));
+
+    driver.deallocateChild<Environment>(environment_handle);
+}
+
+TEST(AsyncExecution, OtherFunctionsAreRefused)
+{
+    auto & driver = Driver::getInstance();
+    auto & environment = driver.allocateChild<Environment>();
+    auto & connection = environment.allocateChild<Connection>();
+    auto & statement = connection.allocateChild<Statement>();
+    const auto environment_handle = environment.getHandle();
+    const auto statement_handle = statement.getHandle();
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+
+    // The worker thread itself may call functions on the statement.
+    statement.startAsyncOperation(SQL_API_SQLEXECUTE, [statement_handle, released] {
+        released.wait();
+        return CALL_WITH_HANDLE(statement_handle, [] (Statement &) { return SQL_SUCCESS_WITH_INFO; });
+    });
+
+    const auto call = [&] (bool skip_diag) {
+        return driver.call([] (Statement &) { return SQL_SUCCESS; }, statement_handle, SQL_HANDLE_STMT, skip_diag);
+    };
+
+    // Functions that would fill the diagnostics, which belong to the executing one, are refused.
+    EXPECT_TRUE(statement.isExecutingAsynchronously());
+    EXPECT_EQ(SQL_ERROR, call(false));
+
+    // Polling it, cancelling it, and reading the diagnostics are not.
+    EXPECT_EQ(SQL_SUCCESS, call(true));
+    EXPECT_EQ(SQL_STILL_EXECUTING, statement.pollAsyncOperation(SQL_API_SQLEXECUTE));
+    EXPECT_EQ(SQL_ERROR, statement.pollAsyncOperation(SQL_API_SQLFETCH));
+
+    // Until its result is picked up, even if it has finished.
+    release.set_value();
+    SQLRETURN rc = SQL_STILL_EXECUTING;
+    while (rc == SQL_STILL_EXECUTING) {
+        EXPECT_EQ(SQL_ERROR, call(false));
+        rc = statement.pollAsyncOperation(SQL_API_SQLEXECUTE);
+    }
+
+    EXPECT_EQ(SQL_SUCCESS_WITH_INFO, rc);
+    EXPECT_FALSE(statement.hasAsyncOperation());
+    EXPECT_FALSE(statement.isExecutingAsynchronously());
+    EXPECT_EQ(SQL_SUCCESS, call(false));
+
+    driver.deallocateChild<Environment>(environment_handle);
+}
+
+TEST(AsyncExecution, ThreadsFollowTasksInProgress)
+{
+    AsyncExecutor executor(2, std::chrono::minutes(1));
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+
+    std::vector<std::future<SQLRETURN>> results;
+    for (std::size_t i = 0; i < 4; ++i)
+        results.push_back(executor.submit([released] { released.wait(); return SQL_SUCCESS; }));
+
+    // All of them wait at once, none queued behind the others.
+    EXPECT_EQ(4u, executor.getNumThreads());
+
+    release.set_value();
+    for (auto & result : results)
+        EXPECT_EQ(SQL_SUCCESS, result.get());
+
+    // The idle threads are kept for the tasks that follow, the rest of them exit.
+    while (executor.getNumThreads() > 2 || executor.getNumIdleThreads() < 2)
+        std::this_thread::yield();
+
+    for (std::size_t i = 0; i < 10; ++i) {
+        EXPECT_EQ(SQL_NO_DATA, executor.submit([] { return SQL_NO_DATA; }).get());
+        EXPECT_EQ(2u, executor.getNumThreads());
+
+        while (executor.getNumIdleThreads() < 2)
+            std::this_thread::yield();
+    }
+}
+
+TEST(AsyncExecution, CompletionHandler)
+{
+    AsyncExecutor executor;
+
+    std::promise<void> notified;
+    auto result = executor.submit([] { return SQL_SUCCESS_WITH_INFO; }, [&] { notified.set_value(); });
+
+    // The notified application finds the result there to pick up.
+    notified.get_future().wait();
+    EXPECT_EQ(std::future_status::ready, result.wait_for(std::chrono::seconds(0)));
+    EXPECT_EQ(SQL_SUCCESS_WITH_INFO, result.get());
+}
@@ -0,0 +1,294 @@
+#include <read_helpers.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void writeSize(std::string & out, int32_t size) {
+    out.append(reinterpret_cast<const char *>(&size), sizeof(size));
+}
+
+void writeString(std::string & out, const std::string & value) {
+    writeSize(out, static_cast<int32_t>(value.size()));
+    out.append(value);
+}
+
+void writeNull(std::string & out) {
+    writeSize(out, -1);
+}
+
+} // namespace
+
+TEST(BufferedReader, Empty)
+{
+    std::istringstream in;
+    BufferedReader reader(in);
+
+    EXPECT_TRUE(reader.eof());
+    EXPECT_THROW(reader.readString(), std::runtime_error);
+}
+
+TEST(BufferedReader, ReadValues)
+{
+    std::string data;
+    writeSize(data, 2);
+    writeString(data, "abc");
+    writeNull(data);
+    writeString(data, "");
+
+    std::istringstream in(data);
+    BufferedReader reader(in);
+
+    int32_t size = 0;
+    reader.readSize(size);
+    EXPECT_EQ(2, size);
+
+    bool is_null = true;
+    EXPECT_EQ(std::string("abc"), reader.readString(&is_null).toString());
+    EXPECT_FALSE(is_null);
+
+    reader.readString(&is_null);
+    EXPECT_TRUE(is_null);
+
+    std::string value = "not empty";
+    reader.readString(value, &is_null);
+    EXPECT_FALSE(is_null);
+    EXPECT_EQ(std::string{}, value);
+
+    EXPECT_TRUE(reader.eof());
+}
+
+TEST(BufferedReader, ValuesStraddlingChunks)
+{
+    // Minimal chunk size is 4096, use values of sizes that do not divide it evenly, and some larger than a chunk.
+    std::string data;
+    std::vector<std::string> values;
+    for (std::size_t i = 0; i < 200; ++i) {
+        values.emplace_back(i * 97 % 9000, static_cast<char>('a' + i % 26));
+        writeString(data, values.back());
+    }
+
+    std::istringstream in(data);
+    BufferedReader reader(in, 1);
+    ASSERT_EQ(4096u, reader.getChunkSize());
+
+    for (const auto & value : values) {
+        ASSERT_FALSE(reader.eof());
+        ASSERT_EQ(value, reader.readString().toString());
+    }
+
+    EXPECT_TRUE(reader.eof());
+}
+
+TEST(BufferedReader, IncompleteValue)
+{
+    std::string data;
+    writeSize(data, 10);
+    data += "abc";
+
+    std::istringstream in(data);
+    BufferedReader reader(in);
+
+    EXPECT_FALSE(reader.eof());
+    EXPECT_THROW(reader.readString(), std::runtime_error);
+}
+
+TEST(BufferedReader, HugeBinaryValueSize)
+{
+    // Varint sizes of 2^64 - 1 and of one byte past the limit, neither of which is allocated for.
+    for (const uint64_t size : {~uint64_t(0), uint64_t(BufferedReader::max_value_size) + 1}) {
+        std::string data;
+        for (auto rest = size; ; rest >>= 7) {
+            data += static_cast<char>((rest & 0x7F) | (rest > 0x7F ? 0x80 : 0));
+            if (rest <= 0x7F)
+                break;
+        }
+        data += "abc";
+
+        std::istringstream in(data);
+        BufferedReader reader(in);
+
+        try {
+            reader.readBinaryString();
+            FAIL();
+        } catch (const std::runtime_error & e) {
+            EXPECT_EQ("Invalid value size received: " + std::to_string(size) + ".", std::string(e.what()));
+        }
+    }
+}
+
+namespace {
+
+/// Hands out the data a few bytes at a time, as a socket would, and counts the reads that
+/// would have had to wait for data the server has not sent yet.
+class TricklingStreamBuf
+    : public std::streambuf
+{
+public:
+    explicit TricklingStreamBuf(std::string data_)
+        : data(std::move(data_))
+    {
+    }
+
+    void setArrived(std::size_t size) {
+        arrived = size;
+    }
+
+    std::size_t getNumWaits() const {
+        return num_waits;
+    }
+
+protected:
+    int_type underflow() override {
+        if (pos >= data.size())
+            return traits_type::eof();
+
+        if (pos >= arrived)
+            ++num_waits;
+
+        const auto size = std::min<std::size_t>(7, data.size() - pos);
+        setg(&data[pos], &data[pos], &data[pos] + size);
+        pos += size;
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    std::string data;
+    std::size_t pos = 0;
+    std::size_t arrived = 0;
+    std::size_t num_waits = 0;
+};
+
+/// Serves the data in pieces, each of them after a delay.
+class SlowStreamBuf
+    : public std::streambuf
+{
+public:
+    SlowStreamBuf(std::string data_, std::chrono::milliseconds delay_)
+        : data(std::move(data_))
+        , delay(delay_)
+    {
+    }
+
+protected:
+    int_type underflow() override {
+        if (pos >= data.size())
+            return traits_type::eof();
+
+        std::this_thread::sleep_for(delay);
+
+        const auto size = std::min<std::size_t>(1000, data.size() - pos);
+        setg(&data[pos], &data[pos], &data[pos] + size);
+        pos += size;
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    std::string data;
+    const std::chrono::milliseconds delay;
+    std::size_t pos = 0;
+};
+
+} // namespace
+
+TEST(DrainStream, SmallRestIsDrained)
+{
+    std::istringstream in(std::string(100000, 'x'));
+    in.ignore(10);
+
+    std::size_t drained = 0;
+    std::vector<std::chrono::microseconds> read_timeouts;
+    EXPECT_TRUE(drainStream(in, 1 << 20, std::chrono::steady_clock::now() + std::chrono::seconds(10), drained,
+        [&] (std::chrono::microseconds time_left) { read_timeouts.push_back(time_left); }));
+    EXPECT_EQ(99990u, drained);
+
+    // Each read waits for no longer than the time left.
+    ASSERT_FALSE(read_timeouts.empty());
+    for (const auto time_left : read_timeouts) {
+        EXPECT_LE(time_left, std::chrono::seconds(10));
+        EXPECT_GT(time_left, std::chrono::seconds(0));
+    }
+}
+
+TEST(DrainStream, ReadToTheEndIsFinished)
+{
+    // Nothing left, but the end has not been seen yet.
+    std::istringstream in("abc");
+    in.ignore(3);
+    ASSERT_FALSE(in.eof());
+
+    std::size_t drained = 1;
+    EXPECT_TRUE(drainStream(in, 1 << 20, std::chrono::steady_clock::now() + std::chrono::seconds(10), drained));
+    EXPECT_EQ(0u, drained);
+
+    // Also when the deadline has passed already.
+    std::istringstream late("abc");
+    EXPECT_TRUE(drainStream(late, 1 << 20, std::chrono::steady_clock::now() - std::chrono::seconds(1), drained));
+    EXPECT_EQ(3u, drained);
+}
+
+TEST(DrainStream, LargeRestIsNotDrained)
+{
+    // Left for the query to be killed instead.
+    std::istringstream in(std::string(4 << 20, 'x'));
+
+    std::size_t drained = 0;
+    EXPECT_FALSE(drainStream(in, 1 << 20, std::chrono::steady_clock::now() + std::chrono::seconds(10), drained));
+    EXPECT_GT(drained, 1u << 20);
+    EXPECT_LT(drained, 2u << 20);
+}
+
+TEST(DrainStream, SlowRestIsNotDrained)
+{
+    // Every piece arrives within a timeout of a single read, but all of them take longer than the deadline.
+    SlowStreamBuf source(std::string(100000, 'x'), std::chrono::milliseconds(10));
+    std::istream in(&source);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t drained = 0;
+    EXPECT_FALSE(drainStream(in, 1 << 20, start + std::chrono::milliseconds(50), drained));
+    EXPECT_LT(drained, 100000u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+}
+
+TEST(DrainStream, ErrorIsNotFinished)
+{
+    std::istringstream in("abc");
+    in.setstate(std::ios::badbit);
+
+    std::size_t drained = 0;
+    EXPECT_FALSE(drainStream(in, 1 << 20, std::chrono::steady_clock::now() + std::chrono::seconds(10), drained));
+}
+
+TEST(BufferedReader, DoesNotWaitForMoreThanNeeded)
+{
+    std::string data;
+    writeString(data, "first value");
+    const auto first_size = data.size();
+    writeString(data, std::string(100000, 'x'));
+
+    TricklingStreamBuf source(data);
+    std::istream in(&source);
+    BufferedReader reader(in);
+
+    // Only the first value has arrived so far, and it can be read without waiting for the rest of the chunk.
+    source.setArrived(first_size);
+    ASSERT_FALSE(reader.eof());
+    EXPECT_EQ("first value", reader.readString().toString());
+    EXPECT_EQ(0u, source.getNumWaits());
+
+    source.setArrived(data.size());
+    ASSERT_FALSE(reader.eof());
+    EXPECT_EQ(std::string(100000, 'x'), reader.readString().toString());
+    EXPECT_TRUE(reader.eof());
+    EXPECT_EQ(0u, source.getNumWaits());
+}
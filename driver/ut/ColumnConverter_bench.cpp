@@ -0,0 +1,141 @@
+// Measures the per-value cost of converting fetched values to bound C buffers:
+// dispatching on the C type for every value (as SQLFetch used to do through SQLGetData),
+// versus running converters chosen once per column. Also compares parsing doubles with 17 significant digits,
+// as the server sends them, to std::strtod().
+//
+// Usage: clickhouse-odbc-bench [rows]
+
+#include <column_converter.h>
+#include <number_parser.h>
+#include <utils.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+RETCODE convertBySwitch(const Field & field, SQLSMALLINT target_type, PTR out_value, SQLLEN out_value_max_size, SQLLEN * out_value_size_or_indicator) {
+    if (field.isBinaryOfCType(target_type)) {
+        if (out_value_size_or_indicator)
+            *out_value_size_or_indicator = field.size();
+        if (out_value)
+            memcpy(out_value, field.data(), field.size());
+        return SQL_SUCCESS;
+    }
+
+    switch (target_type) {
+        case SQL_C_CHAR:
+            if (field.isText())
+                return fillOutputRawString(field, out_value, out_value_max_size, out_value_size_or_indicator);
+            return fillOutputRawString(field.toString(), out_value, out_value_max_size, out_value_size_or_indicator);
+        case SQL_C_SLONG:
+            return fillOutputNumber<int32_t>(field.getInt(), out_value, out_value_max_size, out_value_size_or_indicator);
+        case SQL_C_SBIGINT:
+            return fillOutputNumber<int64_t>(field.getInt(), out_value, out_value_max_size, out_value_size_or_indicator);
+        case SQL_C_DOUBLE:
+            return fillOutputNumber<double>(field.getDouble(), out_value, out_value_max_size, out_value_size_or_indicator);
+        default:
+            throw std::runtime_error("Unknown type requested.");
+    }
+}
+
+struct BenchColumn {
+    const char * name;
+    ValueEncoding encoding;
+    SQLSMALLINT target_type;
+};
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    const std::size_t num_rows = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000);
+
+    const std::vector<BenchColumn> columns = {
+        {"Int32 -> SQL_C_SLONG", ValueEncoding::Int32, SQL_C_SLONG},
+        {"UInt16 -> SQL_C_SBIGINT", ValueEncoding::UInt16, SQL_C_SBIGINT},
+        {"Float64 -> SQL_C_DOUBLE", ValueEncoding::Float64, SQL_C_DOUBLE},
+        {"Text -> SQL_C_CHAR", ValueEncoding::Text, SQL_C_CHAR},
+        {"Text -> SQL_C_SLONG", ValueEncoding::Text, SQL_C_SLONG},
+        {"Text (17 digits) -> SQL_C_DOUBLE", ValueEncoding::Text, SQL_C_DOUBLE},
+    };
+
+    std::vector<ColumnInfo> columns_info(columns.size());
+    for (std::size_t i = 0; i < columns.size(); ++i)
+        columns_info[i].encoding = columns[i].encoding;
+
+    ColumnBatch batch;
+    batch.clear(columns_info);
+
+    std::vector<std::string> long_doubles;
+    long_doubles.reserve(num_rows);
+
+    for (std::size_t row = 0; row < num_rows; ++row) {
+        const int32_t i32 = static_cast<int32_t>(row);
+        const uint16_t u16 = static_cast<uint16_t>(row);
+        const double f64 = row * 0.5;
+        const auto text = std::to_string(row);
+
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.17g", (row + 1) / 3.0);
+        long_doubles.emplace_back(buf);
+
+        batch.appendValue(0, reinterpret_cast<const char *>(&i32), sizeof(i32), false);
+        batch.appendValue(1, reinterpret_cast<const char *>(&u16), sizeof(u16), false);
+        batch.appendValue(2, reinterpret_cast<const char *>(&f64), sizeof(f64), false);
+        batch.appendValue(3, text.data(), text.size(), false);
+        batch.appendValue(4, text.data(), text.size(), false);
+        batch.appendValue(5, long_doubles.back().data(), long_doubles.back().size(), false);
+        batch.finishRow();
+    }
+
+    char out[64] = {};
+    SQLLEN indicator = 0;
+
+    for (std::size_t col = 0; col < columns.size(); ++col) {
+        const auto target_type = columns[col].target_type;
+
+        const auto before_start = std::chrono::steady_clock::now();
+        for (std::size_t row = 0; row < num_rows; ++row)
+            convertBySwitch(batch.getField(row, col), target_type, out, sizeof(out), &indicator);
+        const auto before_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - before_start).count();
+
+        const auto converter = getColumnConverter(columns[col].encoding, target_type);
+        const auto after_start = std::chrono::steady_clock::now();
+        for (std::size_t row = 0; row < num_rows; ++row)
+            converter(batch.getField(row, col), out, sizeof(out), &indicator);
+        const auto after_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - after_start).count();
+
+        std::cout << columns[col].name << ": "
+                  << "per-value dispatch " << before_ns / num_rows << " ns/value, "
+                  << "converter " << after_ns / num_rows << " ns/value" << std::endl;
+    }
+
+    // Summed in the same order, so that equal results give equal sums.
+    double parsed_sum = 0;
+    double strtod_sum = 0;
+
+    const auto parse_start = std::chrono::steady_clock::now();
+    for (const auto & text : long_doubles) {
+        double value = 0;
+        parseNumber(text.data(), text.size(), value);
+        parsed_sum += value;
+    }
+    const auto parse_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - parse_start).count();
+
+    const auto strtod_start = std::chrono::steady_clock::now();
+    for (const auto & text : long_doubles)
+        strtod_sum += std::strtod(text.c_str(), nullptr);
+    const auto strtod_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - strtod_start).count();
+
+    std::cout << "Text (17 digits) -> double: "
+              << "parseNumber " << parse_ns / num_rows << " ns/value, "
+              << "strtod " << strtod_ns / num_rows << " ns/value"
+              << (parsed_sum == strtod_sum ? "" : " (results differ)") << std::endl;
+
+    return 0;
+}
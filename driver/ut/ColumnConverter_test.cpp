@@ -0,0 +1,210 @@
+#include <column_converter.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace {
+
+template <typename T>
+Field binaryField(const T & value, ValueEncoding encoding) {
+    return Field{reinterpret_cast<const char *>(&value), sizeof(value), false, encoding};
+}
+
+Field textField(const std::string & value) {
+    return Field{value.c_str(), value.size(), false};
+}
+
+} // namespace
+
+TEST(ColumnConverter, BinaryToSameType)
+{
+    const int32_t value = -123456;
+    int32_t out = 0;
+    SQLLEN indicator = 0;
+
+    const auto converter = getColumnConverter(ValueEncoding::Int32, SQL_C_SLONG);
+    EXPECT_EQ(SQL_SUCCESS, converter(binaryField(value, ValueEncoding::Int32), &out, 0, &indicator));
+    EXPECT_EQ(value, out);
+    EXPECT_EQ(static_cast<SQLLEN>(sizeof(out)), indicator);
+}
+
+TEST(ColumnConverter, BinaryToOtherType)
+{
+    const uint16_t value = 65000;
+    SQLLEN indicator = 0;
+
+    int64_t out_int = 0;
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::UInt16, SQL_C_SBIGINT)(binaryField(value, ValueEncoding::UInt16), &out_int, 0, &indicator));
+    EXPECT_EQ(65000, out_int);
+    EXPECT_EQ(static_cast<SQLLEN>(sizeof(out_int)), indicator);
+
+    double out_double = 0;
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::UInt16, SQL_C_DOUBLE)(binaryField(value, ValueEncoding::UInt16), &out_double, 0, &indicator));
+    EXPECT_EQ(65000.0, out_double);
+
+    const float float_value = 2.5f;
+    int32_t out_int32 = 0;
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Float32, SQL_C_SLONG)(binaryField(float_value, ValueEncoding::Float32), &out_int32, 0, &indicator));
+    EXPECT_EQ(2, out_int32);
+}
+
+TEST(ColumnConverter, TextToNumber)
+{
+    SQLLEN indicator = 0;
+
+    int16_t out_short = 0;
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_SSHORT)(textField("-42"), &out_short, 0, &indicator));
+    EXPECT_EQ(-42, out_short);
+
+    double out_double = 0;
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_DOUBLE)(textField("0.25"), &out_double, 0, &indicator));
+    EXPECT_EQ(0.25, out_double);
+
+    int32_t out_int = 0;
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_SLONG)(textField("12.9"), &out_int, 0, &indicator));
+    EXPECT_EQ(12, out_int);
+
+    // Reported by the return code, not by an exception.
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Text, SQL_C_SLONG)(textField("abc"), &out_int, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Text, SQL_C_UBIGINT)(textField("18446744073709551616"), &out_int, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Text, SQL_C_DOUBLE)(textField("1.5x"), &out_double, 0, &indicator));
+}
+
+TEST(ColumnConverter, OutOfRange)
+{
+    SQLLEN indicator = 0;
+    int64_t out_int64 = 0;
+    uint64_t out_uint64 = 0;
+    int8_t out_int8 = 0;
+    uint8_t out_uint8 = 0;
+    float out_float = 0;
+
+    // Values that the C type can not hold are not cast into it.
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Float64, SQL_C_SBIGINT)(binaryField(nan, ValueEncoding::Float64), &out_int64, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Float64, SQL_C_SBIGINT)(binaryField(1e300, ValueEncoding::Float64), &out_int64, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Float64, SQL_C_FLOAT)(binaryField(1e300, ValueEncoding::Float64), &out_float, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Int64, SQL_C_UBIGINT)(binaryField(int64_t(-1), ValueEncoding::Int64), &out_uint64, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::UInt64, SQL_C_SBIGINT)(binaryField(uint64_t(1) << 63, ValueEncoding::UInt64), &out_int64, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Int16, SQL_C_TINYINT)(binaryField(int16_t(128), ValueEncoding::Int16), &out_int8, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Text, SQL_C_TINYINT)(textField("300"), &out_int8, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Text, SQL_C_UTINYINT)(textField("-1"), &out_uint8, 0, &indicator));
+    EXPECT_EQ(0, out_int64);
+    EXPECT_EQ(0u, out_uint64);
+    EXPECT_EQ(0, out_int8);
+
+    // The bounds themselves fit, and fractions are truncated towards zero.
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Int16, SQL_C_TINYINT)(binaryField(int16_t(-128), ValueEncoding::Int16), &out_int8, 0, &indicator));
+    EXPECT_EQ(-128, out_int8);
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Float64, SQL_C_UTINYINT)(binaryField(255.9, ValueEncoding::Float64), &out_uint8, 0, &indicator));
+    EXPECT_EQ(255, out_uint8);
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Float64, SQL_C_UTINYINT)(binaryField(-0.5, ValueEncoding::Float64), &out_uint8, 0, &indicator));
+    EXPECT_EQ(0, out_uint8);
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Float64, SQL_C_SBIGINT)(binaryField(-9223372036854775808.0, ValueEncoding::Float64), &out_int64, 0, &indicator));
+    EXPECT_EQ(std::numeric_limits<int64_t>::min(), out_int64);
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Float64, SQL_C_SBIGINT)(binaryField(9223372036854775808.0, ValueEncoding::Float64), &out_int64, 0, &indicator));
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Int64, SQL_C_UBIGINT)(binaryField(int64_t(0), ValueEncoding::Int64), &out_uint64, 0, &indicator));
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_UTINYINT)(textField("255"), &out_uint8, 0, &indicator));
+    EXPECT_EQ(255, out_uint8);
+}
+
+TEST(ColumnConverter, ConversionErrors)
+{
+    DiagnosticsContainer diagnostics;
+
+    const auto sql_state = [&] (const Field & field, SQLSMALLINT target_type) {
+        diagnostics.resetDiag();
+        EXPECT_EQ(SQL_ERROR, fillConversionError(diagnostics, field, target_type));
+        return diagnostics.getDiagStatus(1).getAttrAs<std::string>(SQL_DIAG_SQLSTATE);
+    };
+
+    EXPECT_EQ("22003", sql_state(textField("300"), SQL_C_TINYINT));
+    EXPECT_EQ("22003", sql_state(textField("18446744073709551616"), SQL_C_UBIGINT));
+    EXPECT_EQ("22003", sql_state(binaryField(int64_t(-1), ValueEncoding::Int64), SQL_C_UBIGINT));
+    EXPECT_EQ("22003", sql_state(binaryField(std::numeric_limits<double>::quiet_NaN(), ValueEncoding::Float64), SQL_C_SLONG));
+    EXPECT_EQ("22018", sql_state(textField("abc"), SQL_C_SLONG));
+    EXPECT_EQ("22018", sql_state(textField("1.5x"), SQL_C_DOUBLE));
+    EXPECT_EQ("22018", sql_state(textField("yesterday"), SQL_C_TYPE_DATE));
+}
+
+TEST(ColumnConverter, ToString)
+{
+    SQLLEN indicator = 0;
+    char out[16] = {};
+
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_CHAR)(textField("hello"), out, sizeof(out), &indicator));
+    EXPECT_EQ(std::string("hello"), out);
+    EXPECT_EQ(5, indicator);
+
+    const uint32_t value = 4000000000u;
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::UInt32, SQL_C_CHAR)(binaryField(value, ValueEncoding::UInt32), out, sizeof(out), &indicator));
+    EXPECT_EQ(std::string("4000000000"), out);
+    EXPECT_EQ(10, indicator);
+
+    EXPECT_EQ(SQL_SUCCESS_WITH_INFO, getColumnConverter(ValueEncoding::Text, SQL_C_CHAR)(textField("hello"), out, 3, &indicator));
+    EXPECT_EQ(std::string("he"), out);
+    EXPECT_EQ(5, indicator);
+}
+
+TEST(ColumnConverter, DateTime)
+{
+    SQLLEN indicator = 0;
+
+    const uint16_t days = 18000; // 2019-04-14
+    SQL_DATE_STRUCT date = {};
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Date, SQL_C_TYPE_DATE)(binaryField(days, ValueEncoding::Date), &date, 0, &indicator));
+    EXPECT_EQ(2019, date.year);
+    EXPECT_EQ(4, date.month);
+    EXPECT_EQ(14, date.day);
+
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_TYPE_DATE)(textField("2019-04-14"), &date, 0, &indicator));
+    EXPECT_EQ(2019, date.year);
+    EXPECT_EQ(4, date.month);
+    EXPECT_EQ(14, date.day);
+
+    const int64_t seconds = 18000 * 86400 + 3600 + 120 + 3;
+    SQL_TIMESTAMP_STRUCT timestamp = {};
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::DateTime, SQL_C_TYPE_TIMESTAMP)(binaryField(seconds, ValueEncoding::DateTime), &timestamp, 0, &indicator));
+    EXPECT_EQ(2019, timestamp.year);
+    EXPECT_EQ(1, timestamp.hour);
+    EXPECT_EQ(2, timestamp.minute);
+    EXPECT_EQ(3, timestamp.second);
+    EXPECT_EQ(static_cast<SQLLEN>(sizeof(timestamp)), indicator);
+}
+
+TEST(ColumnConverter, TextToDateTime)
+{
+    SQLLEN indicator = 0;
+    SQL_TIMESTAMP_STRUCT timestamp = {};
+
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_TYPE_TIMESTAMP)(textField("2019-04-14 01:02:03.25"), &timestamp, 0, &indicator));
+    EXPECT_EQ(2019, timestamp.year);
+    EXPECT_EQ(3, timestamp.second);
+    EXPECT_EQ(250000000u, timestamp.fraction);
+
+    SQL_DATE_STRUCT date = {};
+    EXPECT_EQ(SQL_SUCCESS, getColumnConverter(ValueEncoding::Text, SQL_C_TYPE_DATE)(textField("2019-04-14 01:02:03.25"), &date, 0, &indicator));
+    EXPECT_EQ(14, date.day);
+
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Text, SQL_C_TYPE_TIMESTAMP)(textField("2019-04-31 00:00:00"), &timestamp, 0, &indicator));
+    EXPECT_EQ(SQL_ERROR, getColumnConverter(ValueEncoding::Text, SQL_C_TYPE_DATE)(textField("yesterday"), &date, 0, &indicator));
+}
+
+TEST(ColumnConverter, BoundElementSize)
+{
+    EXPECT_EQ(sizeof(SQLINTEGER), getBoundElementSize(SQL_C_SLONG, 100));
+    EXPECT_EQ(sizeof(SQLDOUBLE), getBoundElementSize(SQL_C_DOUBLE, 0));
+    EXPECT_EQ(sizeof(SQL_TIMESTAMP_STRUCT), getBoundElementSize(SQL_C_TYPE_TIMESTAMP, 3));
+    EXPECT_EQ(100, getBoundElementSize(SQL_C_CHAR, 100));
+    EXPECT_EQ(64, getBoundElementSize(SQL_C_WCHAR, 64));
+}
+
+TEST(ColumnConverter, UnsupportedType)
+{
+    EXPECT_THROW(getColumnConverter(ValueEncoding::Text, SQL_C_DEFAULT), std::runtime_error);
+    EXPECT_THROW(getColumnConverter(ValueEncoding::Int32, SQL_ARD_TYPE), std::runtime_error);
+    EXPECT_THROW(getColumnConverter(ValueEncoding::Int32, 12345), std::runtime_error);
+}
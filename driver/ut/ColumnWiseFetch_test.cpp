@@ -0,0 +1,176 @@
+#include <driver.h>
+#include <environment.h>
+#include <connection.h>
+#include <statement.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+class RowBinaryWriter {
+public:
+    template <typename T>
+    void write(T value) {
+        data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void writeString(const std::string & value) {
+        data += static_cast<char>(value.size());
+        data += value;
+    }
+
+    void writeHeader(const std::vector<std::string> & names, const std::vector<std::string> & types) {
+        data += static_cast<char>(names.size());
+        for (const auto & name : names)
+            writeString(name);
+        for (const auto & type : types)
+            writeString(type);
+    }
+
+    std::string data;
+};
+
+class ColumnWiseFetch
+    : public ::testing::Test
+{
+protected:
+    virtual void SetUp() override {
+        auto & environment = Driver::getInstance().allocateChild<Environment>();
+        environment_handle = environment.getHandle();
+        connection = &environment.allocateChild<Connection>();
+        statement = &connection->allocateChild<Statement>();
+    }
+
+    virtual void TearDown() override {
+        Driver::getInstance().deallocateChild<Environment>(environment_handle);
+    }
+
+    /// Make the result set of (id UInt32, half Float64, maybe_id Nullable(UInt32), wide_id UInt32) current, where ids are
+    /// the 0-based numbers of the rows, and every 'null_period'th 'maybe_id' is NULL.
+    void open(std::size_t num_rows, std::size_t null_period) {
+        RowBinaryWriter writer;
+        writer.writeHeader({"id", "half", "maybe_id", "wide_id"}, {"UInt32", "Float64", "Nullable(UInt32)", "UInt32"});
+
+        for (std::size_t id = 0; id < num_rows; ++id) {
+            writer.write<uint32_t>(static_cast<uint32_t>(id));
+            writer.write<double>(id * 0.5);
+            if (id % null_period == 0) {
+                writer.write<uint8_t>(1);
+            } else {
+                writer.write<uint8_t>(0);
+                writer.write<uint32_t>(static_cast<uint32_t>(id));
+            }
+            writer.write<uint32_t>(static_cast<uint32_t>(id));
+        }
+
+        in.str(writer.data);
+        statement->setResultSet(std::make_unique<RowBinaryWithNamesAndTypesResultSet>(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, ""));
+    }
+
+    /// Bind the columns column-wise: 'id' and 'half' as the C types they are stored as, so that they are copied at once,
+    /// 'maybe_id' as well, and 'wide_id' as a wider C type, so that it is converted value by value.
+    void bind(std::size_t rowset_size) {
+        ids.assign(rowset_size, 0);
+        halves.assign(rowset_size, 0);
+        maybe_ids.assign(rowset_size, 0);
+        wide_ids.assign(rowset_size, 0);
+
+        id_indicators.assign(rowset_size, 0);
+        half_indicators.assign(rowset_size, 0);
+        maybe_id_indicators.assign(rowset_size, 0);
+        wide_id_indicators.assign(rowset_size, 0);
+
+        statement->bindings[1] = BindingInfo{SQL_C_ULONG, ids.data(), sizeof(SQLUINTEGER), id_indicators.data(), id_indicators.data()};
+        statement->bindings[2] = BindingInfo{SQL_C_DOUBLE, halves.data(), sizeof(SQLDOUBLE), half_indicators.data(), half_indicators.data()};
+        statement->bindings[3] = BindingInfo{SQL_C_ULONG, maybe_ids.data(), sizeof(SQLUINTEGER), maybe_id_indicators.data(), maybe_id_indicators.data()};
+        statement->bindings[4] = BindingInfo{SQL_C_SBIGINT, wide_ids.data(), sizeof(SQLBIGINT), wide_id_indicators.data(), wide_id_indicators.data()};
+        statement->invalidateFetchPlan();
+    }
+
+    /// Fetch all the rows rowset by rowset, and check the bound arrays, returning the number of rows fetched.
+    std::size_t fetchAll(std::size_t rowset_size, std::size_t null_period) {
+        std::size_t next_id = 0;
+
+        while (true) {
+            SQLULEN rows_fetched = 0;
+            std::vector<SQLUSMALLINT> row_statuses(rowset_size, SQL_ROW_ERROR);
+            const auto rc = statement->fetchRowset(SQL_FETCH_NEXT, 0, rowset_size, &rows_fetched, row_statuses.data());
+
+            if (rc == SQL_NO_DATA)
+                break;
+
+            EXPECT_EQ(SQL_SUCCESS, rc);
+            EXPECT_LE(1u, rows_fetched);
+            EXPECT_GE(rowset_size, rows_fetched);
+
+            for (std::size_t i = 0; i < rows_fetched; ++i, ++next_id) {
+                EXPECT_EQ(SQL_ROW_SUCCESS, row_statuses[i]);
+
+                EXPECT_EQ(next_id, ids[i]);
+                EXPECT_EQ(static_cast<SQLLEN>(sizeof(SQLUINTEGER)), id_indicators[i]);
+
+                EXPECT_EQ(next_id * 0.5, halves[i]);
+                EXPECT_EQ(static_cast<SQLLEN>(sizeof(SQLDOUBLE)), half_indicators[i]);
+
+                if (next_id % null_period == 0) {
+                    EXPECT_EQ(SQL_NULL_DATA, maybe_id_indicators[i]);
+                } else {
+                    EXPECT_EQ(next_id, maybe_ids[i]);
+                    EXPECT_EQ(static_cast<SQLLEN>(sizeof(SQLUINTEGER)), maybe_id_indicators[i]);
+                }
+
+                EXPECT_EQ(static_cast<SQLBIGINT>(next_id), wide_ids[i]);
+                EXPECT_EQ(static_cast<SQLLEN>(sizeof(SQLBIGINT)), wide_id_indicators[i]);
+            }
+        }
+
+        return next_id;
+    }
+
+    SQLHANDLE environment_handle = nullptr;
+    Connection * connection = nullptr;
+    Statement * statement = nullptr;
+    std::istringstream in;
+
+    std::vector<SQLUINTEGER> ids;
+    std::vector<SQLDOUBLE> halves;
+    std::vector<SQLUINTEGER> maybe_ids;
+    std::vector<SQLBIGINT> wide_ids;
+
+    std::vector<SQLLEN> id_indicators;
+    std::vector<SQLLEN> half_indicators;
+    std::vector<SQLLEN> maybe_id_indicators;
+    std::vector<SQLLEN> wide_id_indicators;
+};
+
+} // namespace
+
+TEST_F(ColumnWiseFetch, ManyRowsets) {
+    open(250, 1000);
+    bind(32);
+    EXPECT_EQ(250u, fetchAll(32, 1000));
+}
+
+TEST_F(ColumnWiseFetch, WithNulls) {
+    // Rowsets with NULLs in 'maybe_id' are converted value by value, the others are copied at once.
+    open(250, 100);
+    bind(32);
+    EXPECT_EQ(250u, fetchAll(32, 100));
+}
+
+TEST_F(ColumnWiseFetch, SingleRowRowsets) {
+    open(10, 3);
+    bind(1);
+    EXPECT_EQ(10u, fetchAll(1, 3));
+}
+
+TEST_F(ColumnWiseFetch, WholeResultSetInOneRowset) {
+    open(300, 7);
+    bind(500);
+    EXPECT_EQ(300u, fetchAll(500, 7));
+}
@@ -0,0 +1,151 @@
+#include <driver.h>
+#include <environment.h>
+#include <connection.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using SessionPtr = std::unique_ptr<Poco::Net::HTTPClientSession>;
+
+/// Sessions created in the tests never connect, so their health is decided by the tests.
+bool alwaysHealthy(Poco::Net::HTTPClientSession &) {
+    return true;
+}
+
+class ConnectionSessions
+    : public ::testing::Test
+{
+protected:
+    virtual void SetUp() override {
+        auto & environment = Driver::getInstance().allocateChild<Environment>();
+        environment_handle = environment.getHandle();
+        connection = &environment.allocateChild<Connection>();
+        connection->init("SERVER=localhost;PORT=8123");
+        connection->is_session_healthy = alwaysHealthy;
+    }
+
+    virtual void TearDown() override {
+        Driver::getInstance().deallocateChild<Environment>(environment_handle);
+    }
+
+    SQLHANDLE environment_handle = nullptr;
+    Connection * connection = nullptr;
+};
+
+} // namespace
+
+TEST_F(ConnectionSessions, Lease) {
+    auto first = connection->acquireSession();
+    auto second = connection->acquireSession();
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    EXPECT_NE(first.get(), second.get());
+
+    const auto * first_ptr = first.get();
+    const auto * second_ptr = second.get();
+
+    // The most recently released session is the most likely to be still alive on the server.
+    connection->releaseSession(std::move(first));
+    connection->releaseSession(std::move(second));
+
+    first = connection->acquireSession();
+    second = connection->acquireSession();
+    EXPECT_EQ(second_ptr, first.get());
+    EXPECT_EQ(first_ptr, second.get());
+
+    auto third = connection->acquireSession();
+    ASSERT_NE(nullptr, third);
+    EXPECT_NE(first_ptr, third.get());
+    EXPECT_NE(second_ptr, third.get());
+
+    connection->releaseSession(std::move(first));
+    connection->releaseSession(std::move(second));
+    connection->releaseSession(std::move(third));
+}
+
+TEST_F(ConnectionSessions, UnhealthyIdleSessionsAreClosed) {
+    auto alive = connection->acquireSession();
+    auto closed = connection->acquireSession();
+    const auto * alive_ptr = alive.get();
+    const auto * closed_ptr = closed.get();
+
+    connection->releaseSession(std::move(alive));
+    connection->releaseSession(std::move(closed));
+
+    connection->is_session_healthy = [closed_ptr] (Poco::Net::HTTPClientSession & session) {
+        return (&session != closed_ptr);
+    };
+
+    // The session released last is skipped, and closed, since the server has closed its connection.
+    auto session = connection->acquireSession();
+    EXPECT_EQ(alive_ptr, session.get());
+
+    auto other_session = connection->acquireSession();
+    ASSERT_NE(nullptr, other_session);
+    EXPECT_NE(alive_ptr, other_session.get());
+
+    connection->releaseSession(std::move(session));
+    connection->releaseSession(std::move(other_session));
+}
+
+TEST_F(ConnectionSessions, InterleavedStatements) {
+    // Statements lease sessions as they send their requests, and return them as they finish reading the responses,
+    // so a session released by one statement is reused by the next one while others are still reading.
+    auto first = connection->acquireSession();
+    auto second = connection->acquireSession();
+    const auto * first_ptr = first.get();
+
+    connection->releaseSession(std::move(first));
+
+    auto third = connection->acquireSession();
+    EXPECT_EQ(first_ptr, third.get());
+    EXPECT_NE(second.get(), third.get());
+
+    connection->releaseSession(std::move(second));
+    connection->releaseSession(std::move(third));
+}
+
+TEST_F(ConnectionSessions, ConcurrentStatements) {
+    const std::size_t num_threads = 8;
+    const std::size_t num_requests = 500;
+
+    std::mutex mutex;
+    std::set<const Poco::Net::HTTPClientSession *> leased_sessions;
+    bool shared = false;
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&] {
+            for (std::size_t j = 0; j < num_requests; ++j) {
+                auto session = connection->acquireSession();
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shared = (!leased_sessions.insert(session.get()).second || shared);
+                }
+
+                std::this_thread::yield();
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    leased_sessions.erase(session.get());
+                }
+
+                connection->releaseSession(std::move(session));
+            }
+        });
+    }
+
+    for (auto & thread : threads)
+        thread.join();
+
+    // A session is never leased to two statements at the same time.
+    EXPECT_FALSE(shared);
+}
@@ -0,0 +1,103 @@
+#include <date_time_parser.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+template <typename T>
+ParseStatus parse(const std::string & text, T & res);
+
+template <>
+ParseStatus parse(const std::string & text, SQL_DATE_STRUCT & res) {
+    return parseDate(text.data(), text.size(), res);
+}
+
+template <>
+ParseStatus parse(const std::string & text, SQL_TIMESTAMP_STRUCT & res) {
+    return parseDateTime(text.data(), text.size(), res);
+}
+
+} // namespace
+
+TEST(DateTimeParser, Date)
+{
+    SQL_DATE_STRUCT res = {};
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2019-04-14", res));
+    EXPECT_EQ(2019, res.year);
+    EXPECT_EQ(4, res.month);
+    EXPECT_EQ(14, res.day);
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2020-02-29 23:59:59", res));
+    EXPECT_EQ(2020, res.year);
+    EXPECT_EQ(2, res.month);
+    EXPECT_EQ(29, res.day);
+
+    ASSERT_EQ(ParseStatus::Ok, parse("0000-00-00", res));
+    EXPECT_EQ(1970, res.year);
+    EXPECT_EQ(1, res.month);
+    EXPECT_EQ(1, res.day);
+
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("2019-13-01", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("2019-02-29", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("2019-04-00", res));
+
+    EXPECT_EQ(ParseStatus::Invalid, parse("", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-4-14", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019/04/14", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-1x", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("20x9-04-14", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 ", res));
+}
+
+TEST(DateTimeParser, DateTime)
+{
+    SQL_TIMESTAMP_STRUCT res = {};
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2019-04-14 01:02:03", res));
+    EXPECT_EQ(2019, res.year);
+    EXPECT_EQ(4, res.month);
+    EXPECT_EQ(14, res.day);
+    EXPECT_EQ(1, res.hour);
+    EXPECT_EQ(2, res.minute);
+    EXPECT_EQ(3, res.second);
+    EXPECT_EQ(0u, res.fraction);
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2019-04-14", res));
+    EXPECT_EQ(14, res.day);
+    EXPECT_EQ(0, res.hour);
+
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("2019-04-14 24:00:00", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("2019-04-14 23:60:00", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("2019-04-14 23:59:60", res));
+
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14T01:02:03", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 01-02-03", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 01:02:0x", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 01:02", res));
+}
+
+TEST(DateTimeParser, DateTime64)
+{
+    SQL_TIMESTAMP_STRUCT res = {};
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2019-04-14 01:02:03.5", res));
+    EXPECT_EQ(3, res.second);
+    EXPECT_EQ(500000000u, res.fraction);
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2019-04-14 01:02:03.123", res));
+    EXPECT_EQ(123000000u, res.fraction);
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2019-04-14 01:02:03.000001", res));
+    EXPECT_EQ(1000u, res.fraction);
+
+    ASSERT_EQ(ParseStatus::Ok, parse("2019-04-14 01:02:03.999999999", res));
+    EXPECT_EQ(999999999u, res.fraction);
+
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 01:02:03.", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 01:02:03,5", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 01:02:03.12a", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("2019-04-14 01:02:03.1234567890", res));
+}
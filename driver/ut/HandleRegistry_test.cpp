@@ -0,0 +1,149 @@
+#include <handle_registry.h>
+#include <driver.h>
+#include <environment.h>
+#include <connection.h>
+#include <statement.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+TEST(HandleRegistry, AddFindRemove)
+{
+    HandleRegistry registry;
+    Object first;
+    Object second;
+
+    EXPECT_EQ(nullptr, registry.find(first.getHandle()));
+
+    registry.add(first.getHandle(), first);
+    registry.add(second.getHandle(), second);
+    EXPECT_EQ(&first, registry.find(first.getHandle()));
+    EXPECT_EQ(&second, registry.find(second.getHandle()));
+    EXPECT_EQ(2u, registry.size());
+
+    registry.add(first.getHandle(), second);
+    EXPECT_EQ(&second, registry.find(first.getHandle()));
+    EXPECT_EQ(2u, registry.size());
+
+    registry.remove(first.getHandle());
+    registry.remove(first.getHandle());
+    EXPECT_EQ(nullptr, registry.find(first.getHandle()));
+    EXPECT_EQ(&second, registry.find(second.getHandle()));
+    EXPECT_EQ(1u, registry.size());
+}
+
+TEST(Object, FromHandle)
+{
+    std::aligned_storage<sizeof(Object), alignof(Object)>::type storage;
+
+    auto * object = new (&storage) Object(SQL_HANDLE_STMT);
+    const auto handle = object->getHandle();
+    EXPECT_EQ(object, Object::fromHandle(handle));
+    EXPECT_EQ(SQL_HANDLE_STMT, Object::fromHandle(handle)->getHandleType());
+
+    object->~Object();
+    EXPECT_EQ(nullptr, Object::fromHandle(handle));
+}
+
+TEST(HandleRegistry, ConcurrentAddFindRemove)
+{
+    HandleRegistry registry;
+
+    // Handles that stay registered all the time, looked up while the others come and go.
+    std::vector<std::unique_ptr<Object>> permanent;
+    for (std::size_t i = 0; i < 100; ++i) {
+        permanent.push_back(std::make_unique<Object>());
+        registry.add(permanent.back()->getHandle(), *permanent.back());
+    }
+
+    const std::size_t num_threads = 8;
+    const std::size_t num_iterations = 20000;
+    std::atomic<std::size_t> num_failures{0};
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<std::unique_ptr<Object>> own;
+
+            for (std::size_t i = 0; i < num_iterations; ++i) {
+                own.push_back(std::make_unique<Object>());
+                registry.add(own.back()->getHandle(), *own.back());
+
+                const auto & lookup = permanent[(i + t) % permanent.size()];
+                if (registry.find(lookup->getHandle()) != lookup.get())
+                    ++num_failures;
+
+                if (registry.find(own.back()->getHandle()) != own.back().get())
+                    ++num_failures;
+
+                // Free in bursts, so that the handles of the freed objects get reused by the following allocations.
+                if (own.size() == 16) {
+                    for (const auto & object : own) {
+                        registry.remove(object->getHandle());
+                        if (registry.find(object->getHandle()) != nullptr)
+                            ++num_failures;
+                    }
+                    own.clear();
+                }
+            }
+
+            for (const auto & object : own)
+                registry.remove(object->getHandle());
+        });
+    }
+
+    for (auto & thread : threads)
+        thread.join();
+
+    EXPECT_EQ(0u, num_failures);
+    EXPECT_EQ(permanent.size(), registry.size());
+}
+
+TEST(HandleRegistry, ConcurrentStatements)
+{
+    auto & driver = Driver::getInstance();
+    auto & environment = driver.allocateChild<Environment>();
+    auto & connection = environment.allocateChild<Connection>();
+    const auto environment_handle = environment.getHandle();
+
+    const std::size_t num_threads = 8;
+    const std::size_t num_iterations = 2000;
+    std::atomic<std::size_t> num_failures{0};
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&] {
+            for (std::size_t i = 0; i < num_iterations; ++i) {
+                auto & statement = connection.allocateChild<Statement>();
+                const auto handle = statement.getHandle();
+
+                const auto rc = driver.call([&] (Statement & found) {
+                    return (&found == &statement ? SQL_SUCCESS : SQL_ERROR);
+                }, handle, SQL_HANDLE_STMT);
+                if (rc != SQL_SUCCESS)
+                    ++num_failures;
+
+                statement.deallocateSelf();
+            }
+        });
+    }
+
+    for (auto & thread : threads)
+        thread.join();
+
+    EXPECT_EQ(0u, num_failures);
+    EXPECT_EQ(SQL_INVALID_HANDLE, driver.call([] (Statement &) { return SQL_SUCCESS; }, nullptr, SQL_HANDLE_STMT));
+
+    // A handle of one type is not dispatched as another.
+    EXPECT_EQ(SQL_INVALID_HANDLE, driver.call([] (Statement &) { return SQL_SUCCESS; }, connection.getHandle(), SQL_HANDLE_STMT));
+    EXPECT_EQ(SQL_SUCCESS, driver.call([] (Connection &) { return SQL_SUCCESS; }, connection.getHandle(), SQL_HANDLE_DBC));
+    EXPECT_EQ(SQL_SUCCESS, driver.call([] (Connection &) { return SQL_SUCCESS; }, connection.getHandle()));
+
+    driver.deallocateChild<Environment>(environment_handle);
+}
@@ -0,0 +1,234 @@
+#include <number_parser.h>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <random>
+#include <string>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+template <typename T>
+ParseStatus parse(const std::string & text, T & res) {
+    // Not '\0'-terminated, to check that the parsers do not look past the end.
+    const std::string padded = text + "9";
+    return parseNumber(padded.data(), text.size(), res);
+}
+
+} // namespace
+
+TEST(NumberParser, UInt64)
+{
+    uint64_t res = 0;
+
+    EXPECT_EQ(ParseStatus::Ok, parse("0", res));
+    EXPECT_EQ(0u, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("+42", res));
+    EXPECT_EQ(42u, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("12345678", res));
+    EXPECT_EQ(12345678u, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("0000000000000000000000001234567890123456789", res));
+    EXPECT_EQ(1234567890123456789u, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("18446744073709551615", res));
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), res);
+
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("18446744073709551616", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("100000000000000000000000", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("-1", res));
+
+    EXPECT_EQ(ParseStatus::Invalid, parse("", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("+", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse(" 1", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("1 ", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("1234567x", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("12345678x", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("1.5", res));
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), res); // Unchanged on errors.
+}
+
+TEST(NumberParser, Int64)
+{
+    int64_t res = 0;
+
+    EXPECT_EQ(ParseStatus::Ok, parse("-123", res));
+    EXPECT_EQ(-123, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("9223372036854775807", res));
+    EXPECT_EQ(std::numeric_limits<int64_t>::max(), res);
+    EXPECT_EQ(ParseStatus::Ok, parse("-9223372036854775808", res));
+    EXPECT_EQ(std::numeric_limits<int64_t>::min(), res);
+
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("9223372036854775808", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("-9223372036854775809", res));
+
+    EXPECT_EQ(ParseStatus::Invalid, parse("-", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("--1", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("1e3", res));
+}
+
+TEST(NumberParser, Double)
+{
+    double res = 0;
+
+    EXPECT_EQ(ParseStatus::Ok, parse("0.1", res));
+    EXPECT_EQ(0.1, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("-2.5e-3", res));
+    EXPECT_EQ(-2.5e-3, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("1.", res));
+    EXPECT_EQ(1.0, res);
+    EXPECT_EQ(ParseStatus::Ok, parse(".5", res));
+    EXPECT_EQ(0.5, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("1E+5", res));
+    EXPECT_EQ(1e5, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("-0", res));
+    EXPECT_TRUE(res == 0 && std::signbit(res));
+
+    // Outside of the exact fast path.
+    EXPECT_EQ(ParseStatus::Ok, parse("0.30000000000000004", res));
+    EXPECT_EQ(0.30000000000000004, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("1.7976931348623157e308", res));
+    EXPECT_EQ(std::numeric_limits<double>::max(), res);
+    EXPECT_EQ(ParseStatus::Ok, parse("123456789012345678901234567890", res));
+    EXPECT_EQ(123456789012345678901234567890.0, res);
+
+    EXPECT_EQ(ParseStatus::Ok, parse("inf", res));
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), res);
+    EXPECT_EQ(ParseStatus::Ok, parse("-inf", res));
+    EXPECT_EQ(-std::numeric_limits<double>::infinity(), res);
+    EXPECT_EQ(ParseStatus::Ok, parse("nan", res));
+    EXPECT_TRUE(std::isnan(res));
+
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("1e400", res));
+
+    EXPECT_EQ(ParseStatus::Invalid, parse("", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse(".", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("e5", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("1e", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("1,5", res));
+    EXPECT_EQ(ParseStatus::Invalid, parse("infinite", res));
+}
+
+TEST(NumberParser, Float)
+{
+    float res = 0;
+
+    EXPECT_EQ(ParseStatus::Ok, parse("0.1", res));
+    EXPECT_EQ(0.1f, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("3.4028235e38", res));
+    EXPECT_EQ(std::numeric_limits<float>::max(), res);
+
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("3.5e38", res));
+}
+
+TEST(NumberParser, RoundTrip)
+{
+    std::mt19937_64 generator(42);
+
+    for (std::size_t i = 0; i < 100000; ++i) {
+        const auto bits = generator();
+
+        const uint64_t u = bits >> (i % 64);
+        uint64_t parsed_u = 0;
+        ASSERT_EQ(ParseStatus::Ok, parse(std::to_string(u), parsed_u));
+        ASSERT_EQ(u, parsed_u);
+
+        double d = 0;
+        std::memcpy(&d, &bits, sizeof(d));
+        if (!std::isfinite(d))
+            continue;
+
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.*g", static_cast<int>(i % 17) + 1, d);
+
+        const auto expected = std::strtod(buf, nullptr);
+        if (std::isinf(expected))
+            continue;
+
+        double parsed_d = 0;
+        ASSERT_EQ(ParseStatus::Ok, parse(buf, parsed_d)) << buf;
+        ASSERT_EQ(expected, parsed_d) << buf;
+    }
+}
+
+TEST(NumberParser, SeventeenDigits)
+{
+    double res = 0;
+
+    // Mantissas above 2^53, that the exact fast path can not take.
+    for (const auto * text : {"0.12345678901234567", "12345678901234567", "9007199254740993", "2.2250738585072014e-308",
+        "4.9406564584124654e-324", "2.4703282292062328e-324", "1.7976931348623158e308", "8.9884656743115795e307",
+        "0.10000000000000001", "123456789.12345679", "1.2345678901234567e-200", "-3.1415926535897931"})
+    {
+        ASSERT_EQ(ParseStatus::Ok, parse(text, res)) << text;
+        EXPECT_EQ(std::strtod(text, nullptr), res) << text;
+    }
+
+    // Exactly halfway between two doubles: rounds to even.
+    EXPECT_EQ(ParseStatus::Ok, parse("9007199254740993", res));
+    EXPECT_EQ(9007199254740992.0, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("9007199254740995", res));
+    EXPECT_EQ(9007199254740996.0, res);
+
+    // Subnormals, and values too small even for those.
+    EXPECT_EQ(ParseStatus::Ok, parse("4.9406564584124654e-324", res));
+    EXPECT_EQ(std::numeric_limits<double>::denorm_min(), res);
+    EXPECT_EQ(ParseStatus::Ok, parse("2.2250738585072011e-308", res));
+    EXPECT_EQ(std::strtod("2.2250738585072011e-308", nullptr), res);
+    EXPECT_EQ(ParseStatus::Ok, parse("-1.2345678901234567e-400", res));
+    EXPECT_TRUE(res == 0 && std::signbit(res));
+
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("1.7976931348623159e308", res));
+    EXPECT_EQ(ParseStatus::OutOfRange, parse("12345678901234567e300", res));
+
+    // More than 19 digits, those beyond matter only for rounding.
+    EXPECT_EQ(ParseStatus::Ok, parse("9007199254740993.0000000000000000001", res));
+    EXPECT_EQ(9007199254740994.0, res);
+    EXPECT_EQ(ParseStatus::Ok, parse("9007199254740992.9999999999999999999", res));
+    EXPECT_EQ(9007199254740992.0, res);
+
+    float res_float = 0;
+    for (const auto * text : {"0.123456789", "16777217", "3.40282347e38", "1.17549435e-38", "1.40129846e-45", "7.0064923e-46"}) {
+        ASSERT_EQ(ParseStatus::Ok, parse(text, res_float)) << text;
+        EXPECT_EQ(std::strtof(text, nullptr), res_float) << text;
+    }
+    EXPECT_EQ(16777216.0f, (parse("16777217", res_float), res_float));
+}
+
+TEST(NumberParser, RandomLongMantissas)
+{
+    std::mt19937_64 generator(17);
+
+    for (std::size_t i = 0; i < 200000; ++i) {
+        const auto digits = 16 + static_cast<int>(i % 5); // Up to 20 digits, past those kept.
+        const auto exponent = static_cast<int>(generator() % 700) - 350;
+
+        std::string text = std::to_string(generator() % 9 + 1);
+        while (static_cast<int>(text.size()) < digits)
+            text += static_cast<char>('0' + generator() % 10);
+        text += "e" + std::to_string(exponent);
+
+        const auto expected = std::strtod(text.c_str(), nullptr);
+        double res = 0;
+        if (std::isinf(expected)) {
+            ASSERT_EQ(ParseStatus::OutOfRange, parse(text, res)) << text;
+            continue;
+        }
+
+        ASSERT_EQ(ParseStatus::Ok, parse(text, res)) << text;
+        ASSERT_EQ(expected, res) << text;
+
+        const auto expected_float = std::strtof(text.c_str(), nullptr);
+        float res_float = 0;
+        if (std::isinf(expected_float)) {
+            ASSERT_EQ(ParseStatus::OutOfRange, parse(text, res_float)) << text;
+            continue;
+        }
+
+        ASSERT_EQ(ParseStatus::Ok, parse(text, res_float)) << text;
+        ASSERT_EQ(expected_float, res_float) << text;
+    }
+}
@@ -0,0 +1,191 @@
+#include <response_stream.h>
+#include <read_helpers.h>
+
+#include <Poco/DeflatingStream.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace {
+
+std::string makeData(std::size_t size) {
+    std::string data;
+    data.reserve(size);
+    for (std::size_t i = 0; data.size() < size; ++i)
+        data += std::to_string(i) + ',';
+    data.resize(size);
+    return data;
+}
+
+std::string compress(const std::string & data, Poco::DeflatingStreamBuf::StreamType type) {
+    std::ostringstream out;
+    Poco::DeflatingOutputStream deflating(out, type);
+    deflating << data;
+    deflating.close();
+    return out.str();
+}
+
+std::string readAll(std::istream & in) {
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+/// Serves the data in small pieces, counting the pieces that had to be waited for, past what has arrived.
+class TricklingStreamBuf
+    : public std::streambuf
+{
+public:
+    explicit TricklingStreamBuf(std::string data_)
+        : data(std::move(data_))
+    {
+    }
+
+    void setArrived(std::size_t size) {
+        arrived = size;
+    }
+
+    std::size_t getNumWaits() const {
+        return num_waits;
+    }
+
+protected:
+    int_type underflow() override {
+        if (pos >= data.size())
+            return traits_type::eof();
+
+        if (pos >= arrived)
+            ++num_waits;
+
+        const auto size = std::min<std::size_t>(7, data.size() - pos);
+        setg(&data[pos], &data[pos], &data[pos] + size);
+        pos += size;
+
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    std::string data;
+    std::size_t pos = 0;
+    std::size_t arrived = 0;
+    std::size_t num_waits = 0;
+};
+
+} // namespace
+
+TEST(ResponseStream, Compression)
+{
+    EXPECT_TRUE(isSupportedCompression("none"));
+    EXPECT_TRUE(isSupportedCompression("gzip"));
+    EXPECT_TRUE(isSupportedCompression("deflate"));
+    EXPECT_FALSE(isSupportedCompression(""));
+    EXPECT_FALSE(isSupportedCompression("lz4"));
+
+    EXPECT_EQ(getAcceptEncoding("none"), "");
+    EXPECT_EQ(getAcceptEncoding("gzip"), "gzip");
+    EXPECT_EQ(getAcceptEncoding("deflate"), "deflate");
+    EXPECT_THROW(getAcceptEncoding("br"), std::runtime_error);
+}
+
+TEST(ResponseStream, Identity)
+{
+    const auto data = makeData(300000);
+
+    for (const auto & encoding : {"", "identity"}) {
+        std::istringstream raw(data);
+        ResponseStream stream(raw, encoding);
+
+        EXPECT_EQ(readAll(stream.get()), data);
+        EXPECT_EQ(stream.getReceivedBytes(), data.size());
+        EXPECT_EQ(stream.getDecodedBytes(), data.size());
+    }
+}
+
+TEST(ResponseStream, UnsupportedEncoding)
+{
+    std::istringstream raw("abc");
+    EXPECT_THROW(ResponseStream(raw, "br"), std::runtime_error);
+}
+
+TEST(ResponseStream, Decompress)
+{
+    const auto data = makeData(1 << 20);
+
+    const std::pair<const char *, Poco::DeflatingStreamBuf::StreamType> encodings[] = {
+        {"gzip", Poco::DeflatingStreamBuf::STREAM_GZIP},
+        {"deflate", Poco::DeflatingStreamBuf::STREAM_ZLIB}
+    };
+
+    for (const auto & encoding : encodings) {
+        const auto compressed = compress(data, encoding.second);
+        ASSERT_LT(compressed.size(), data.size());
+
+        std::istringstream raw(compressed);
+        ResponseStream stream(raw, encoding.first);
+
+        EXPECT_EQ(readAll(stream.get()), data);
+        EXPECT_EQ(stream.getReceivedBytes(), compressed.size());
+        EXPECT_EQ(stream.getDecodedBytes(), data.size());
+    }
+}
+
+TEST(ResponseStream, LargeAndSmallReads)
+{
+    const auto data = makeData(1 << 20);
+    std::istringstream raw(compress(data, Poco::DeflatingStreamBuf::STREAM_GZIP));
+    ResponseStream stream(raw, "gzip");
+
+    // BufferedReader reads in chunks larger than the internal buffer, then in small pieces when the chunk is tiny.
+    BufferedReader reader(stream.get(), 300000);
+    std::string result;
+    result.append(reader.readRaw(5), 5);
+    result.append(reader.readRaw(400000), 400000);
+    while (!reader.eof())
+        result.append(reader.readRaw(1), 1);
+
+    EXPECT_EQ(result, data);
+    EXPECT_EQ(stream.getDecodedBytes(), data.size());
+}
+
+TEST(ResponseStream, DoesNotWaitForFullBuffer)
+{
+    const auto data = makeData(100000);
+    TricklingStreamBuf source(data);
+    std::istream raw(&source);
+    ResponseStream stream(raw, "");
+    auto & in = stream.get();
+
+    // Only the first piece has arrived, and it is passed through without waiting for the buffer to fill up.
+    source.setArrived(7);
+    EXPECT_EQ(data[0], in.get());
+    EXPECT_EQ(6, in.rdbuf()->in_avail());
+
+    char buf[100];
+    EXPECT_EQ(6, in.readsome(buf, sizeof(buf)));
+    EXPECT_EQ(data.substr(1, 6), std::string(buf, 6));
+    EXPECT_EQ(0, in.readsome(buf, sizeof(buf)));
+    EXPECT_EQ(0u, source.getNumWaits());
+
+    source.setArrived(data.size());
+    EXPECT_EQ(readAll(in), data.substr(7));
+    EXPECT_EQ(0u, source.getNumWaits());
+    EXPECT_EQ(stream.getReceivedBytes(), data.size());
+}
+
+TEST(ResponseStream, CompressBody)
+{
+    const auto data = "INSERT INTO t VALUES " + makeData(200000);
+
+    for (const auto & encoding : {"gzip", "deflate"}) {
+        const auto compressed = compressBody(data, encoding);
+        EXPECT_LT(compressed.size(), data.size() / 2);
+
+        std::istringstream raw(compressed);
+        ResponseStream stream(raw, encoding);
+        EXPECT_EQ(readAll(stream.get()), data);
+    }
+
+    EXPECT_THROW(compressBody(data, "br"), std::runtime_error);
+}
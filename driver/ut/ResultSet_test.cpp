@@ -0,0 +1,867 @@
+#include <diagnostics.h>
+#include <result_set.h>
+#include <time_zone.h>
+
+#include <gtest/gtest.h>
+
+#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+class ODBCDriver2Writer {
+public:
+    void writeSize(int32_t size) {
+        data.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    }
+
+    void writeString(const std::string & value) {
+        writeSize(static_cast<int32_t>(value.size()));
+        data.append(value);
+    }
+
+    void writeNull() {
+        writeSize(-1);
+    }
+
+    void writeHeader(const std::vector<std::string> & names, const std::vector<std::string> & types) {
+        writeSize(2);
+
+        writeSize(static_cast<int32_t>(names.size() + 1));
+        writeString("name");
+        for (const auto & name : names)
+            writeString(name);
+
+        writeSize(static_cast<int32_t>(types.size() + 1));
+        writeString("type");
+        for (const auto & type : types)
+            writeString(type);
+    }
+
+    std::string data;
+};
+
+class UpperCaseMutator : public IResultMutator {
+public:
+    void UpdateColumnInfo(std::vector<ColumnInfo> * columns_info) override {
+        columns_info->at(0).name = "NAME";
+    }
+
+    void UpdateRow(const std::vector<ColumnInfo> & columns_info, Row * row) override {
+        for (auto & ch : row->data.at(0).data)
+            ch = std::toupper(ch);
+    }
+};
+
+} // namespace
+
+TEST(ColumnBatch, AppendAndRead)
+{
+    ColumnBatch batch;
+    const std::vector<ColumnInfo> columns_info(2);
+    batch.clear(columns_info);
+
+    for (std::size_t i = 0; i < 130; ++i) {
+        const auto value = std::to_string(i);
+        batch.appendValue(0, value.data(), value.size(), false);
+        batch.appendValue(1, "", 0, i % 3 == 0);
+        batch.finishRow();
+    }
+
+    ASSERT_EQ(130u, batch.getNumRows());
+
+    for (std::size_t i = 0; i < 130; ++i) {
+        const auto field = batch.getField(i, 0);
+        EXPECT_EQ(std::to_string(i), field.toString());
+        EXPECT_EQ('\0', field.c_str()[field.size()]);
+        EXPECT_FALSE(field.isNull());
+        EXPECT_EQ(i % 3 == 0, batch.getField(i, 1).isNull());
+    }
+
+    batch.clear(columns_info);
+    EXPECT_EQ(0u, batch.getNumRows());
+}
+
+TEST(Field, NumbersFromText)
+{
+    const std::string number = "-17.75";
+    const Field field{number.c_str(), number.size(), false};
+
+    EXPECT_EQ(-17, field.getInt());
+    EXPECT_EQ(-17.75, field.getDouble());
+    EXPECT_EQ(-17.75f, field.getFloat());
+
+    const std::string not_number = "17 apples";
+    const Field bad_field{not_number.c_str(), not_number.size(), false};
+
+    int64_t res = 0;
+    EXPECT_EQ(ParseStatus::Invalid, bad_field.tryGetNumber(res));
+
+    try {
+        bad_field.getInt();
+        FAIL();
+    } catch (const SqlException & e) {
+        EXPECT_EQ("22018", e.getSQLState());
+    }
+
+    try {
+        field.getUInt();
+        FAIL();
+    } catch (const SqlException & e) {
+        EXPECT_EQ("22003", e.getSQLState());
+    }
+}
+
+TEST(Field, BinaryNumbersOutOfRange)
+{
+    const int64_t negative = -1;
+    const Field negative_field{reinterpret_cast<const char *>(&negative), sizeof(negative), false, ValueEncoding::Int64};
+
+    uint64_t unsigned_res = 0;
+    EXPECT_EQ(ParseStatus::OutOfRange, negative_field.tryGetNumber(unsigned_res));
+    EXPECT_EQ(0u, unsigned_res);
+    EXPECT_EQ(-1, negative_field.getInt());
+
+    const double huge = 1e300;
+    const Field huge_field{reinterpret_cast<const char *>(&huge), sizeof(huge), false, ValueEncoding::Float64};
+
+    int64_t signed_res = 0;
+    float float_res = 0;
+    EXPECT_EQ(ParseStatus::OutOfRange, huge_field.tryGetNumber(signed_res));
+    EXPECT_EQ(ParseStatus::OutOfRange, huge_field.tryGetNumber(float_res));
+    EXPECT_EQ(1e300, huge_field.getDouble());
+
+    try {
+        huge_field.getInt();
+        FAIL();
+    } catch (const SqlException & e) {
+        EXPECT_EQ("22003", e.getSQLState());
+    }
+}
+
+TEST(ResultSet, ReadRows)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id", "name"}, {"UInt64", "Nullable(String)"});
+
+    const std::size_t num_rows = 250; // Spans several batches.
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        writer.writeString(std::to_string(i));
+        if (i % 2)
+            writer.writeNull();
+        else
+            writer.writeString("name" + std::to_string(i));
+    }
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+
+    ASSERT_EQ(2u, result_set.getNumColumns());
+    EXPECT_EQ("id", result_set.getColumnInfo(0).name);
+    EXPECT_EQ("UInt64", result_set.getColumnInfo(0).type_without_parameters);
+    EXPECT_TRUE(result_set.getColumnInfo(1).is_nullable);
+
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        ASSERT_TRUE(result_set.advanceToNextRow());
+        EXPECT_EQ(i + 1, result_set.getCurrentRowNum());
+        EXPECT_EQ(i, result_set.getCurrentField(0).getUInt());
+
+        const auto name = result_set.getCurrentField(1);
+        EXPECT_EQ(i % 2 == 1, name.isNull());
+        if (!name.isNull())
+            EXPECT_EQ("name" + std::to_string(i), name.toString());
+    }
+
+    EXPECT_FALSE(result_set.advanceToNextRow());
+    EXPECT_FALSE(result_set.hasCurrentRow());
+    EXPECT_EQ(num_rows, result_set.getCurrentRowNum());
+}
+
+TEST(ResultSet, AdvanceToNextRows)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id"}, {"UInt64"});
+
+    const std::size_t num_rows = 250; // The first batch is smaller than that.
+    for (std::size_t i = 0; i < num_rows; ++i)
+        writer.writeString(std::to_string(i));
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+
+    EXPECT_EQ(0u, result_set.advanceToNextRows(0));
+
+    std::size_t next_id = 0;
+    std::size_t num_runs = 0;
+    while (const auto run_size = result_set.advanceToNextRows(64)) {
+        ASSERT_LE(run_size, 64u);
+        for (std::size_t i = 0; i < run_size; ++i)
+            EXPECT_EQ(next_id++, result_set.getField(i, 0).getUInt());
+
+        // The last row of the run is the current one.
+        EXPECT_EQ(next_id - 1, result_set.getCurrentField(0).getUInt());
+        EXPECT_EQ(next_id, result_set.getCurrentRowNum());
+        ++num_runs;
+    }
+
+    EXPECT_EQ(num_rows, next_id);
+    EXPECT_GT(num_runs, num_rows / 64); // Runs don't span batches.
+    EXPECT_FALSE(result_set.hasCurrentRow());
+}
+
+TEST(ResultSet, Prefetch)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id", "name"}, {"UInt64", "Nullable(String)"});
+
+    const std::size_t num_rows = 1000;
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        writer.writeString(std::to_string(i));
+        if (i % 2)
+            writer.writeNull();
+        else
+            writer.writeString("name" + std::to_string(i));
+    }
+
+    for (const std::size_t max_queued_bytes : {1, 1 << 20}) {
+        std::istringstream in(writer.data);
+        ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+        result_set.startPrefetching(max_queued_bytes);
+
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            ASSERT_TRUE(result_set.advanceToNextRow());
+            EXPECT_EQ(i, result_set.getCurrentField(0).getUInt());
+
+            const auto name = result_set.getCurrentField(1);
+            EXPECT_EQ(i % 2 == 1, name.isNull());
+            if (!name.isNull())
+                EXPECT_EQ("name" + std::to_string(i), name.toString());
+        }
+
+        EXPECT_FALSE(result_set.advanceToNextRow());
+        EXPECT_EQ(num_rows, result_set.getCurrentRowNum());
+    }
+}
+
+TEST(ResultSet, PrefetchStoppedEarly)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id"}, {"UInt64"});
+    for (std::size_t i = 0; i < 10000; ++i)
+        writer.writeString(std::to_string(i));
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+    result_set.startPrefetching(1);
+
+    ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_EQ(0u, result_set.getCurrentField(0).getUInt());
+
+    result_set.stopPrefetching();
+
+    std::size_t num_rows_read = 1;
+    while (result_set.advanceToNextRow())
+        ++num_rows_read;
+    EXPECT_LT(num_rows_read, 10000u);
+}
+
+namespace {
+
+/// Hands out the data, then blocks, as a socket waiting for the rest of the response would, until aborted.
+class StalledStreamBuf
+    : public std::streambuf
+{
+public:
+    explicit StalledStreamBuf(std::string data_)
+        : data(std::move(data_))
+    {
+        setg(&data[0], &data[0], &data[0] + data.size());
+    }
+
+    void abort() {
+        std::lock_guard<std::mutex> lock(mutex);
+        aborted = true;
+        cv.notify_all();
+    }
+
+protected:
+    int_type underflow() override {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return aborted; });
+        return traits_type::eof();
+    }
+
+private:
+    std::string data;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool aborted = false;
+};
+
+} // namespace
+
+TEST(ResultSet, PrefetchAbortedWhileWaitingForStream)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id"}, {"UInt64"});
+    for (std::size_t i = 0; i < 150; ++i)
+        writer.writeString(std::to_string(i));
+
+    StalledStreamBuf source(writer.data);
+    std::istream in(&source);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+    result_set.startPrefetching(1 << 20);
+
+    // The thread waits for the rest of the second batch, which never comes unless the stream is aborted.
+    bool aborted = false;
+    result_set.stopPrefetching([&] {
+        aborted = true;
+        source.abort();
+    });
+    EXPECT_TRUE(aborted);
+
+    // The first batch has been read before prefetching started.
+    std::size_t num_rows_read = 0;
+    while (result_set.advanceToNextRow())
+        ++num_rows_read;
+    EXPECT_LT(num_rows_read, 150u);
+}
+
+TEST(ResultSet, PrefetchFinishedIsNotAborted)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id"}, {"UInt64"});
+    for (std::size_t i = 0; i < 10; ++i)
+        writer.writeString(std::to_string(i));
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+    result_set.startPrefetching(1 << 20);
+
+    while (result_set.advanceToNextRow()) {
+    }
+
+    bool aborted = false;
+    result_set.stopPrefetching([&] { aborted = true; });
+    EXPECT_FALSE(aborted);
+}
+
+TEST(ResultSet, PrefetchError)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id"}, {"UInt64"});
+    for (std::size_t i = 0; i < 300; ++i)
+        writer.writeString(std::to_string(i));
+    writer.writeSize(100); // Truncated value.
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+    result_set.startPrefetching(1 << 20);
+
+    EXPECT_THROW({
+        while (result_set.advanceToNextRow()) {
+        }
+    }, std::runtime_error);
+}
+
+TEST(ResultSet, RowLimit)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id"}, {"UInt64"});
+    for (std::size_t i = 0; i < 300; ++i)
+        writer.writeString(std::to_string(i));
+    writer.writeSize(100); // Truncated value, never reached because of the limit.
+
+    for (const bool prefetch : {false, true}) {
+        std::istringstream in(writer.data);
+        ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+        result_set.setRowLimit(250);
+        if (prefetch)
+            result_set.startPrefetching(1 << 20);
+
+        std::size_t next_id = 0;
+        while (const auto run_size = result_set.advanceToNextRows(64)) {
+            for (std::size_t i = 0; i < run_size; ++i)
+                EXPECT_EQ(next_id++, result_set.getField(i, 0).getUInt());
+
+            EXPECT_EQ(next_id == 250, result_set.isRowLimitReached());
+        }
+
+        EXPECT_EQ(250u, next_id);
+        EXPECT_TRUE(result_set.isRowLimitReached());
+        EXPECT_FALSE(result_set.advanceToNextRow());
+        EXPECT_EQ(250u, result_set.getCurrentRowNum());
+    }
+}
+
+TEST(ResultSet, ReadAheadWideRows)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"data"}, {"String"});
+
+    const std::size_t num_rows = 300;
+    for (std::size_t i = 0; i < num_rows; ++i)
+        writer.writeString(std::string(1000, 'a' + i % 26));
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, 1);
+    result_set.setReadAheadSize(8000);
+
+    // The first batch is read in the constructor, with the default limit.
+    for (std::size_t i = 0; i < 100; ++i)
+        ASSERT_TRUE(result_set.advanceToNextRow());
+
+    // The following ones stop at the byte budget, instead of taking as many rows again.
+    const auto pos_before = static_cast<std::size_t>(in.tellg());
+    ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_LT(static_cast<std::size_t>(in.tellg()) - pos_before, 20000u);
+    EXPECT_EQ(std::string(1000, 'a' + 100 % 26), result_set.getCurrentField(0).toString());
+
+    for (std::size_t i = 101; i < num_rows; ++i)
+        ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_FALSE(result_set.advanceToNextRow());
+}
+
+TEST(ResultSet, ReadAheadNarrowRows)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id"}, {"UInt32"});
+
+    const std::size_t num_rows = 100000;
+    for (std::size_t i = 0; i < num_rows; ++i)
+        writer.writeString(std::to_string(i));
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, 1);
+
+    for (std::size_t i = 0; i < 100; ++i)
+        ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_LT(static_cast<std::size_t>(in.tellg()), 10000u);
+
+    // Narrow rows make the following batches take many more rows than the first one.
+    ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_GT(static_cast<std::size_t>(in.tellg()), 100000u);
+
+    for (std::size_t i = 101; i < num_rows; ++i) {
+        ASSERT_TRUE(result_set.advanceToNextRow());
+        ASSERT_EQ(i, result_set.getCurrentField(0).getUInt());
+    }
+    EXPECT_FALSE(result_set.advanceToNextRow());
+}
+
+TEST(ResultSet, Mutator)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"name"}, {"String"});
+    writer.writeString("abc");
+    writer.writeString("def");
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, std::make_unique<UpperCaseMutator>(), BufferedReader::default_chunk_size);
+
+    EXPECT_EQ("NAME", result_set.getColumnInfo(0).name);
+
+    ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_EQ("ABC", result_set.getCurrentField(0).toString());
+
+    ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_EQ("DEF", result_set.getCurrentField(0).toString());
+
+    EXPECT_FALSE(result_set.advanceToNextRow());
+}
+
+TEST(ResultSet, MutatorAdvanceToNextRows)
+{
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"name"}, {"String"});
+    writer.writeString("abc");
+    writer.writeString("def");
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, std::make_unique<UpperCaseMutator>(), BufferedReader::default_chunk_size);
+
+    // Mutated rows are advanced over one by one.
+    ASSERT_EQ(1u, result_set.advanceToNextRows(10));
+    EXPECT_EQ("ABC", result_set.getField(0, 0).toString());
+
+    ASSERT_EQ(1u, result_set.advanceToNextRows(10));
+    EXPECT_EQ("DEF", result_set.getField(0, 0).toString());
+
+    EXPECT_EQ(0u, result_set.advanceToNextRows(10));
+}
+
+namespace {
+
+class RowBinaryWriter {
+public:
+    template <typename T>
+    void write(T value) {
+        data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void writeVarUInt(uint64_t value) {
+        do {
+            char byte = static_cast<char>(value & 0x7F);
+            value >>= 7;
+            if (value)
+                byte |= 0x80;
+            data += byte;
+        } while (value);
+    }
+
+    void writeString(const std::string & value) {
+        writeVarUInt(value.size());
+        data += value;
+    }
+
+    void writeHeader(const std::vector<std::string> & names, const std::vector<std::string> & types) {
+        writeVarUInt(names.size());
+        for (const auto & name : names)
+            writeString(name);
+        for (const auto & type : types)
+            writeString(type);
+    }
+
+    std::string data;
+};
+
+} // namespace
+
+TEST(ResultSet, RowBinaryWithNamesAndTypesNumbers)
+{
+    RowBinaryWriter writer;
+    writer.writeHeader({"u32", "i8", "f64", "d", "dt", "s"}, {"UInt32", "Int8", "Float64", "Date", "DateTime('UTC')", "Nullable(String)"});
+
+    const std::size_t num_rows = 150;
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        writer.write<uint32_t>(static_cast<uint32_t>(i * 1000));
+        writer.write<int8_t>(-static_cast<int8_t>(i % 100));
+        writer.write<double>(i + 0.5);
+        writer.write<uint16_t>(18262); // 2020-01-01
+        writer.write<uint32_t>(1577934245); // 2020-01-02 03:04:05
+        if (i % 2) {
+            writer.write<uint8_t>(1);
+        } else {
+            writer.write<uint8_t>(0);
+            writer.writeString("str" + std::to_string(i));
+        }
+    }
+
+    std::istringstream in(writer.data);
+    RowBinaryWithNamesAndTypesResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "");
+
+    ASSERT_EQ(6u, result_set.getNumColumns());
+    EXPECT_EQ("dt", result_set.getColumnInfo(4).name);
+    EXPECT_EQ(ValueEncoding::UInt32, result_set.getColumnInfo(0).encoding);
+    EXPECT_EQ(ValueEncoding::DateTime, result_set.getColumnInfo(4).encoding);
+    EXPECT_EQ(ValueEncoding::Text, result_set.getColumnInfo(5).encoding);
+    EXPECT_TRUE(result_set.getColumnInfo(5).is_nullable);
+    EXPECT_EQ(10u, result_set.getColumnInfo(0).display_size);
+
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        ASSERT_TRUE(result_set.advanceToNextRow());
+
+        EXPECT_EQ(i * 1000, result_set.getCurrentField(0).getUInt());
+        EXPECT_EQ(std::to_string(i * 1000), result_set.getCurrentField(0).toString());
+        EXPECT_EQ(-static_cast<int64_t>(i % 100), result_set.getCurrentField(1).getInt());
+        EXPECT_DOUBLE_EQ(i + 0.5, result_set.getCurrentField(2).getDouble());
+
+        const auto date = result_set.getCurrentField(3).getDate();
+        EXPECT_EQ(2020, date.year);
+        EXPECT_EQ(1, date.month);
+        EXPECT_EQ(1, date.day);
+        EXPECT_EQ("2020-01-01", result_set.getCurrentField(3).toString());
+
+        const auto date_time = result_set.getCurrentField(4).getDateTime();
+        EXPECT_EQ(2, date_time.day);
+        EXPECT_EQ(3, date_time.hour);
+        EXPECT_EQ(5, date_time.second);
+        EXPECT_EQ("2020-01-02 03:04:05", result_set.getCurrentField(4).toString());
+
+        EXPECT_EQ(i % 2 == 1, result_set.getCurrentField(5).isNull());
+        if (i % 2 == 0)
+            EXPECT_EQ("str" + std::to_string(i), result_set.getCurrentField(5).toString());
+    }
+
+    EXPECT_FALSE(result_set.advanceToNextRow());
+}
+
+TEST(ResultSet, RowBinaryWithNamesAndTypesAsText)
+{
+    RowBinaryWriter writer;
+    writer.writeHeader(
+        {"dec", "arr", "dt64", "uuid", "enum", "lc", "i128", "f32", "tuple", "ipv6"},
+        {"Decimal(10, 2)", "Array(Nullable(String))", "DateTime64(3, 'UTC')", "UUID", "Enum8('a' = 1, 'b\\'c' = -2)",
+            "LowCardinality(String)", "Int128", "Float32", "Tuple(a UInt8, b Date)", "IPv6"});
+
+    writer.write<int64_t>(-12345);
+
+    writer.writeVarUInt(3);
+    writer.write<uint8_t>(0);
+    writer.writeString("it's");
+    writer.write<uint8_t>(1);
+    writer.write<uint8_t>(0);
+    writer.writeString("");
+
+    writer.write<int64_t>(1577934245123);
+
+    writer.write<uint64_t>(0x0123456789abcdefull);
+    writer.write<uint64_t>(0xfedcba9876543210ull);
+
+    writer.write<int8_t>(-2);
+
+    writer.writeString("low");
+
+    writer.write<int64_t>(-1);
+    writer.write<int64_t>(-1);
+
+    writer.write<float>(0.1f);
+
+    writer.write<uint8_t>(7);
+    writer.write<uint16_t>(0);
+
+    const unsigned char ipv6[16] = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    writer.data.append(reinterpret_cast<const char *>(ipv6), sizeof(ipv6));
+
+    std::istringstream in(writer.data);
+    RowBinaryWithNamesAndTypesResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "");
+
+    ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_EQ("-123.45", result_set.getCurrentField(0).toString());
+    EXPECT_EQ("['it\\'s',NULL,'']", result_set.getCurrentField(1).toString());
+    EXPECT_EQ("2020-01-02 03:04:05.123", result_set.getCurrentField(2).toString());
+    EXPECT_EQ("01234567-89ab-cdef-fedc-ba9876543210", result_set.getCurrentField(3).toString());
+    EXPECT_EQ("b'c", result_set.getCurrentField(4).toString());
+    EXPECT_EQ("low", result_set.getCurrentField(5).toString());
+    EXPECT_EQ("-1", result_set.getCurrentField(6).toString());
+    EXPECT_EQ("0.1", result_set.getCurrentField(7).toString());
+    EXPECT_EQ("(7,'1970-01-01')", result_set.getCurrentField(8).toString());
+    EXPECT_EQ("2001:db8::1", result_set.getCurrentField(9).toString());
+
+    EXPECT_FALSE(result_set.advanceToNextRow());
+}
+
+TEST(ResultSet, RowBinaryWithNamesAndTypesUnsupportedType)
+{
+    RowBinaryWriter writer;
+    writer.writeHeader({"x"}, {"AggregateFunction(uniq, UInt64)"});
+
+    std::istringstream in(writer.data);
+    EXPECT_THROW(RowBinaryWithNamesAndTypesResultSet(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, ""), std::runtime_error);
+}
+
+TEST(ResultSet, BinaryDateTimeTimeZones)
+{
+    RowBinaryWriter unknown_writer;
+    unknown_writer.writeHeader({"x"}, {"DateTime('No/Such_Zone')"});
+
+    std::istringstream unknown_in(unknown_writer.data);
+    EXPECT_THROW(RowBinaryWithNamesAndTypesResultSet(unknown_in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "UTC"), std::runtime_error);
+
+    // Not every system has a time zone database.
+    try {
+        TimeZone::get("Europe/Moscow");
+    } catch (const std::runtime_error &) {
+        return;
+    }
+
+    // Values without a time zone of their own are in the one of the server.
+    RowBinaryWriter writer;
+    writer.writeHeader({"server", "utc", "dt64", "arr"}, {"DateTime", "DateTime('UTC')", "DateTime64(3)", "Array(DateTime('Asia/Tokyo'))"});
+    writer.write<uint32_t>(1577934245); // 2020-01-02 03:04:05 UTC
+    writer.write<uint32_t>(1577934245);
+    writer.write<int64_t>(1577934245123);
+    writer.writeVarUInt(1);
+    writer.write<uint32_t>(1577934245);
+
+    std::istringstream in(writer.data);
+    RowBinaryWithNamesAndTypesResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "Europe/Moscow");
+
+    ASSERT_TRUE(result_set.advanceToNextRow());
+    EXPECT_EQ("2020-01-02 06:04:05", result_set.getCurrentField(0).toString());
+    EXPECT_EQ(6, result_set.getCurrentField(0).getDateTime().hour);
+    EXPECT_EQ("2020-01-02 03:04:05", result_set.getCurrentField(1).toString());
+    EXPECT_EQ("2020-01-02 06:04:05.123", result_set.getCurrentField(2).toString());
+    EXPECT_EQ("['2020-01-02 12:04:05']", result_set.getCurrentField(3).toString());
+    EXPECT_FALSE(result_set.advanceToNextRow());
+
+    // The offset follows the daylight saving time.
+    RowBinaryWriter native_writer;
+    native_writer.writeVarUInt(1);
+    native_writer.writeVarUInt(2);
+    native_writer.writeString("dt");
+    native_writer.writeString("DateTime");
+    native_writer.write<uint32_t>(1577934245);
+    native_writer.write<uint32_t>(1593572400); // 2020-07-01 03:00:00 UTC
+
+    std::istringstream native_in(native_writer.data);
+    NativeResultSet native_result_set(native_in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "America/New_York");
+
+    ASSERT_TRUE(native_result_set.advanceToNextRow());
+    EXPECT_EQ("2020-01-01 22:04:05", native_result_set.getCurrentField(0).toString());
+    ASSERT_TRUE(native_result_set.advanceToNextRow());
+    EXPECT_EQ("2020-06-30 23:00:00", native_result_set.getCurrentField(0).toString());
+    EXPECT_FALSE(native_result_set.advanceToNextRow());
+}
+
+TEST(ResultSet, Native)
+{
+    RowBinaryWriter writer;
+
+    auto write_block = [&] (std::size_t first_row, std::size_t num_rows) {
+        writer.writeVarUInt(5);
+        writer.writeVarUInt(num_rows);
+
+        writer.writeString("u32");
+        writer.writeString("UInt32");
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.write<uint32_t>(static_cast<uint32_t>(first_row + i));
+
+        writer.writeString("f");
+        writer.writeString("Nullable(Float64)");
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.write<uint8_t>((first_row + i) % 3 == 0);
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.write<double>((first_row + i) % 3 == 0 ? 0 : (first_row + i) * 0.25);
+
+        writer.writeString("s");
+        writer.writeString("String");
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.writeString("s" + std::to_string(first_row + i));
+
+        writer.writeString("arr");
+        writer.writeString("Array(Nullable(String))");
+        // Every array holds (row % 3) elements: NULL, then 'x', then 'y'.
+        uint64_t offset = 0;
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            offset += (first_row + i) % 3;
+            writer.write<uint64_t>(offset);
+        }
+        std::vector<std::string> elements;
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            for (std::size_t k = 0; k < (first_row + i) % 3; ++k)
+                elements.push_back(k == 0 ? "" : (k == 1 ? "x" : "y"));
+        }
+        for (const auto & element : elements)
+            writer.write<uint8_t>(element.empty());
+        for (const auto & element : elements)
+            writer.writeString(element);
+
+        writer.writeString("m");
+        writer.writeString("Map(String, Tuple(UInt8, Date))");
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.write<uint64_t>(i + 1); // A single element in every map.
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.writeString("k");
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.write<uint8_t>(static_cast<uint8_t>(first_row + i));
+        for (std::size_t i = 0; i < num_rows; ++i)
+            writer.write<uint16_t>(18262);
+    };
+
+    write_block(0, 0); // Header only.
+    write_block(0, 70);
+    write_block(70, 0);
+    write_block(70, 130);
+
+    std::istringstream in(writer.data);
+    NativeResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "");
+
+    ASSERT_EQ(5u, result_set.getNumColumns());
+    EXPECT_EQ("f", result_set.getColumnInfo(1).name);
+    EXPECT_EQ(ValueEncoding::UInt32, result_set.getColumnInfo(0).encoding);
+    EXPECT_EQ(ValueEncoding::Float64, result_set.getColumnInfo(1).encoding);
+    EXPECT_TRUE(result_set.getColumnInfo(1).is_nullable);
+    EXPECT_EQ(ValueEncoding::Text, result_set.getColumnInfo(3).encoding);
+
+    for (std::size_t row = 0; row < 200; ++row) {
+        ASSERT_TRUE(result_set.advanceToNextRow());
+
+        const auto u32 = result_set.getCurrentField(0);
+        EXPECT_EQ(row, u32.getUInt());
+        EXPECT_TRUE(u32.isBinaryOfCType(SQL_C_ULONG));
+        EXPECT_FALSE(u32.isBinaryOfCType(SQL_C_SBIGINT));
+
+        const auto f = result_set.getCurrentField(1);
+        EXPECT_EQ(row % 3 == 0, f.isNull());
+        if (!f.isNull())
+            EXPECT_DOUBLE_EQ(row * 0.25, f.getDouble());
+
+        EXPECT_EQ("s" + std::to_string(row), result_set.getCurrentField(2).toString());
+
+        const std::string expected_arrays[] = {"[]", "[NULL]", "[NULL,'x']"};
+        EXPECT_EQ(expected_arrays[row % 3], result_set.getCurrentField(3).toString());
+
+        EXPECT_EQ("{'k':(" + std::to_string(row) + ",'2020-01-01')}", result_set.getCurrentField(4).toString());
+    }
+
+    EXPECT_FALSE(result_set.advanceToNextRow());
+}
+
+TEST(ResultSet, FixedWidthValues)
+{
+    RowBinaryWriter writer;
+    writer.writeHeader({"u32", "f", "n", "s"}, {"UInt32", "Float64", "Nullable(UInt32)", "String"});
+
+    const std::size_t num_rows = 200;
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        writer.write<uint32_t>(static_cast<uint32_t>(i));
+        writer.write<double>(i * 0.5);
+        if (i == 70) {
+            writer.write<uint8_t>(1);
+        } else {
+            writer.write<uint8_t>(0);
+            writer.write<uint32_t>(static_cast<uint32_t>(i));
+        }
+        writer.writeString("s");
+    }
+
+    std::istringstream in(writer.data);
+    RowBinaryWithNamesAndTypesResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "");
+
+    EXPECT_EQ(nullptr, result_set.getFixedWidthValues(0));
+
+    // The values of a run of rows of a fixed-width column are those of its fields, back to back.
+    ASSERT_EQ(60u, result_set.advanceToNextRows(60));
+    ASSERT_NE(nullptr, result_set.getFixedWidthValues(0));
+    ASSERT_NE(nullptr, result_set.getFixedWidthValues(1));
+    for (std::size_t i = 0; i < 60; ++i) {
+        EXPECT_EQ(result_set.getField(i, 0).data(), result_set.getFixedWidthValues(0) + i * sizeof(uint32_t));
+        EXPECT_EQ(result_set.getField(i, 1).data(), result_set.getFixedWidthValues(1) + i * sizeof(double));
+    }
+    EXPECT_NE(nullptr, result_set.getFixedWidthValues(2));
+    EXPECT_EQ(nullptr, result_set.getFixedWidthValues(3));
+
+    // Not if any of them is NULL.
+    ASSERT_EQ(20u, result_set.advanceToNextRows(20));
+    EXPECT_NE(nullptr, result_set.getFixedWidthValues(0));
+    EXPECT_EQ(nullptr, result_set.getFixedWidthValues(2));
+
+    std::size_t row = 80;
+    while (const auto run_size = result_set.advanceToNextRows(num_rows)) {
+        const auto * values = result_set.getFixedWidthValues(2);
+        ASSERT_NE(nullptr, values);
+        for (std::size_t i = 0; i < run_size; ++i, ++row) {
+            uint32_t value = 0;
+            std::memcpy(&value, values + i * sizeof(value), sizeof(value));
+            EXPECT_EQ(row, value);
+        }
+    }
+
+    EXPECT_EQ(num_rows, row);
+}
+
+TEST(ResultSet, NativeEmpty)
+{
+    std::istringstream in;
+    NativeResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size, "");
+
+    EXPECT_EQ(0u, result_set.getNumColumns());
+    EXPECT_FALSE(result_set.advanceToNextRow());
+}
@@ -0,0 +1,129 @@
+#include <row_store.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+class ODBCDriver2Writer {
+public:
+    void writeSize(int32_t size) {
+        data.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    }
+
+    void writeString(const std::string & value) {
+        writeSize(static_cast<int32_t>(value.size()));
+        data.append(value);
+    }
+
+    void writeNull() {
+        writeSize(-1);
+    }
+
+    void writeHeader(const std::vector<std::string> & names, const std::vector<std::string> & types) {
+        writeSize(2);
+
+        writeSize(static_cast<int32_t>(names.size() + 1));
+        writeString("name");
+        for (const auto & name : names)
+            writeString(name);
+
+        writeSize(static_cast<int32_t>(types.size() + 1));
+        writeString("type");
+        for (const auto & type : types)
+            writeString(type);
+    }
+
+    std::string data;
+};
+
+std::string makeName(std::size_t id) {
+    return "name-" + std::to_string(id) + std::string(id % 50, 'x');
+}
+
+/// Reads all the rows of a result set of (id UInt64, name Nullable(String)), where every 7th name is NULL, into a store.
+void fillStore(std::size_t num_rows, std::size_t memory_limit, std::unique_ptr<RowStore> & store) {
+    ODBCDriver2Writer writer;
+    writer.writeHeader({"id", "name"}, {"UInt64", "Nullable(String)"});
+
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        writer.writeString(std::to_string(i));
+        if (i % 7 == 0)
+            writer.writeNull();
+        else
+            writer.writeString(makeName(i));
+    }
+
+    std::istringstream in(writer.data);
+    ODBCDriver2ResultSet result_set(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size);
+
+    store = std::make_unique<RowStore>(
+        std::vector<ValueEncoding>{result_set.getFieldEncoding(0), result_set.getFieldEncoding(1)},
+        memory_limit
+    );
+
+    while (const auto run_size = result_set.advanceToNextRows(100)) {
+        for (std::size_t i = 0; i < run_size; ++i)
+            store->appendRow(result_set, i);
+    }
+}
+
+void checkStore(const RowStore & store, std::size_t num_rows) {
+    ASSERT_EQ(num_rows, store.getNumRows());
+    ASSERT_EQ(2u, store.getNumColumns());
+
+    std::vector<Field> fields;
+
+    // Backwards, the way a scrolling application would revisit the rows.
+    for (std::size_t i = num_rows; i-- > 0;) {
+        store.getRow(i, fields);
+        ASSERT_EQ(2u, fields.size());
+
+        EXPECT_FALSE(fields[0].isNull());
+        EXPECT_EQ(i, fields[0].getUInt());
+
+        if (i % 7 == 0) {
+            EXPECT_TRUE(fields[1].isNull());
+        }
+        else {
+            ASSERT_FALSE(fields[1].isNull());
+            EXPECT_EQ(makeName(i), fields[1].toString());
+        }
+    }
+}
+
+} // namespace
+
+TEST(RowStore, InMemory)
+{
+    const std::size_t num_rows = 1000;
+    std::unique_ptr<RowStore> store;
+    fillStore(num_rows, 64 << 20, store);
+
+    EXPECT_FALSE(store->isSpilled());
+    EXPECT_GT(store->getByteSize(), 0u);
+    checkStore(*store, num_rows);
+}
+
+TEST(RowStore, Spilled)
+{
+    const std::size_t num_rows = 5000;
+    std::unique_ptr<RowStore> store;
+    fillStore(num_rows, 4096, store);
+
+    EXPECT_TRUE(store->isSpilled());
+    EXPECT_GT(store->getByteSize(), 4096u);
+    checkStore(*store, num_rows);
+}
+
+TEST(RowStore, NoRows)
+{
+    std::unique_ptr<RowStore> store;
+    fillStore(0, 0, store);
+
+    EXPECT_EQ(0u, store->getNumRows());
+    EXPECT_FALSE(store->isSpilled());
+}
@@ -0,0 +1,113 @@
+#include <session_pool.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+namespace {
+
+SessionPool::SessionPtr makeSession() {
+    return SessionPool::SessionPtr(new Poco::Net::HTTPClientSession);
+}
+
+/// Sessions created in the tests never connect, so their health is decided by the tests.
+bool alwaysHealthy(Poco::Net::HTTPClientSession &) {
+    return true;
+}
+
+} // namespace
+
+TEST(SessionPool, AcquireReleased)
+{
+    SessionPool pool(4, std::chrono::minutes(1), alwaysHealthy);
+
+    EXPECT_EQ(nullptr, pool.acquire("http://a:8123"));
+
+    auto first = makeSession();
+    auto second = makeSession();
+    const auto * first_ptr = first.get();
+    const auto * second_ptr = second.get();
+
+    pool.release("http://a:8123", std::move(first));
+    pool.release("http://a:8123", std::move(second));
+    EXPECT_EQ(2u, pool.getNumIdleSessions());
+
+    EXPECT_EQ(nullptr, pool.acquire("http://b:8123"));
+
+    // The most recently released session is the most likely to be still alive on the server.
+    EXPECT_EQ(second_ptr, pool.acquire("http://a:8123").get());
+    EXPECT_EQ(first_ptr, pool.acquire("http://a:8123").get());
+    EXPECT_EQ(nullptr, pool.acquire("http://a:8123"));
+    EXPECT_EQ(0u, pool.getNumIdleSessions());
+}
+
+TEST(SessionPool, MaxIdleSessions)
+{
+    SessionPool pool(2, std::chrono::minutes(1), alwaysHealthy);
+
+    auto oldest = makeSession();
+    const auto * oldest_ptr = oldest.get();
+    pool.release("key", std::move(oldest));
+    pool.release("key", makeSession());
+    pool.release("key", makeSession());
+    pool.release("other", makeSession());
+
+    EXPECT_EQ(3u, pool.getNumIdleSessions());
+
+    EXPECT_NE(oldest_ptr, pool.acquire("key").get());
+    EXPECT_NE(oldest_ptr, pool.acquire("key").get());
+    EXPECT_EQ(nullptr, pool.acquire("key"));
+
+    SessionPool disabled(0, std::chrono::minutes(1), alwaysHealthy);
+    disabled.release("key", makeSession());
+    EXPECT_EQ(0u, disabled.getNumIdleSessions());
+}
+
+TEST(SessionPool, IdleTimeout)
+{
+    SessionPool pool(4, std::chrono::milliseconds(0), alwaysHealthy);
+
+    pool.release("key", makeSession());
+    EXPECT_EQ(nullptr, pool.acquire("key"));
+    EXPECT_EQ(0u, pool.getNumIdleSessions());
+}
+
+TEST(SessionPool, HealthCheck)
+{
+    std::set<const Poco::Net::HTTPClientSession *> broken;
+    SessionPool pool(4, std::chrono::minutes(1), [&] (Poco::Net::HTTPClientSession & session) {
+        return broken.count(&session) == 0;
+    });
+
+    auto healthy = makeSession();
+    auto closed_while_idle = makeSession();
+    auto closed_before_release = makeSession();
+    const auto * healthy_ptr = healthy.get();
+    const auto * closed_while_idle_ptr = closed_while_idle.get();
+
+    pool.release("key", std::move(healthy));
+    pool.release("key", std::move(closed_while_idle));
+
+    // Not taken in at all.
+    broken.insert(closed_before_release.get());
+    pool.release("key", std::move(closed_before_release));
+    EXPECT_EQ(2u, pool.getNumIdleSessions());
+
+    // Skipped and dropped, even though it is the most recently released one.
+    broken.insert(closed_while_idle_ptr);
+
+    EXPECT_EQ(healthy_ptr, pool.acquire("key").get());
+    EXPECT_EQ(nullptr, pool.acquire("key"));
+}
+
+TEST(SessionPool, Clear)
+{
+    SessionPool pool(4, std::chrono::minutes(1), alwaysHealthy);
+
+    pool.release("a", makeSession());
+    pool.release("b", makeSession());
+    pool.clear();
+
+    EXPECT_EQ(0u, pool.getNumIdleSessions());
+    EXPECT_EQ(nullptr, pool.acquire("a"));
+}
@@ -0,0 +1,254 @@
+#include <driver.h>
+#include <environment.h>
+#include <connection.h>
+#include <statement.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+class ODBCDriver2Writer {
+public:
+    void writeSize(int32_t size) {
+        data.append(reinterpret_cast<const char *>(&size), sizeof(size));
+    }
+
+    void writeString(const std::string & value) {
+        writeSize(static_cast<int32_t>(value.size()));
+        data.append(value);
+    }
+
+    void writeHeader(const std::vector<std::string> & names, const std::vector<std::string> & types) {
+        writeSize(2);
+
+        writeSize(static_cast<int32_t>(names.size() + 1));
+        writeString("name");
+        for (const auto & name : names)
+            writeString(name);
+
+        writeSize(static_cast<int32_t>(types.size() + 1));
+        writeString("type");
+        for (const auto & type : types)
+            writeString(type);
+    }
+
+    std::string data;
+};
+
+std::string makeName(std::size_t id) {
+    return "name-" + std::to_string(id) + std::string(id % 50, 'x');
+}
+
+class StaticCursor
+    : public ::testing::Test
+{
+protected:
+    virtual void SetUp() override {
+        auto & environment = Driver::getInstance().allocateChild<Environment>();
+        environment_handle = environment.getHandle();
+        connection = &environment.allocateChild<Connection>();
+        statement = &connection->allocateChild<Statement>();
+    }
+
+    virtual void TearDown() override {
+        Driver::getInstance().deallocateChild<Environment>(environment_handle);
+    }
+
+    /// Make the result set of (id UInt64, name String), where ids are the 1-based numbers of the rows, current
+    /// for a static cursor, with its rows past 'memory_limit' bytes spilled to a file.
+    void open(std::size_t num_rows, int64_t memory_limit = -1) {
+        ODBCDriver2Writer writer;
+        writer.writeHeader({"id", "name"}, {"UInt64", "String"});
+
+        for (std::size_t id = 1; id <= num_rows; ++id) {
+            writer.writeString(std::to_string(id));
+            writer.writeString(makeName(id));
+        }
+
+        in.str(writer.data);
+
+        connection->cursor_memory_limit = memory_limit;
+        statement->setAttr(SQL_ATTR_CURSOR_TYPE, SQL_CURSOR_STATIC);
+        statement->setResultSet(std::make_unique<ODBCDriver2ResultSet>(in, IResultMutatorPtr{}, BufferedReader::default_chunk_size));
+    }
+
+    /// Fetch a rowset, and describe it as "<first row>-<last row>", or "no data", followed by the SQLSTATE
+    /// of the warning, if any. The rows are checked to be those the description says.
+    std::string fetch(SQLSMALLINT orientation, SQLLEN offset, SQLULEN rowset_size) {
+        statement->resetDiag();
+
+        SQLULEN rows_fetched = 0;
+        std::vector<SQLUSMALLINT> row_statuses(rowset_size, SQL_ROW_ERROR);
+        const auto rc = statement->fetchRowset(orientation, offset, rowset_size, &rows_fetched, row_statuses.data());
+
+        if (rc == SQL_NO_DATA) {
+            EXPECT_FALSE(statement->hasCurrentRow());
+            return "no data";
+        }
+
+        EXPECT_TRUE(rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO);
+        EXPECT_LE(1u, rows_fetched);
+        EXPECT_GE(rowset_size, rows_fetched);
+
+        for (std::size_t i = 0; i < rowset_size; ++i)
+            EXPECT_EQ((i < rows_fetched ? SQL_ROW_SUCCESS : SQL_ROW_NOROW), row_statuses[i]);
+
+        const auto first = statement->getCurrentRowNum();
+        EXPECT_EQ(first, statement->getCurrentField(0).getUInt());
+        EXPECT_EQ(makeName(first), statement->getCurrentField(1).toString());
+
+        auto description = std::to_string(first) + "-" + std::to_string(first + rows_fetched - 1);
+        if (rc == SQL_SUCCESS_WITH_INFO)
+            description += " " + statement->getDiagStatus(1).getAttrAs<std::string>(SQL_DIAG_SQLSTATE);
+
+        return description;
+    }
+
+    SQLHANDLE environment_handle = nullptr;
+    Connection * connection = nullptr;
+    Statement * statement = nullptr;
+    std::istringstream in;
+};
+
+} // namespace
+
+TEST_F(StaticCursor, Next) {
+    open(10);
+
+    EXPECT_EQ("1-3", fetch(SQL_FETCH_NEXT, 0, 3));
+    EXPECT_EQ("4-6", fetch(SQL_FETCH_NEXT, 0, 3));
+    EXPECT_EQ("7-9", fetch(SQL_FETCH_NEXT, 0, 3));
+    EXPECT_EQ("10-10", fetch(SQL_FETCH_NEXT, 0, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_NEXT, 0, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_NEXT, 0, 3));
+}
+
+TEST_F(StaticCursor, Prior) {
+    open(10);
+
+    // Before the start.
+    EXPECT_EQ("no data", fetch(SQL_FETCH_PRIOR, 0, 3));
+    EXPECT_EQ("1-3", fetch(SQL_FETCH_NEXT, 0, 3));
+
+    // After the end, the last rowset.
+    EXPECT_EQ("no data", fetch(SQL_FETCH_ABSOLUTE, 11, 3));
+    EXPECT_EQ("8-10", fetch(SQL_FETCH_PRIOR, 0, 3));
+    EXPECT_EQ("5-7", fetch(SQL_FETCH_PRIOR, 0, 3));
+    EXPECT_EQ("2-4", fetch(SQL_FETCH_PRIOR, 0, 3));
+
+    // Partly before the start, moved to the first row.
+    EXPECT_EQ("1-3 01S06", fetch(SQL_FETCH_PRIOR, 0, 3));
+
+    // At the start, before it.
+    EXPECT_EQ("no data", fetch(SQL_FETCH_PRIOR, 0, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_PRIOR, 0, 3));
+    EXPECT_EQ("1-3", fetch(SQL_FETCH_NEXT, 0, 3));
+}
+
+TEST_F(StaticCursor, Relative) {
+    open(10);
+
+    // From before the start.
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, -1, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, 0, 3));
+    EXPECT_EQ("2-4", fetch(SQL_FETCH_RELATIVE, 2, 3));
+
+    EXPECT_EQ("7-9", fetch(SQL_FETCH_RELATIVE, 5, 3));
+    EXPECT_EQ("7-9", fetch(SQL_FETCH_RELATIVE, 0, 3));
+    EXPECT_EQ("10-10", fetch(SQL_FETCH_RELATIVE, 3, 3));
+
+    // Past the end, and from after it.
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, 1, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, 1, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, 0, 3));
+    EXPECT_EQ("10-10", fetch(SQL_FETCH_RELATIVE, -1, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, 5, 3));
+    EXPECT_EQ("1-3", fetch(SQL_FETCH_RELATIVE, -10, 3));
+
+    // Before the start, unless no farther back than the rowset size from a row past the first one.
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, -1, 3));
+    EXPECT_EQ("2-4", fetch(SQL_FETCH_RELATIVE, 2, 3));
+    EXPECT_EQ("1-3 01S06", fetch(SQL_FETCH_RELATIVE, -3, 3));
+    EXPECT_EQ("5-7", fetch(SQL_FETCH_RELATIVE, 4, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_RELATIVE, -5, 3));
+}
+
+TEST_F(StaticCursor, Absolute) {
+    open(10);
+
+    EXPECT_EQ("10-10", fetch(SQL_FETCH_ABSOLUTE, 10, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_ABSOLUTE, 11, 3));
+    EXPECT_EQ("1-3", fetch(SQL_FETCH_ABSOLUTE, 1, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_ABSOLUTE, 0, 3));
+
+    // Counted from the end.
+    EXPECT_EQ("10-10", fetch(SQL_FETCH_ABSOLUTE, -1, 3));
+    EXPECT_EQ("8-10", fetch(SQL_FETCH_ABSOLUTE, -3, 3));
+    EXPECT_EQ("1-3", fetch(SQL_FETCH_ABSOLUTE, -10, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_ABSOLUTE, -11, 3));
+    EXPECT_EQ("1-10 01S06", fetch(SQL_FETCH_ABSOLUTE, -11, 12));
+    EXPECT_EQ("1-10 01S06", fetch(SQL_FETCH_ABSOLUTE, -12, 12));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_ABSOLUTE, -13, 12));
+}
+
+TEST_F(StaticCursor, FirstAndLast) {
+    open(10);
+
+    EXPECT_EQ("8-10", fetch(SQL_FETCH_LAST, 0, 3));
+    EXPECT_EQ("1-3", fetch(SQL_FETCH_FIRST, 0, 3));
+    EXPECT_EQ("1-10", fetch(SQL_FETCH_LAST, 0, 12));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_NEXT, 0, 12));
+    EXPECT_EQ("1-10", fetch(SQL_FETCH_FIRST, 0, 12));
+}
+
+TEST_F(StaticCursor, NoRows) {
+    open(0);
+
+    EXPECT_EQ("no data", fetch(SQL_FETCH_NEXT, 0, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_PRIOR, 0, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_LAST, 0, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_FIRST, 0, 3));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_ABSOLUTE, -1, 3));
+}
+
+TEST_F(StaticCursor, RowsetSizeChanges) {
+    open(10);
+
+    // NEXT moves by the size of the previous rowset, PRIOR by the size of the new one.
+    EXPECT_EQ("1-2", fetch(SQL_FETCH_NEXT, 0, 2));
+    EXPECT_EQ("3-7", fetch(SQL_FETCH_NEXT, 0, 5));
+    EXPECT_EQ("8-8", fetch(SQL_FETCH_NEXT, 0, 1));
+    EXPECT_EQ("9-10", fetch(SQL_FETCH_NEXT, 0, 4));
+    EXPECT_EQ("6-8", fetch(SQL_FETCH_PRIOR, 0, 3));
+    EXPECT_EQ("1-6 01S06", fetch(SQL_FETCH_PRIOR, 0, 6));
+    EXPECT_EQ("7-7", fetch(SQL_FETCH_NEXT, 0, 1));
+
+    // From after the end, PRIOR is the last rowset of the new size.
+    EXPECT_EQ("no data", fetch(SQL_FETCH_ABSOLUTE, 11, 7));
+    EXPECT_EQ("9-10", fetch(SQL_FETCH_PRIOR, 0, 2));
+    EXPECT_EQ("no data", fetch(SQL_FETCH_NEXT, 0, 1));
+}
+
+TEST_F(StaticCursor, Spilled) {
+    const std::size_t num_rows = 2000;
+    open(num_rows, 4096);
+
+    EXPECT_EQ("1-100", fetch(SQL_FETCH_NEXT, 0, 100));
+    EXPECT_EQ("1901-2000", fetch(SQL_FETCH_LAST, 0, 100));
+    EXPECT_EQ("1-1", fetch(SQL_FETCH_FIRST, 0, 1));
+    EXPECT_EQ("1000-1099", fetch(SQL_FETCH_ABSOLUTE, 1000, 100));
+    EXPECT_EQ("900-999", fetch(SQL_FETCH_PRIOR, 0, 100));
+    EXPECT_EQ("1995-2000", fetch(SQL_FETCH_ABSOLUTE, -6, 10));
+
+    for (std::size_t first = 1; first <= num_rows; first += 7) {
+        const auto last = std::min(first + 6, num_rows);
+        EXPECT_EQ(std::to_string(first) + "-" + std::to_string(last), fetch(SQL_FETCH_ABSOLUTE, static_cast<SQLLEN>(first), 7));
+    }
+
+    EXPECT_EQ("no data", fetch(SQL_FETCH_NEXT, 0, 7));
+}
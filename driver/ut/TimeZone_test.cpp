@@ -0,0 +1,215 @@
+#include <time_zone.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Writes TZif files (RFC 8536), with the same data in both the version 1 and the version 2 parts.
+class TZifWriter {
+public:
+    struct Type {
+        int32_t offset;
+        bool is_dst;
+    };
+
+    std::string write(const std::vector<int64_t> & transitions, const std::vector<uint8_t> & type_indices, const std::vector<Type> & types, const std::string & footer) {
+        std::string res;
+        writePart(res, '2', 4, transitions, type_indices, types);
+        writePart(res, '2', 8, transitions, type_indices, types);
+        res += '\n' + footer + '\n';
+        return res;
+    }
+
+private:
+    static void writeInt(std::string & out, int64_t value, std::size_t size) {
+        for (std::size_t i = size; i > 0; --i)
+            out += static_cast<char>((static_cast<uint64_t>(value) >> (8 * (i - 1))) & 0xFF);
+    }
+
+    static void writePart(std::string & out, char version, std::size_t time_size,
+        const std::vector<int64_t> & transitions, const std::vector<uint8_t> & type_indices, const std::vector<Type> & types)
+    {
+        out += "TZif";
+        out += version;
+        out.append(15, '\0');
+
+        const std::string designations = "ABC";
+        for (const auto count : {std::size_t(0), std::size_t(0), std::size_t(0), transitions.size(), types.size(), designations.size() + 1})
+            writeInt(out, static_cast<int64_t>(count), 4);
+
+        for (const auto transition : transitions)
+            writeInt(out, transition, time_size);
+        for (const auto idx : type_indices)
+            out += static_cast<char>(idx);
+        for (const auto & type : types) {
+            writeInt(out, type.offset, 4);
+            out += static_cast<char>(type.is_dst);
+            out += '\0';
+        }
+        out += designations;
+        out += '\0';
+    }
+};
+
+/// Where the tz database is read from, the default one if empty.
+void setTZDIR(const std::string & dir) {
+#if defined(_WIN32)
+    _putenv_s("TZDIR", dir.c_str());
+#else
+    if (dir.empty())
+        unsetenv("TZDIR");
+    else
+        setenv("TZDIR", dir.c_str(), 1);
+#endif
+}
+
+bool hasTimeZoneDatabase() {
+    try {
+        TimeZone::get("Europe/Moscow");
+        return true;
+    } catch (const std::runtime_error &) {
+        return false;
+    }
+}
+
+} // namespace
+
+TEST(TimeZone, UTC)
+{
+    EXPECT_TRUE(TimeZone{}.isUTC());
+    EXPECT_EQ(1577934245, TimeZone{}.toLocal(1577934245));
+
+    for (const auto * name : {"UTC", "Etc/UTC", "GMT", "Zulu"}) {
+        const auto time_zone = TimeZone::get(name);
+        EXPECT_TRUE(time_zone->isUTC()) << name;
+        EXPECT_EQ(0, time_zone->getOffset(1577934245)) << name;
+    }
+
+    EXPECT_EQ(TimeZone::get("UTC"), TimeZone::get("UTC"));
+}
+
+TEST(TimeZone, InvalidNames)
+{
+    EXPECT_THROW(TimeZone::get(""), std::runtime_error);
+    EXPECT_THROW(TimeZone::get("/etc/passwd"), std::runtime_error);
+    EXPECT_THROW(TimeZone::get("../../../etc/passwd"), std::runtime_error);
+    EXPECT_THROW(TimeZone::get("No/Such_Zone"), std::runtime_error);
+}
+
+TEST(TimeZone, FixedPosixRule)
+{
+    const auto time_zone = TimeZone::fromPosixRule("<+03>-3");
+    EXPECT_FALSE(time_zone.isUTC());
+    EXPECT_EQ(3 * 3600, time_zone.getOffset(0));
+    EXPECT_EQ(3 * 3600, time_zone.getOffset(1616893200));
+
+    EXPECT_EQ(-(5 * 3600 + 30 * 60), TimeZone::fromPosixRule("XYZ+5:30").getOffset(0));
+    EXPECT_TRUE(TimeZone::fromPosixRule("UTC0").isUTC());
+}
+
+TEST(TimeZone, DaylightSavingPosixRule)
+{
+    // Switches at 01:00 UTC on the last Sundays of March and October.
+    const auto europe = TimeZone::fromPosixRule("CET-1CEST,M3.5.0,M10.5.0/3");
+    EXPECT_EQ(3600, europe.getOffset(1616893199));
+    EXPECT_EQ(7200, europe.getOffset(1616893200));
+    EXPECT_EQ(7200, europe.getOffset(1635641999));
+    EXPECT_EQ(3600, europe.getOffset(1635642000));
+
+    // The daylight saving time spans the new year.
+    const auto australia = TimeZone::fromPosixRule("AEST-10AEDT,M10.1.0,M4.1.0/3");
+    EXPECT_EQ(11 * 3600, australia.getOffset(1617465599));
+    EXPECT_EQ(10 * 3600, australia.getOffset(1617465600));
+    EXPECT_EQ(10 * 3600, australia.getOffset(1633190399));
+    EXPECT_EQ(11 * 3600, australia.getOffset(1633190400));
+    EXPECT_EQ(11 * 3600, australia.getOffset(1609459200)); // 2021-01-01
+
+    // The rules of the United States are the default ones.
+    const auto america = TimeZone::fromPosixRule("EST5EDT");
+    EXPECT_EQ(-5 * 3600, america.getOffset(1615705199));
+    EXPECT_EQ(-4 * 3600, america.getOffset(1615705200));
+    EXPECT_EQ(-4 * 3600, america.getOffset(1636264799));
+    EXPECT_EQ(-5 * 3600, america.getOffset(1636264800));
+
+    // Julian days: from March 1 (day 60, February 29 is not counted), at 02:00 of the standard time.
+    const auto julian = TimeZone::fromPosixRule("AAA0BBB,J60,J305");
+    EXPECT_EQ(0, julian.getOffset(1614563999));    // 2021-03-01 01:59:59
+    EXPECT_EQ(3600, julian.getOffset(1614564000)); // 2021-03-01 02:00:00
+}
+
+TEST(TimeZone, MalformedPosixRule)
+{
+    for (const auto * rule : {"", "C", "CET", "CET-1CEST,M13.5.0,M10.5.0", "CET-1CEST,M3.5.0", "CET-1CEST,M3.5.0,M10.5.0/", "<>1", "CET-1CEST,M3.5.0,M10.5.0x"})
+        EXPECT_THROW(TimeZone::fromPosixRule(rule), std::runtime_error) << rule;
+}
+
+TEST(TimeZone, TZif)
+{
+    TZifWriter writer;
+    const auto data = writer.write({-100000, 1000000}, {1, 2}, {{0, false}, {3600, false}, {7200, true}}, "<+02>-2");
+
+    const auto time_zone = TimeZone::fromTZif(data);
+    EXPECT_FALSE(time_zone.isUTC());
+    EXPECT_EQ(0, time_zone.getOffset(-100001));
+    EXPECT_EQ(3600, time_zone.getOffset(-100000));
+    EXPECT_EQ(3600, time_zone.getOffset(999999));
+    EXPECT_EQ(7200, time_zone.getOffset(1000000));
+    EXPECT_EQ(7200, time_zone.getOffset(4086547200));
+
+    // Without a rule, the last offset stays.
+    const auto without_rule = TimeZone::fromTZif(writer.write({0}, {1}, {{0, false}, {-3600, false}}, ""));
+    EXPECT_EQ(0, without_rule.getOffset(-1));
+    EXPECT_EQ(-3600, without_rule.getOffset(4086547200));
+
+    // Only a rule.
+    const auto only_rule = TimeZone::fromTZif(writer.write({}, {}, {{0, false}}, "UTC0"));
+    EXPECT_TRUE(only_rule.isUTC());
+}
+
+TEST(TimeZone, MalformedTZif)
+{
+    TZifWriter writer;
+    const auto data = writer.write({-100000, 1000000}, {1, 2}, {{0, false}, {3600, false}, {7200, true}}, "<+02>-2");
+
+    for (std::size_t size = 0; size < data.size(); size += 7)
+        EXPECT_THROW(TimeZone::fromTZif(data.substr(0, size)), std::runtime_error) << size;
+
+    EXPECT_THROW(TimeZone::fromTZif("TZjf" + data.substr(4)), std::runtime_error);
+    EXPECT_THROW(TimeZone::fromTZif(writer.write({1}, {5}, {{0, false}}, "")), std::runtime_error);
+    EXPECT_THROW(TimeZone::fromTZif(writer.write({2, 1}, {0, 0}, {{0, false}}, "")), std::runtime_error);
+}
+
+TEST(TimeZone, SystemDatabase)
+{
+    // Not every system has one.
+    if (!hasTimeZoneDatabase())
+        return;
+
+    const auto moscow = TimeZone::get("Europe/Moscow");
+    EXPECT_EQ(moscow, TimeZone::get("Europe/Moscow"));
+    EXPECT_EQ(4 * 3600, moscow->getOffset(1277942400)); // 2010-07-01, summer time
+    EXPECT_EQ(4 * 3600, moscow->getOffset(1325376000)); // 2012-01-01, permanent summer time
+    EXPECT_EQ(3 * 3600, moscow->getOffset(1420070400)); // 2015-01-01
+    EXPECT_EQ(3 * 3600, moscow->getOffset(1909094400)); // 2030-07-01
+
+    const auto new_york = TimeZone::get("America/New_York");
+    EXPECT_EQ(-4 * 3600, new_york->getOffset(4086547200)); // 2099-07-01, past the transitions of the file
+}
+
+TEST(TimeZone, MissingDatabase)
+{
+    EXPECT_EQ(hasTimeZoneDatabase(), TimeZone::isDatabaseAvailable());
+
+    const char * dir = std::getenv("TZDIR");
+    const std::string saved_dir = (dir ? dir : "");
+
+    setTZDIR("/nonexistent/zoneinfo");
+    EXPECT_FALSE(TimeZone::isDatabaseAvailable());
+    EXPECT_TRUE(TimeZone::get("UTC")->isUTC());
+    setTZDIR(saved_dir);
+}
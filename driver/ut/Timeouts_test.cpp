@@ -0,0 +1,39 @@
+#include <connection.h>
+#include <diagnostics.h>
+
+#include <gtest/gtest.h>
+
+TEST(Timeouts, ReadTimeout)
+{
+    EXPECT_EQ(30, Connection::getReadTimeout(0, 30));
+    EXPECT_EQ(5, Connection::getReadTimeout(5, 30));
+    EXPECT_EQ(30, Connection::getReadTimeout(60, 30));
+
+    // A timeout that is not set does not count as the shorter one.
+    EXPECT_EQ(5, Connection::getReadTimeout(5, 0));
+    EXPECT_EQ(0, Connection::getReadTimeout(0, 0));
+    EXPECT_EQ(5, Connection::getReadTimeout(5, -1));
+}
+
+TEST(Timeouts, SQLState)
+{
+    // The query timeout expires first.
+    EXPECT_EQ("HYT00", Connection::getTimeoutSQLState(5, 30));
+    EXPECT_EQ("HYT00", Connection::getTimeoutSQLState(30, 30));
+    EXPECT_EQ("HYT00", Connection::getTimeoutSQLState(5, 0));
+
+    // The timeout of the connection does.
+    EXPECT_EQ("HYT01", Connection::getTimeoutSQLState(60, 30));
+    EXPECT_EQ("HYT01", Connection::getTimeoutSQLState(0, 30));
+    EXPECT_EQ("HYT01", Connection::getTimeoutSQLState(0, 0));
+}
+
+TEST(Timeouts, ServerError)
+{
+    EXPECT_TRUE(isTimeoutError("HTTP status code: 500\nReceived error:\nCode: 159. DB::Exception: Timeout exceeded: elapsed 5.0 seconds, maximum: 5. (TIMEOUT_EXCEEDED)"));
+    EXPECT_TRUE(isTimeoutError("Code: 159, e.displayText() = DB::Exception: Timeout exceeded: elapsed 5.000 seconds, maximum: 5"));
+
+    EXPECT_FALSE(isTimeoutError("Code: 1590. DB::Exception: Some other error"));
+    EXPECT_FALSE(isTimeoutError("Code: 60. DB::Exception: Table default.t159 doesn't exist"));
+    EXPECT_FALSE(isTimeoutError(""));
+}
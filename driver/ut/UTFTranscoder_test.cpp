@@ -0,0 +1,114 @@
+#include <utf_transcoder.h>
+#include <utils.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// "aé€😀": 1, 2, 3 and 4 bytes in UTF-8, the last one is a surrogate pair in UTF-16.
+const std::string mixed = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+const std::u16string mixed16 = u"aé€\U0001F600";
+
+template <typename CharType>
+std::basic_string<CharType> transcode(const std::string & value, std::size_t capacity, std::size_t & length) {
+    std::vector<CharType> out(capacity + 1, CharType('#'));
+    std::size_t written = 0;
+    length = transcodeUTF8ToWide(value.data(), value.size(), out.data(), capacity, written);
+    EXPECT_EQ(CharType('#'), out[capacity]); // Nothing is written beyond the capacity.
+    return {out.data(), written};
+}
+
+} // namespace
+
+TEST(UTFTranscoder, ToUTF16)
+{
+    std::size_t length = 0;
+
+    EXPECT_EQ(mixed16, transcode<char16_t>(mixed, 100, length));
+    EXPECT_EQ(5u, length);
+
+    // A surrogate pair is never split.
+    EXPECT_EQ(mixed16.substr(0, 3), transcode<char16_t>(mixed, 4, length));
+    EXPECT_EQ(5u, length);
+
+    EXPECT_EQ(std::u16string{}, transcode<char16_t>(mixed, 0, length));
+    EXPECT_EQ(5u, length);
+}
+
+TEST(UTFTranscoder, ToUTF32)
+{
+    std::size_t length = 0;
+
+    EXPECT_EQ(std::u32string(U"aé€\U0001F600"), transcode<char32_t>(mixed, 100, length));
+    EXPECT_EQ(4u, length);
+}
+
+TEST(UTFTranscoder, LongASCII)
+{
+    std::string value;
+    for (std::size_t i = 0; i < 1000; ++i)
+        value += static_cast<char>('a' + i % 26);
+    value += mixed;
+
+    std::u16string expected(value.begin(), value.begin() + 1000);
+    expected += mixed16;
+
+    std::size_t length = 0;
+    EXPECT_EQ(expected, transcode<char16_t>(value, 2000, length));
+    EXPECT_EQ(1005u, length);
+
+    // Truncated in the middle of the bulk-converted part.
+    EXPECT_EQ(expected.substr(0, 37), transcode<char16_t>(value, 37, length));
+    EXPECT_EQ(1005u, length);
+}
+
+TEST(UTFTranscoder, InvalidUTF8)
+{
+    std::size_t length = 0;
+
+    // A stray continuation byte, a truncated sequence, an overlong encoding, and an encoded surrogate.
+    EXPECT_EQ(std::u16string(u"�x�y�z�"), transcode<char16_t>("\x80x\xE2\x82y\xC0\xAFz\xED\xA0\x80", 100, length));
+}
+
+TEST(UTFTranscoder, ToUTF8)
+{
+    std::string out = "prefix:";
+    transcodeWideToUTF8(mixed16.data(), mixed16.size(), out);
+    EXPECT_EQ("prefix:" + mixed, out);
+
+    const std::u32string value32 = U"aé€\U0001F600";
+    out.clear();
+    transcodeWideToUTF8(value32.data(), value32.size(), out);
+    EXPECT_EQ(mixed, out);
+
+    // An unpaired surrogate.
+    const std::u16string broken = u"ab\xD800" u"cdef";
+    out.clear();
+    transcodeWideToUTF8(broken.data(), broken.size(), out);
+    EXPECT_EQ("ab\xEF\xBF\xBD" "cdef", out);
+}
+
+TEST(UTFTranscoder, FillOutputUSC2String)
+{
+    using CharType = MY_STD_W_CHAR;
+    CharType out[4] = {};
+    SQLLEN length = 0;
+
+    EXPECT_EQ(SQL_SUCCESS_WITH_INFO, fillOutputUSC2String(std::string("abcdef"), out, SQLLEN(sizeof(out)), &length));
+    EXPECT_EQ(static_cast<SQLLEN>(6 * sizeof(CharType)), length);
+    EXPECT_EQ(CharType('c'), out[2]);
+    EXPECT_EQ(CharType(0), out[3]);
+
+    EXPECT_EQ(SQL_SUCCESS, fillOutputUSC2String(std::string("abc"), out, SQLLEN(sizeof(out)), &length));
+    EXPECT_EQ(static_cast<SQLLEN>(3 * sizeof(CharType)), length);
+    EXPECT_EQ(CharType(0), out[3]);
+
+    EXPECT_EQ(SQL_SUCCESS, fillOutputUSC2String(std::string("abcdef"), static_cast<CharType *>(nullptr), SQLLEN(0), &length));
+    EXPECT_EQ(static_cast<SQLLEN>(6 * sizeof(CharType)), length);
+
+    EXPECT_EQ(SQL_SUCCESS, fillOutputUSC2String(std::string("ab"), out, SQLLEN(4), &length, false));
+    EXPECT_EQ(2, length);
+}
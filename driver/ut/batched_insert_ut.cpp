@@ -0,0 +1,81 @@
+#include <escaping/batched_insert.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+const std::string p1 = "@3f2b1c4d-0000-4000-8000-000000000001";
+const std::string p2 = "@3f2b1c4d-0000-4000-8000-000000000002";
+
+/// The head of the INSERT, or "-" if it is not batchable.
+std::string split(const std::string & query, const std::vector<std::string> & placeholders = {p1, p2}) {
+    std::string insert_head;
+    if (!splitBatchableInsert(query, placeholders, insert_head))
+        return "-";
+    return insert_head;
+}
+
+} // namespace
+
+TEST(BatchedInsertCase, SingleRow) {
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO t ");
+    ASSERT_EQ(split("  insert into t (a, b) values(" + p1 + "," + p2 + ")  "), "insert into t (a, b) ");
+    ASSERT_EQ(split("INSERT INTO db.t (a, b)VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO db.t (a, b)");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ")", {p1}), "INSERT INTO t ");
+}
+
+TEST(BatchedInsertCase, TrailingSemicolon) {
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ");"), "INSERT INTO t ");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ") ; \n"), "INSERT INTO t ");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + "); SELECT 1"), "-");
+}
+
+TEST(BatchedInsertCase, Settings) {
+    ASSERT_EQ(split("INSERT INTO t (a, b) SETTINGS async_insert = 1, wait_for_async_insert = 1 VALUES (" + p1 + ", " + p2 + ")"),
+        "INSERT INTO t (a, b) SETTINGS async_insert = 1, wait_for_async_insert = 1 ");
+}
+
+TEST(BatchedInsertCase, SeveralRows) {
+    const std::string p3 = "@3f2b1c4d-0000-4000-8000-000000000003";
+    const std::string p4 = "@3f2b1c4d-0000-4000-8000-000000000004";
+
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + "), (" + p3 + ", " + p4 + ")", {p1, p2, p3, p4}), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + "), (1, 2)"), "-");
+}
+
+TEST(BatchedInsertCase, NotAllParameters) {
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", 1, " + p2 + ")"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p2 + ", " + p1 + ")"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ")"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ")", {p1}), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + " + 1)"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES ()", {}), "-");
+}
+
+TEST(BatchedInsertCase, In) {
+    ASSERT_EQ(split("INSERT INTO t SELECT * FROM s WHERE a IN (" + p1 + ", " + p2 + ")"), "-");
+    ASSERT_EQ(split("INSERT INTO t SELECT * FROM values(" + p1 + ", " + p2 + ")"), "-");
+    ASSERT_EQ(split("INSERT INTO t SELECT * FROM s WHERE a IN (SELECT b FROM u VALUES (" + p1 + ", " + p2 + "))"), "-");
+    ASSERT_EQ(split("SELECT * FROM s WHERE a IN (" + p1 + ", " + p2 + ")"), "-");
+}
+
+TEST(BatchedInsertCase, QuotedValues) {
+    ASSERT_EQ(split("INSERT INTO t SELECT 'VALUES (" + p1 + ", " + p2 + ")'"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ") -- VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO t ");
+    ASSERT_EQ(split("INSERT INTO t /* VALUES ( */ VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO t /* VALUES ( */ ");
+    ASSERT_EQ(split("INSERT INTO `values` (\"VALUES\", 'x') VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO `values` (\"VALUES\", 'x') ");
+    ASSERT_EQ(split("INSERT INTO values VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO values ");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", '" + p2 + "')"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ") 'it''s'"), "-");
+    ASSERT_EQ(split("INSERT INTO \"my table\" (`a b`, \"c\"\"d\") VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO \"my table\" (`a b`, \"c\"\"d\") ");
+    ASSERT_EQ(split("INSERT INTO t SETTINGS x='VALUES (' VALUES (" + p1 + ", " + p2 + ")"), "INSERT INTO t SETTINGS x='VALUES (' ");
+}
+
+TEST(BatchedInsertCase, Malformed) {
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ")) "), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES ((" + p1 + ", " + p2 + ")"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ") 'unclosed"), "-");
+    ASSERT_EQ(split("INSERT INTO t VALUES (" + p1 + ", " + p2 + ") /* unclosed"), "-");
+    ASSERT_EQ(split("INSERT INTO t FORMAT Values (" + p1 + ", " + p2 + ")"), "-");
+    ASSERT_EQ(split("INSERT INTO t FROM INFILE 'data' VALUES (" + p1 + ", " + p2 + ")"), "-");
+    ASSERT_EQ(split(""), "-");
+}
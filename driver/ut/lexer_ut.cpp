@@ -21,3 +21,55 @@ TEST(LexerCase, ParseIdent) {
     tok = Lexer("Custom_SQL_Query.amount").Consume();
     ASSERT_STREQ(tok.literal.to_string().c_str(), "Custom_SQL_Query.amount");
 }
+
+TEST(LexerCase, ParseQuotedIdent) {
+    auto tok = Lexer("\"quoted ident\"").Consume();
+    ASSERT_EQ(tok.type, Token::IDENT);
+    ASSERT_EQ(tok.literal, "\"quoted ident\"");
+    tok = Lexer("`table name`.\"field\"").Consume();
+    ASSERT_EQ(tok.type, Token::IDENT);
+    ASSERT_EQ(tok.literal, "`table name`.\"field\"");
+    tok = Lexer("`a``b\\`c`").Consume();
+    ASSERT_EQ(tok.type, Token::IDENT);
+    ASSERT_EQ(tok.literal, "`a``b\\`c`");
+    tok = Lexer("\"unclosed").Consume();
+    ASSERT_EQ(tok.type, Token::INVALID);
+}
+
+TEST(LexerCase, ParseComment) {
+    Lexer lex("a -- (b\n/* c) */ d /* unclosed");
+    ASSERT_EQ(lex.Consume().literal, "a");
+    ASSERT_EQ(lex.Consume().literal, "d");
+    ASSERT_EQ(lex.Consume().type, Token::INVALID);
+    ASSERT_EQ(lex.Consume().type, Token::EOS);
+
+    Lexer spaces("a/* b */-- c");
+    spaces.SetEmitSpaces(true);
+    ASSERT_EQ(spaces.Consume().type, Token::IDENT);
+    auto tok = spaces.Consume();
+    ASSERT_EQ(tok.type, Token::COMMENT);
+    ASSERT_EQ(tok.literal, "/* b */");
+    tok = spaces.Consume();
+    ASSERT_EQ(tok.type, Token::COMMENT);
+    ASSERT_EQ(tok.literal, "-- c");
+    ASSERT_EQ(spaces.Consume().type, Token::EOS);
+}
+
+TEST(LexerCase, ParseDelimiters) {
+    Lexer lex("(@3f2b1c4d-0000-4000-8000-000000000001,'it''s')=(1);");
+    ASSERT_EQ(lex.Consume().type, Token::LPARENT);
+    auto tok = lex.Consume();
+    ASSERT_EQ(tok.type, Token::IDENT);
+    ASSERT_EQ(tok.literal, "@3f2b1c4d-0000-4000-8000-000000000001");
+    ASSERT_EQ(lex.Consume().type, Token::COMMA);
+    tok = lex.Consume();
+    ASSERT_EQ(tok.type, Token::STRING);
+    ASSERT_EQ(tok.literal, "'it''s'");
+    ASSERT_EQ(lex.Consume().type, Token::RPARENT);
+    ASSERT_EQ(lex.Consume().type, Token::OTHER);
+    ASSERT_EQ(lex.Consume().type, Token::LPARENT);
+    ASSERT_EQ(lex.Consume().type, Token::NUMBER);
+    ASSERT_EQ(lex.Consume().type, Token::RPARENT);
+    ASSERT_EQ(lex.Consume().type, Token::SEMICOLON);
+    ASSERT_EQ(lex.Consume().type, Token::EOS);
+}
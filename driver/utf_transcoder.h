@@ -0,0 +1,233 @@
+#pragma once
+
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#    include <emmintrin.h>
+#    define UTF_TRANSCODER_SSE2 1
+#else
+#    define UTF_TRANSCODER_SSE2 0
+#endif
+
+/// Conversions between UTF-8 and the wide strings of ODBC, without intermediate strings or locales.
+/// The wide side is UTF-16 for 2-byte code units and UTF-32 for 4-byte ones, so that the same code serves
+/// SQLWCHAR and wchar_t on every platform. Invalid input is replaced with U+FFFD instead of failing.
+
+namespace utf_transcoder_detail {
+
+constexpr uint32_t replacement_character = 0xFFFD;
+
+inline bool isASCII(uint64_t chunk) {
+    return (chunk & 0x8080808080808080) == 0;
+}
+
+/// Decode one character at 'p' (which must be before 'end'), advancing 'p' past it.
+inline uint32_t decodeUTF8(const unsigned char * & p, const unsigned char * end) {
+    const unsigned char lead = *p++;
+
+    if (lead < 0x80)
+        return lead;
+
+    std::size_t length = 0;
+    uint32_t code_point = 0;
+    uint32_t min_code_point = 0;
+
+    if ((lead & 0xE0) == 0xC0) {
+        length = 1;
+        code_point = lead & 0x1F;
+        min_code_point = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 2;
+        code_point = lead & 0x0F;
+        min_code_point = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 3;
+        code_point = lead & 0x07;
+        min_code_point = 0x10000;
+    } else {
+        return replacement_character;
+    }
+
+    for (std::size_t i = 0; i < length; ++i) {
+        // A truncated sequence is replaced as a whole, the byte that interrupted it starts the next character.
+        if (p == end || (*p & 0xC0) != 0x80)
+            return replacement_character;
+        code_point = (code_point << 6) | (*p++ & 0x3F);
+    }
+
+    // Overlong encodings, surrogates, and values beyond Unicode.
+    if (code_point < min_code_point || (code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF)
+        return replacement_character;
+
+    return code_point;
+}
+
+template <typename CharType>
+inline std::size_t wideLength(uint32_t code_point) {
+    return (sizeof(CharType) == 2 && code_point > 0xFFFF ? 2 : 1);
+}
+
+template <typename CharType>
+inline void encodeWide(uint32_t code_point, CharType * out) {
+    if (sizeof(CharType) == 2 && code_point > 0xFFFF) {
+        code_point -= 0x10000;
+        out[0] = static_cast<CharType>(0xD800 + (code_point >> 10));
+        out[1] = static_cast<CharType>(0xDC00 + (code_point & 0x3FF));
+    } else {
+        out[0] = static_cast<CharType>(code_point);
+    }
+}
+
+/// Widen a run of ASCII characters, as long as there is room for it. Returns the number of characters widened.
+template <typename CharType>
+inline std::size_t widenASCII(const unsigned char * p, std::size_t size, CharType * out, std::size_t out_capacity) {
+    std::size_t i = 0;
+    const std::size_t limit = (size < out_capacity ? size : out_capacity);
+
+#if UTF_TRANSCODER_SSE2
+    if (sizeof(CharType) == 2) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= limit; i += 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            if (_mm_movemask_epi8(chunk))
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(chunk, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(chunk, zero));
+        }
+    }
+#endif
+
+    for (; i + 8 <= limit; i += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, p + i, sizeof(chunk));
+        if (!isASCII(chunk))
+            break;
+        for (std::size_t j = 0; j < 8; ++j)
+            out[i + j] = static_cast<CharType>(p[i + j]);
+    }
+
+    return i;
+}
+
+/// Count a run of ASCII characters.
+inline std::size_t countASCII(const unsigned char * p, std::size_t size) {
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, p + i, sizeof(chunk));
+        if (!isASCII(chunk))
+            break;
+    }
+    return i;
+}
+
+} // namespace utf_transcoder_detail
+
+/// Transcode UTF-8 into 'out', writing as many whole characters as fit into 'out_capacity' code units (never a half of a surrogate pair).
+/// 'out' may be null if 'out_capacity' is 0. Returns the length of the complete result, in code units, and sets 'written'
+/// to the number of code units actually written. No terminating zero is written.
+template <typename CharType>
+std::size_t transcodeUTF8ToWide(const char * data, std::size_t size, CharType * out, std::size_t out_capacity, std::size_t & written) {
+    using namespace utf_transcoder_detail;
+
+    const auto * p = reinterpret_cast<const unsigned char *>(data);
+    const auto * const end = p + size;
+
+    std::size_t length = 0;
+    bool out_full = (out_capacity == 0);
+    written = 0;
+
+    while (p < end) {
+        if (*p < 0x80) {
+            // Runs of ASCII are the common case: widen them in bulk while there is room, then only count them.
+            const std::size_t run = (out_full ? countASCII(p, end - p) : widenASCII(p, end - p, out + length, out_capacity - length));
+            if (run) {
+                p += run;
+                length += run;
+                if (!out_full)
+                    written = length;
+                continue;
+            }
+        }
+
+        const auto code_point = decodeUTF8(p, end);
+        const auto units = wideLength<CharType>(code_point);
+
+        if (!out_full && length + units <= out_capacity) {
+            encodeWide(code_point, out + length);
+            written = length + units;
+        } else {
+            out_full = true;
+        }
+
+        length += units;
+    }
+
+    return length;
+}
+
+/// Transcode the wide string [data, data + size) and append the result to 'out'.
+template <typename CharType>
+void transcodeWideToUTF8(const CharType * data, std::size_t size, std::string & out) {
+    using namespace utf_transcoder_detail;
+
+    const auto start = out.size();
+    // Enough for any input, shrunk at the end.
+    out.resize(start + size * 3 + (sizeof(CharType) == 4 ? size : 0));
+    auto * dst = reinterpret_cast<unsigned char *>(&out[start]);
+
+    std::size_t i = 0;
+    while (i < size) {
+        // ASCII fast path.
+        while (i + 4 <= size && ((static_cast<uint32_t>(data[i]) | static_cast<uint32_t>(data[i + 1]) |
+            static_cast<uint32_t>(data[i + 2]) | static_cast<uint32_t>(data[i + 3])) < 0x80)
+        ) {
+            dst[0] = static_cast<unsigned char>(data[i]);
+            dst[1] = static_cast<unsigned char>(data[i + 1]);
+            dst[2] = static_cast<unsigned char>(data[i + 2]);
+            dst[3] = static_cast<unsigned char>(data[i + 3]);
+            dst += 4;
+            i += 4;
+        }
+
+        if (i == size)
+            break;
+
+        uint32_t code_point = static_cast<uint32_t>(data[i++]);
+
+        if (sizeof(CharType) == 2) {
+            code_point &= 0xFFFF;
+            if (code_point >= 0xD800 && code_point <= 0xDBFF && i < size &&
+                (static_cast<uint32_t>(data[i]) & 0xFFFF) >= 0xDC00 && (static_cast<uint32_t>(data[i]) & 0xFFFF) <= 0xDFFF
+            ) {
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + ((static_cast<uint32_t>(data[i]) & 0xFFFF) - 0xDC00);
+                ++i;
+            }
+        }
+
+        if ((code_point >= 0xD800 && code_point <= 0xDFFF) || code_point > 0x10FFFF)
+            code_point = replacement_character;
+
+        if (code_point < 0x80) {
+            *dst++ = static_cast<unsigned char>(code_point);
+        } else if (code_point < 0x800) {
+            *dst++ = static_cast<unsigned char>(0xC0 | (code_point >> 6));
+            *dst++ = static_cast<unsigned char>(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            *dst++ = static_cast<unsigned char>(0xE0 | (code_point >> 12));
+            *dst++ = static_cast<unsigned char>(0x80 | ((code_point >> 6) & 0x3F));
+            *dst++ = static_cast<unsigned char>(0x80 | (code_point & 0x3F));
+        } else {
+            *dst++ = static_cast<unsigned char>(0xF0 | (code_point >> 18));
+            *dst++ = static_cast<unsigned char>(0x80 | ((code_point >> 12) & 0x3F));
+            *dst++ = static_cast<unsigned char>(0x80 | ((code_point >> 6) & 0x3F));
+            *dst++ = static_cast<unsigned char>(0x80 | (code_point & 0x3F));
+        }
+    }
+
+    out.resize(dst - reinterpret_cast<unsigned char *>(&out[0]));
+}
@@ -4,6 +4,7 @@
 #include "type_info.h"
 #include "string_ref.h"
 #include "unicode_t.h"
+#include "utf_transcoder.h"
 
 #ifndef NDEBUG
 #    if USE_DEBUG_17
@@ -289,26 +290,44 @@ RETCODE fillOutputStringImpl(
     return SQL_SUCCESS;
 }
 
-template <typename PTR, typename LENGTH>
-RETCODE fillOutputRawString(const std::string & value, PTR out_value, LENGTH out_value_max_length, LENGTH * out_value_length) {
+template <typename STRING, typename PTR, typename LENGTH>
+RETCODE fillOutputRawString(const STRING & value, PTR out_value, LENGTH out_value_max_length, LENGTH * out_value_length) {
     return fillOutputStringImpl(value, out_value, out_value_max_length, out_value_length, true);
 }
 
-template <typename PTR, typename LENGTH>
+template <typename STRING, typename PTR, typename LENGTH>
 RETCODE fillOutputUSC2String(
-    const std::string & value, PTR out_value, LENGTH out_value_max_length, LENGTH * out_value_length, bool length_in_bytes = true) {
+    const STRING & value, PTR out_value, LENGTH out_value_max_length, LENGTH * out_value_length, bool length_in_bytes = true) {
     using CharType = MY_STD_W_CHAR;
 
-    return fillOutputStringImpl(
-#if ODBC_CHAR16
-        std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t>().from_bytes(value),
-#else
-        std::wstring_convert<std::codecvt_utf8<CharType>, CharType>().from_bytes(value),
-#endif
-        out_value,
-        out_value_max_length,
-        out_value_length,
-        length_in_bytes);
+    // Transcoded straight into the buffer, leaving room for the terminating zero.
+    std::size_t capacity = 0;
+    if (out_value && out_value_max_length > 0)
+        capacity = (length_in_bytes ? static_cast<std::size_t>(out_value_max_length) / sizeof(CharType) : static_cast<std::size_t>(out_value_max_length));
+
+    auto * out = reinterpret_cast<CharType *>(out_value);
+    std::size_t written = 0;
+    const auto symbols = transcodeUTF8ToWide(value.data(), value.size(), out, (capacity ? capacity - 1 : 0), written);
+
+    if (out_value_length) {
+        if (length_in_bytes)
+            *out_value_length = static_cast<LENGTH>(symbols * sizeof(CharType));
+        else
+            *out_value_length = static_cast<LENGTH>(symbols);
+    }
+
+    if (out_value_max_length < 0)
+        return SQL_ERROR;
+
+    if (out_value) {
+        if (capacity)
+            out[written] = 0;
+
+        if (symbols + 1 > capacity)
+            return SQL_SUCCESS_WITH_INFO;
+    }
+
+    return SQL_SUCCESS;
 }
 
 template <typename PTR, typename LENGTH>
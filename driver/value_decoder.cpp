@@ -0,0 +1,880 @@
+#include "value_decoder.h"
+#include "time_zone.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+struct TypeName {
+    std::string name;
+    std::vector<std::string> arguments;
+};
+
+std::string trim(const std::string & str) {
+    const auto begin = str.find_first_not_of(" \t\n");
+    if (begin == std::string::npos)
+        return {};
+    const auto end = str.find_last_not_of(" \t\n");
+    return str.substr(begin, end - begin + 1);
+}
+
+/// Split a type name like "DateTime64(3, 'UTC')" into the name and the top-level arguments.
+TypeName splitTypeName(const std::string & type) {
+    TypeName res;
+
+    const auto lpar = type.find('(');
+    if (lpar == std::string::npos) {
+        res.name = trim(type);
+        return res;
+    }
+
+    res.name = trim(type.substr(0, lpar));
+
+    const auto rpar = type.find_last_of(')');
+    if (rpar == std::string::npos || rpar < lpar)
+        throw std::runtime_error("Cannot parse type " + type);
+
+    std::size_t depth = 0;
+    char quoted_by = '\0';
+    std::string current;
+
+    for (std::size_t i = lpar + 1; i < rpar; ++i) {
+        const char ch = type[i];
+
+        if (quoted_by != '\0') {
+            current += ch;
+            if (ch == '\\' && i + 1 < rpar)
+                current += type[++i];
+            else if (ch == quoted_by)
+                quoted_by = '\0';
+            continue;
+        }
+
+        switch (ch) {
+            case '\'':
+            case '`':
+                quoted_by = ch;
+                break;
+            case '(':
+                ++depth;
+                break;
+            case ')':
+                --depth;
+                break;
+            case ',':
+                if (depth == 0) {
+                    res.arguments.emplace_back(trim(current));
+                    current.clear();
+                    continue;
+                }
+                break;
+        }
+
+        current += ch;
+    }
+
+    if (!trim(current).empty() || !res.arguments.empty())
+        res.arguments.emplace_back(trim(current));
+
+    return res;
+}
+
+/// Named tuple elements look like "name Type" or "`name` Type".
+std::string stripElementName(const std::string & element) {
+    std::size_t pos = 0;
+
+    if (!element.empty() && element[0] == '`') {
+        pos = element.find('`', 1);
+        if (pos == std::string::npos)
+            return element;
+        ++pos;
+    } else {
+        while (pos < element.size() && (std::isalnum(static_cast<unsigned char>(element[pos])) || element[pos] == '_'))
+            ++pos;
+    }
+
+    if (pos < element.size() && element[pos] == ' ')
+        return trim(element.substr(pos));
+
+    return element;
+}
+
+std::size_t getArgumentAsSize(const TypeName & type, std::size_t idx) {
+    if (idx >= type.arguments.size())
+        throw std::runtime_error("Missing argument of type " + type.name);
+    return std::stoul(type.arguments[idx]);
+}
+
+/// The time zone is an optional argument, like in "DateTime('Europe/Moscow')". Values without one are in the time zone of the server.
+std::shared_ptr<const TimeZone> getTimeZone(const TypeName & type, std::size_t idx, const std::string & server_time_zone) {
+    if (idx >= type.arguments.size())
+        return TimeZone::get(server_time_zone.empty() ? "UTC" : server_time_zone);
+
+    const auto & name = type.arguments[idx];
+    if (name.size() < 2 || name.front() != '\'' || name.back() != '\'')
+        throw std::runtime_error("Cannot parse the time zone of type " + type.name);
+
+    return TimeZone::get(name.substr(1, name.size() - 2));
+}
+
+void appendQuoted(std::string & out, const char * data, std::size_t size) {
+    out += '\'';
+    for (std::size_t i = 0; i < size; ++i) {
+        switch (data[i]) {
+            case '\\': out += "\\\\"; break;
+            case '\'': out += "\\'"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\r': out += "\\r"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\0': out += "\\0"; break;
+            default:   out += data[i]; break;
+        }
+    }
+    out += '\'';
+}
+
+void appendMaybeQuoted(std::string & out, const std::string & value, bool quoted) {
+    if (quoted)
+        appendQuoted(out, value.data(), value.size());
+    else
+        out += value;
+}
+
+/// Decimal representation of a little-endian integer of any width multiple of 4 bytes.
+std::string bigIntToString(const char * data, std::size_t size, bool is_signed) {
+    std::vector<uint32_t> limbs(size / sizeof(uint32_t));
+    std::memcpy(limbs.data(), data, limbs.size() * sizeof(uint32_t));
+
+    const bool negative = is_signed && !limbs.empty() && (limbs.back() & 0x80000000u);
+    if (negative) {
+        uint64_t carry = 1;
+        for (auto & limb : limbs) {
+            const uint64_t value = static_cast<uint64_t>(static_cast<uint32_t>(~limb)) + carry;
+            limb = static_cast<uint32_t>(value);
+            carry = value >> 32;
+        }
+    }
+
+    std::string digits;
+    bool is_zero = false;
+    do {
+        uint64_t remainder = 0;
+        is_zero = true;
+        for (std::size_t i = limbs.size(); i-- > 0;) {
+            const uint64_t current = (remainder << 32) | limbs[i];
+            limbs[i] = static_cast<uint32_t>(current / 10);
+            remainder = current % 10;
+            if (limbs[i] != 0)
+                is_zero = false;
+        }
+        digits += static_cast<char>('0' + remainder);
+    } while (!is_zero);
+
+    if (negative)
+        digits += '-';
+
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+/// Read 'count' consecutive fixed-width values, in pieces that fit into the reader buffer.
+template <typename T>
+void readValues(BufferedReader & in, std::vector<T> & out, std::size_t count) {
+    const auto max_piece_size = std::max<std::size_t>(1, in.getChunkSize() / sizeof(T));
+
+    out.resize(count);
+    for (std::size_t pos = 0; pos < count;) {
+        const auto piece_size = std::min(count - pos, max_piece_size);
+        std::memcpy(&out[pos], in.readRaw(piece_size * sizeof(T)), piece_size * sizeof(T));
+        pos += piece_size;
+    }
+}
+
+template <typename T, ValueEncoding Encoding, std::size_t DisplaySize>
+class FixedWidthDecoder : public ValueDecoder {
+public:
+    virtual ValueEncoding getEncoding() const override {
+        return Encoding;
+    }
+
+    virtual std::size_t getDisplaySize() const override {
+        return DisplaySize;
+    }
+
+    virtual void decodeTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx) override {
+        batch.appendValue(column_idx, in.readRaw(sizeof(T)), sizeof(T), false);
+    }
+
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) override {
+        const auto max_piece_size = std::max<std::size_t>(1, in.getChunkSize() / sizeof(T));
+
+        for (std::size_t pos = 0; pos < num_rows;) {
+            const auto piece_size = std::min(num_rows - pos, max_piece_size);
+            batch.appendFixedWidthValues(column_idx, in.readRaw(piece_size * sizeof(T)), piece_size);
+            pos += piece_size;
+        }
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        const auto text = Field{in.readRaw(sizeof(T)), sizeof(T), false, Encoding}.toString();
+        appendMaybeQuoted(out, text, quoted && Encoding == ValueEncoding::Date);
+    }
+};
+
+class BoolDecoder : public ValueDecoder {
+public:
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        out += (*in.readRaw(1) ? "true" : "false");
+    }
+};
+
+class NothingDecoder : public ValueDecoder {
+public:
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        out += "NULL";
+    }
+
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) override {
+        decodeColumnToAsText(in, batch, column_idx, num_rows);
+    }
+
+    virtual void decodeColumnAsText(BufferedReader & in, std::vector<std::string> & out, std::size_t num_rows, bool quoted) override {
+        // Unlike in RowBinary, every value takes a byte in Native.
+        readValues(in, placeholders, num_rows);
+        out.resize(out.size() + num_rows, "NULL");
+    }
+
+private:
+    std::vector<char> placeholders;
+};
+
+class StringDecoder : public ValueDecoder {
+public:
+    virtual void decodeTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx) override {
+        const auto value = in.readBinaryString();
+        batch.appendValue(column_idx, value.data, value.size, false);
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        const auto value = in.readBinaryString();
+        if (quoted)
+            appendQuoted(out, value.data, value.size);
+        else
+            out.append(value.data, value.size);
+    }
+};
+
+class FixedStringDecoder : public ValueDecoder {
+public:
+    explicit FixedStringDecoder(std::size_t size_) : size(size_) {}
+
+    virtual std::size_t getDisplaySize() const override {
+        return size;
+    }
+
+    virtual void decodeTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx) override {
+        batch.appendValue(column_idx, in.readRaw(size), size, false);
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        const auto * data = in.readRaw(size);
+        if (quoted)
+            appendQuoted(out, data, size);
+        else
+            out.append(data, size);
+    }
+
+private:
+    const std::size_t size;
+};
+
+class Date32Decoder : public ValueDecoder {
+public:
+    virtual std::size_t getDisplaySize() const override {
+        return 10;
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        int32_t days = 0;
+        std::memcpy(&days, in.readRaw(sizeof(days)), sizeof(days));
+
+        const auto date = dateFromDays(days);
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d", date.year, date.month, date.day);
+        appendMaybeQuoted(out, buf, quoted);
+    }
+};
+
+/// Values are stored as the wall-clock time of their time zone.
+class DateTimeDecoder : public ValueDecoder {
+public:
+    explicit DateTimeDecoder(std::shared_ptr<const TimeZone> time_zone_) : time_zone(std::move(time_zone_)) {}
+
+    virtual ValueEncoding getEncoding() const override {
+        return ValueEncoding::DateTime;
+    }
+
+    virtual std::size_t getDisplaySize() const override {
+        return 19;
+    }
+
+    virtual void decodeTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx) override {
+        const auto value = read(in.readRaw(sizeof(uint32_t)));
+        batch.appendValue(column_idx, reinterpret_cast<const char *>(&value), sizeof(value), false);
+    }
+
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) override {
+        const auto max_piece_size = std::max<std::size_t>(1, in.getChunkSize() / sizeof(uint32_t));
+
+        for (std::size_t pos = 0; pos < num_rows;) {
+            const auto piece_size = std::min(num_rows - pos, max_piece_size);
+            const auto * data = in.readRaw(piece_size * sizeof(uint32_t));
+
+            values.resize(piece_size);
+            for (std::size_t i = 0; i < piece_size; ++i)
+                values[i] = read(data + i * sizeof(uint32_t));
+
+            batch.appendFixedWidthValues(column_idx, reinterpret_cast<const char *>(values.data()), piece_size);
+            pos += piece_size;
+        }
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        const auto value = read(in.readRaw(sizeof(uint32_t)));
+        const auto text = Field{reinterpret_cast<const char *>(&value), sizeof(value), false, ValueEncoding::DateTime}.toString();
+        appendMaybeQuoted(out, text, quoted);
+    }
+
+private:
+    int64_t read(const char * data) const {
+        uint32_t seconds = 0;
+        std::memcpy(&seconds, data, sizeof(seconds));
+        return time_zone->toLocal(seconds);
+    }
+
+private:
+    const std::shared_ptr<const TimeZone> time_zone;
+    std::vector<int64_t> values;
+};
+
+class DateTime64Decoder : public ValueDecoder {
+public:
+    DateTime64Decoder(std::size_t precision_, std::shared_ptr<const TimeZone> time_zone_)
+        : precision(precision_)
+        , time_zone(std::move(time_zone_))
+    {
+        if (precision > 9)
+            throw std::runtime_error("Unsupported DateTime64 precision " + std::to_string(precision));
+        for (std::size_t i = 0; i < precision; ++i)
+            scale *= 10;
+    }
+
+    virtual std::size_t getDisplaySize() const override {
+        return 19 + (precision ? precision + 1 : 0);
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        int64_t ticks = 0;
+        std::memcpy(&ticks, in.readRaw(sizeof(ticks)), sizeof(ticks));
+
+        int64_t seconds = ticks / scale;
+        int64_t fraction = ticks % scale;
+        if (fraction < 0) {
+            fraction += scale;
+            --seconds;
+        }
+
+        const auto date_time = dateTimeFromSeconds(time_zone->toLocal(seconds));
+        char buf[48];
+        const int written = std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
+            date_time.year, date_time.month, date_time.day, date_time.hour, date_time.minute, date_time.second);
+        if (precision > 0)
+            std::snprintf(buf + written, sizeof(buf) - written, ".%0*lld", static_cast<int>(precision), static_cast<long long>(fraction));
+
+        appendMaybeQuoted(out, buf, quoted);
+    }
+
+private:
+    const std::size_t precision;
+    const std::shared_ptr<const TimeZone> time_zone;
+    int64_t scale = 1;
+};
+
+class BigIntDecoder : public ValueDecoder {
+public:
+    BigIntDecoder(std::size_t size_, bool is_signed_) : size(size_), is_signed(is_signed_) {}
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        out += bigIntToString(in.readRaw(size), size, is_signed);
+    }
+
+private:
+    const std::size_t size;
+    const bool is_signed;
+};
+
+class DecimalDecoder : public ValueDecoder {
+public:
+    DecimalDecoder(std::size_t size_, std::size_t scale_) : size(size_), scale(scale_) {}
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        auto digits = bigIntToString(in.readRaw(size), size, true);
+
+        const bool negative = (!digits.empty() && digits[0] == '-');
+        if (negative)
+            digits.erase(0, 1);
+
+        if (scale > 0) {
+            if (digits.size() <= scale)
+                digits.insert(0, scale - digits.size() + 1, '0');
+            digits.insert(digits.size() - scale, 1, '.');
+
+            // Trailing zeros are not printed by the server by default.
+            while (digits.back() == '0')
+                digits.pop_back();
+            if (digits.back() == '.')
+                digits.pop_back();
+        }
+
+        if (negative && digits != "0")
+            out += '-';
+        out += digits;
+    }
+
+private:
+    const std::size_t size;
+    const std::size_t scale;
+};
+
+class UUIDDecoder : public ValueDecoder {
+public:
+    virtual std::size_t getDisplaySize() const override {
+        return 36;
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        // Serialized as two little-endian UInt64, the high half first.
+        uint64_t halves[2] = {};
+        std::memcpy(halves, in.readRaw(sizeof(halves)), sizeof(halves));
+
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "%08x-%04x-%04x-%04x-%012llx",
+            static_cast<unsigned>(halves[0] >> 32),
+            static_cast<unsigned>((halves[0] >> 16) & 0xFFFF),
+            static_cast<unsigned>(halves[0] & 0xFFFF),
+            static_cast<unsigned>(halves[1] >> 48),
+            static_cast<unsigned long long>(halves[1] & 0xFFFFFFFFFFFFull));
+        appendMaybeQuoted(out, buf, quoted);
+    }
+};
+
+class IPv4Decoder : public ValueDecoder {
+public:
+    virtual std::size_t getDisplaySize() const override {
+        return 15;
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        uint32_t value = 0;
+        std::memcpy(&value, in.readRaw(sizeof(value)), sizeof(value));
+
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "%u.%u.%u.%u", value >> 24, (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF);
+        appendMaybeQuoted(out, buf, quoted);
+    }
+};
+
+class IPv6Decoder : public ValueDecoder {
+public:
+    virtual std::size_t getDisplaySize() const override {
+        return 39;
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        const auto * bytes = reinterpret_cast<const unsigned char *>(in.readRaw(16));
+
+        uint16_t groups[8] = {};
+        for (std::size_t i = 0; i < 8; ++i)
+            groups[i] = static_cast<uint16_t>((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+
+        // The longest run of at least two zero groups is replaced by "::".
+        std::size_t best_begin = 8;
+        std::size_t best_length = 0;
+        for (std::size_t i = 0; i < 8;) {
+            std::size_t j = i;
+            while (j < 8 && groups[j] == 0)
+                ++j;
+            if (j - i > best_length && j - i >= 2) {
+                best_begin = i;
+                best_length = j - i;
+            }
+            i = (j == i ? i + 1 : j);
+        }
+
+        std::string text;
+        char buf[8];
+        const bool ipv4_mapped = (best_begin == 0 && best_length == 5 && groups[5] == 0xFFFF);
+
+        for (std::size_t i = 0; i < (ipv4_mapped ? 6 : 8); ++i) {
+            if (i == best_begin) {
+                text += "::";
+                i += best_length - 1;
+                continue;
+            }
+            if (!text.empty() && text.back() != ':')
+                text += ':';
+            std::snprintf(buf, sizeof(buf), "%x", groups[i]);
+            text += buf;
+        }
+
+        if (ipv4_mapped) {
+            char ipv4[16];
+            std::snprintf(ipv4, sizeof(ipv4), ":%u.%u.%u.%u", bytes[12], bytes[13], bytes[14], bytes[15]);
+            text += ipv4;
+        }
+
+        appendMaybeQuoted(out, text, quoted);
+    }
+};
+
+template <typename T>
+class EnumDecoder : public ValueDecoder {
+public:
+    explicit EnumDecoder(const std::vector<std::string> & elements) {
+        // Elements look like 'name' = value.
+        for (const auto & element : elements) {
+            const auto eq = element.find_last_of('=');
+            if (eq == std::string::npos)
+                throw std::runtime_error("Cannot parse Enum element " + element);
+
+            auto name = trim(element.substr(0, eq));
+            if (name.size() < 2 || name.front() != '\'' || name.back() != '\'')
+                throw std::runtime_error("Cannot parse Enum element " + element);
+
+            std::string unescaped;
+            for (std::size_t i = 1; i + 1 < name.size(); ++i) {
+                if (name[i] == '\\' && i + 2 < name.size())
+                    ++i;
+                unescaped += name[i];
+            }
+
+            names[static_cast<T>(std::stol(trim(element.substr(eq + 1))))] = unescaped;
+        }
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        T value = 0;
+        std::memcpy(&value, in.readRaw(sizeof(value)), sizeof(value));
+
+        const auto it = names.find(value);
+        if (it == names.end())
+            out += std::to_string(value);
+        else
+            appendMaybeQuoted(out, it->second, quoted);
+    }
+
+private:
+    std::map<T, std::string> names;
+};
+
+class NullableDecoder : public ValueDecoder {
+public:
+    explicit NullableDecoder(ValueDecoderPtr && nested_) : nested(std::move(nested_)) {}
+
+    virtual ValueEncoding getEncoding() const override {
+        return nested->getEncoding();
+    }
+
+    virtual std::size_t getDisplaySize() const override {
+        return nested->getDisplaySize();
+    }
+
+    virtual void decodeTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx) override {
+        if (*in.readRaw(1))
+            batch.appendValue(column_idx, "", 0, true);
+        else
+            nested->decodeTo(in, batch, column_idx);
+    }
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        if (*in.readRaw(1))
+            out += "NULL";
+        else
+            nested->decodeAsText(in, out, quoted);
+    }
+
+    /// In Native, the null map of the whole column comes first, then the nested column, with default values in place of nulls.
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) override {
+        const auto first_row_idx = batch.getNumRows();
+
+        readValues(in, null_map, num_rows);
+        nested->decodeColumnTo(in, batch, column_idx, num_rows);
+
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            if (null_map[i])
+                batch.setNull(column_idx, first_row_idx + i);
+        }
+    }
+
+    virtual void decodeColumnAsText(BufferedReader & in, std::vector<std::string> & out, std::size_t num_rows, bool quoted) override {
+        const auto first_idx = out.size();
+
+        readValues(in, null_map, num_rows);
+        nested->decodeColumnAsText(in, out, num_rows, quoted);
+
+        for (std::size_t i = 0; i < num_rows; ++i) {
+            if (null_map[i])
+                out[first_idx + i] = "NULL";
+        }
+    }
+
+private:
+    ValueDecoderPtr nested;
+    std::vector<char> null_map;
+};
+
+class ArrayDecoder : public ValueDecoder {
+public:
+    explicit ArrayDecoder(ValueDecoderPtr && nested_) : nested(std::move(nested_)) {}
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        const auto size = in.readVarUInt();
+        out += '[';
+        for (uint64_t i = 0; i < size; ++i) {
+            if (i > 0)
+                out += ',';
+            nested->decodeAsText(in, out, true);
+        }
+        out += ']';
+    }
+
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) override {
+        decodeColumnToAsText(in, batch, column_idx, num_rows);
+    }
+
+    /// In Native, the end offsets of all the arrays of the column come first, then all their elements as a single column.
+    virtual void decodeColumnAsText(BufferedReader & in, std::vector<std::string> & out, std::size_t num_rows, bool quoted) override {
+        std::vector<uint64_t> offsets;
+        readValues(in, offsets, num_rows);
+
+        std::vector<std::string> elements;
+        nested->decodeColumnAsText(in, elements, (num_rows ? offsets.back() : 0), true);
+
+        uint64_t begin = 0;
+        for (const auto end : offsets) {
+            std::string value = "[";
+            for (auto i = begin; i < end && i < elements.size(); ++i) {
+                if (i > begin)
+                    value += ',';
+                value += elements[i];
+            }
+            value += ']';
+            out.emplace_back(std::move(value));
+            begin = end;
+        }
+    }
+
+private:
+    ValueDecoderPtr nested;
+};
+
+class TupleDecoder : public ValueDecoder {
+public:
+    explicit TupleDecoder(std::vector<ValueDecoderPtr> && elements_) : elements(std::move(elements_)) {}
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        out += '(';
+        for (std::size_t i = 0; i < elements.size(); ++i) {
+            if (i > 0)
+                out += ',';
+            elements[i]->decodeAsText(in, out, true);
+        }
+        out += ')';
+    }
+
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) override {
+        decodeColumnToAsText(in, batch, column_idx, num_rows);
+    }
+
+    /// In Native, every element is a separate column.
+    virtual void decodeColumnAsText(BufferedReader & in, std::vector<std::string> & out, std::size_t num_rows, bool quoted) override {
+        std::vector<std::vector<std::string>> element_columns(elements.size());
+        for (std::size_t i = 0; i < elements.size(); ++i)
+            elements[i]->decodeColumnAsText(in, element_columns[i], num_rows, true);
+
+        for (std::size_t row = 0; row < num_rows; ++row) {
+            std::string value = "(";
+            for (std::size_t i = 0; i < elements.size(); ++i) {
+                if (i > 0)
+                    value += ',';
+                value += element_columns[i][row];
+            }
+            value += ')';
+            out.emplace_back(std::move(value));
+        }
+    }
+
+private:
+    std::vector<ValueDecoderPtr> elements;
+};
+
+class MapDecoder : public ValueDecoder {
+public:
+    MapDecoder(ValueDecoderPtr && key_, ValueDecoderPtr && value_) : key(std::move(key_)), value(std::move(value_)) {}
+
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) override {
+        const auto size = in.readVarUInt();
+        out += '{';
+        for (uint64_t i = 0; i < size; ++i) {
+            if (i > 0)
+                out += ',';
+            key->decodeAsText(in, out, true);
+            out += ':';
+            value->decodeAsText(in, out, true);
+        }
+        out += '}';
+    }
+
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) override {
+        decodeColumnToAsText(in, batch, column_idx, num_rows);
+    }
+
+    /// In Native, a map is serialized as Array(Tuple(key, value)): offsets, then the column of keys, then the column of values.
+    virtual void decodeColumnAsText(BufferedReader & in, std::vector<std::string> & out, std::size_t num_rows, bool quoted) override {
+        std::vector<uint64_t> offsets;
+        readValues(in, offsets, num_rows);
+
+        const auto num_elements = (num_rows ? offsets.back() : 0);
+        std::vector<std::string> keys;
+        std::vector<std::string> values;
+        key->decodeColumnAsText(in, keys, num_elements, true);
+        value->decodeColumnAsText(in, values, num_elements, true);
+
+        uint64_t begin = 0;
+        for (const auto end : offsets) {
+            std::string text = "{";
+            for (auto i = begin; i < end && i < keys.size(); ++i) {
+                if (i > begin)
+                    text += ',';
+                text += keys[i];
+                text += ':';
+                text += values[i];
+            }
+            text += '}';
+            out.emplace_back(std::move(text));
+            begin = end;
+        }
+    }
+
+private:
+    ValueDecoderPtr key;
+    ValueDecoderPtr value;
+};
+
+} // namespace
+
+void ValueDecoder::decodeTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx) {
+    text.clear();
+    decodeAsText(in, text, false);
+    batch.appendValue(column_idx, text.data(), text.size(), false);
+}
+
+void ValueDecoder::decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) {
+    // Values of simple types are serialized in Native one after another, just like in RowBinary.
+    for (std::size_t i = 0; i < num_rows; ++i)
+        decodeTo(in, batch, column_idx);
+}
+
+void ValueDecoder::decodeColumnAsText(BufferedReader & in, std::vector<std::string> & out, std::size_t num_rows, bool quoted) {
+    for (std::size_t i = 0; i < num_rows; ++i) {
+        out.emplace_back();
+        decodeAsText(in, out.back(), quoted);
+    }
+}
+
+void ValueDecoder::decodeColumnToAsText(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows) {
+    texts.clear();
+    decodeColumnAsText(in, texts, num_rows, false);
+    for (const auto & value : texts)
+        batch.appendValue(column_idx, value.data(), value.size(), false);
+}
+
+ValueDecoderPtr makeValueDecoder(const std::string & type, const std::string & server_time_zone) {
+    const auto type_name = splitTypeName(type);
+    const auto & name = type_name.name;
+    const auto & args = type_name.arguments;
+
+    if (name == "Nullable" && args.size() == 1)
+        return std::make_unique<NullableDecoder>(makeValueDecoder(args[0], server_time_zone));
+
+    // These have the same binary representation as the nested type.
+    if (name == "LowCardinality" && args.size() == 1)
+        return makeValueDecoder(args[0], server_time_zone);
+    if (name == "SimpleAggregateFunction" && args.size() == 2)
+        return makeValueDecoder(args[1], server_time_zone);
+
+    if (name == "Array" && args.size() == 1)
+        return std::make_unique<ArrayDecoder>(makeValueDecoder(args[0], server_time_zone));
+
+    if (name == "Tuple" && !args.empty()) {
+        std::vector<ValueDecoderPtr> elements;
+        for (const auto & arg : args)
+            elements.emplace_back(makeValueDecoder(stripElementName(arg), server_time_zone));
+        return std::make_unique<TupleDecoder>(std::move(elements));
+    }
+
+    if (name == "Map" && args.size() == 2)
+        return std::make_unique<MapDecoder>(makeValueDecoder(args[0], server_time_zone), makeValueDecoder(args[1], server_time_zone));
+
+    if (name == "Int8")     return std::make_unique<FixedWidthDecoder<int8_t, ValueEncoding::Int8, 4>>();
+    if (name == "Int16")    return std::make_unique<FixedWidthDecoder<int16_t, ValueEncoding::Int16, 6>>();
+    if (name == "Int32")    return std::make_unique<FixedWidthDecoder<int32_t, ValueEncoding::Int32, 11>>();
+    if (name == "Int64")    return std::make_unique<FixedWidthDecoder<int64_t, ValueEncoding::Int64, 20>>();
+    if (name == "UInt8")    return std::make_unique<FixedWidthDecoder<uint8_t, ValueEncoding::UInt8, 3>>();
+    if (name == "UInt16")   return std::make_unique<FixedWidthDecoder<uint16_t, ValueEncoding::UInt16, 5>>();
+    if (name == "UInt32")   return std::make_unique<FixedWidthDecoder<uint32_t, ValueEncoding::UInt32, 10>>();
+    if (name == "UInt64")   return std::make_unique<FixedWidthDecoder<uint64_t, ValueEncoding::UInt64, 20>>();
+    if (name == "Float32")  return std::make_unique<FixedWidthDecoder<float, ValueEncoding::Float32, 15>>();
+    if (name == "Float64")  return std::make_unique<FixedWidthDecoder<double, ValueEncoding::Float64, 24>>();
+    if (name == "Date")     return std::make_unique<FixedWidthDecoder<uint16_t, ValueEncoding::Date, 10>>();
+
+    if (name == "Int128")  return std::make_unique<BigIntDecoder>(16, true);
+    if (name == "UInt128") return std::make_unique<BigIntDecoder>(16, false);
+    if (name == "Int256")  return std::make_unique<BigIntDecoder>(32, true);
+    if (name == "UInt256") return std::make_unique<BigIntDecoder>(32, false);
+
+    if (name == "Decimal") {
+        const auto precision = getArgumentAsSize(type_name, 0);
+        const auto scale = getArgumentAsSize(type_name, 1);
+        const std::size_t size = (precision <= 9 ? 4 : precision <= 18 ? 8 : precision <= 38 ? 16 : 32);
+        return std::make_unique<DecimalDecoder>(size, scale);
+    }
+    if (name == "Decimal32")  return std::make_unique<DecimalDecoder>(4, getArgumentAsSize(type_name, 0));
+    if (name == "Decimal64")  return std::make_unique<DecimalDecoder>(8, getArgumentAsSize(type_name, 0));
+    if (name == "Decimal128") return std::make_unique<DecimalDecoder>(16, getArgumentAsSize(type_name, 0));
+    if (name == "Decimal256") return std::make_unique<DecimalDecoder>(32, getArgumentAsSize(type_name, 0));
+
+    if (name == "Bool")        return std::make_unique<BoolDecoder>();
+    if (name == "Nothing")     return std::make_unique<NothingDecoder>();
+    if (name == "String")      return std::make_unique<StringDecoder>();
+    if (name == "FixedString") return std::make_unique<FixedStringDecoder>(getArgumentAsSize(type_name, 0));
+    if (name == "Date32")      return std::make_unique<Date32Decoder>();
+    if (name == "DateTime")    return std::make_unique<DateTimeDecoder>(getTimeZone(type_name, 0, server_time_zone));
+    if (name == "DateTime64")  return std::make_unique<DateTime64Decoder>(getArgumentAsSize(type_name, 0), getTimeZone(type_name, 1, server_time_zone));
+    if (name == "UUID")        return std::make_unique<UUIDDecoder>();
+    if (name == "IPv4")        return std::make_unique<IPv4Decoder>();
+    if (name == "IPv6")        return std::make_unique<IPv6Decoder>();
+    if (name == "Enum8")       return std::make_unique<EnumDecoder<int8_t>>(args);
+    if (name == "Enum16")      return std::make_unique<EnumDecoder<int16_t>>(args);
+
+    throw std::runtime_error("Type " + type + " is not supported in binary result formats");
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "read_helpers.h"
+#include "result_set.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Decodes values of a column of the RowBinary family of formats, for the type of the column.
+/// Fixed-width numbers and Date are stored in batches as they are, DateTime as the wall-clock time of its time zone,
+/// everything else is converted to the same text representation the server uses in text formats.
+class ValueDecoder {
+public:
+    virtual ~ValueDecoder() = default;
+
+    /// How values are stored in batches.
+    virtual ValueEncoding getEncoding() const {
+        return ValueEncoding::Text;
+    }
+
+    /// Max length of the text representation of a value, if it doesn't depend on the data, otherwise 0.
+    virtual std::size_t getDisplaySize() const {
+        return 0;
+    }
+
+    /// Read a single value and append it to the column of the batch.
+    virtual void decodeTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx);
+
+    /// Read a single value and append its text representation to the string.
+    /// Quoted representation is used for the elements of arrays, tuples and maps.
+    virtual void decodeAsText(BufferedReader & in, std::string & out, bool quoted) = 0;
+
+    /// Read the values of 'num_rows' rows of a column of the Native format and append them to the column of the batch.
+    virtual void decodeColumnTo(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows);
+
+    /// Read the values of 'num_rows' rows of a column of the Native format and append their text representations to 'out'.
+    virtual void decodeColumnAsText(BufferedReader & in, std::vector<std::string> & out, std::size_t num_rows, bool quoted);
+
+protected:
+    /// For types that only have a text representation, but are serialized column-wise in the Native format.
+    void decodeColumnToAsText(BufferedReader & in, ColumnBatch & batch, std::size_t column_idx, std::size_t num_rows);
+
+private:
+    std::string text;
+    std::vector<std::string> texts;
+};
+
+using ValueDecoderPtr = std::unique_ptr<ValueDecoder>;
+
+/// Throws if there is no decoder for the type, or its time zone is unknown.
+/// DateTime and DateTime64 types without a time zone are in 'server_time_zone', or in UTC if it is empty.
+ValueDecoderPtr makeValueDecoder(const std::string & type, const std::string & server_time_zone);